@@ -1,21 +1,38 @@
 #version 450 core
 
-// layout(push_constant) uniform PushConstants {
-//     mat4 viewProjection;
-// } pc;
-
 layout(binding = 0) uniform UniformBufferObject {
     mat4 viewProjection;
-    mat4 transform;
 } ubo;
 
+// Per-draw constants, compiled with DRAW_CONSTANTS_UNIFORM_BUFFER when the block exceeds
+// the device's push constant limit and read from a dynamic uniform buffer instead
+#ifdef DRAW_CONSTANTS_UNIFORM_BUFFER
+layout(set = 1, binding = 0) uniform DrawConstants {
+#else
+layout(push_constant) uniform DrawConstants {
+#endif
+    mat4 transform;
+    // Dequantization of the mesh's unorm16 positions, see VertexQuantization
+    vec4 position_offset;
+    vec4 position_scale;
+} draw;
+
+// Mesh streams of the geometry pool, one binding per attribute, stored packed
+#pragma vertex_format 0 R16G16B16A16_UNORM
 layout(location = 0) in vec3 a_position;
+#pragma vertex_format 1 R8G8B8A8_UNORM
+#pragma vertex_binding 1 1
 layout(location = 1) in vec3 a_color;
 
+// Per-instance transform, one location per column, binding 2 advances once per instance
+#pragma vertex_binding 2 2 instance
+layout(location = 2) in mat4 i_transform;
+
 layout(location = 0) out vec3 v_color;
 
 void main()
 {
-    gl_Position = ubo.viewProjection * ubo.transform * vec4(a_position, 1.0);
+    vec3 position = draw.position_offset.xyz + a_position * draw.position_scale.xyz;
+    gl_Position = ubo.viewProjection * draw.transform * i_transform * vec4(position, 1.0);
     v_color = a_color;
 }
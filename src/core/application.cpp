@@ -10,19 +10,78 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <stdexcept>
 #include <thread>
 #include <unordered_map>
 
 #include "logger.hpp"
 
+#include "renderer/geometry_pool.hpp"
+#include "renderer/instance_batcher.hpp"
+#include "renderer/mesh.hpp"
+#include "renderer/mesh_archive.hpp"
+#include "renderer/render_queue.hpp"
+
 #include "vulkan/buffers.hpp"
 #include "vulkan/command_buffer.hpp"
 #include "vulkan/graphics_pipeline.hpp"
+#include "vulkan/parallel_command_recorder.hpp"
 #include "vulkan/shader.hpp"
+#include "vulkan/shader_library.hpp"
 
 #include "vulkan/vulkan_context.hpp"
 #include "vulkan/vulkan_wrapper.hpp"
 
+// Instances of all instanced draws in a frame
+static constexpr u32 MAX_INSTANCE_COUNT = 16384;
+
+// GPU culled draws are grouped by the index type of their geometry
+static constexpr u32 CULL_GROUP_COUNT = 2;
+
+// Capacity of the geometry pool every mesh lives in
+static constexpr u32 MAX_GEOMETRY_VERTEX_COUNT = 1024 * 1024;
+static constexpr u32 MAX_GEOMETRY_INDEX_COUNT = 4 * 1024 * 1024;
+
+// Draw constants that do not fit in push constants are compiled with this macro and read from
+// a dynamic uniform buffer at this set
+static constexpr const char *DRAW_CONSTANTS_UNIFORM_BUFFER_MACRO = "DRAW_CONSTANTS_UNIFORM_BUFFER";
+static constexpr u32 DRAW_CONSTANTS_SET = 1;
+static constexpr VkDeviceSize DRAW_CONSTANT_BUFFER_SIZE = 4 * 1024 * 1024;
+
+// Whether the cooked archive should be loaded instead of compiling. Without a runtime compiler
+// the archive is the only source of shaders, so it is current whenever it exists. With one, an
+// archive older than any source would hide local edits, the sources are compiled instead.
+static bool is_shader_archive_current(const std::filesystem::path &archive_path, const std::filesystem::path &source_directory)
+{
+    std::error_code ec;
+    if (!std::filesystem::exists(archive_path, ec))
+        return false;
+
+#ifdef SHADER_RUNTIME_COMPILER
+    const auto archive_time = std::filesystem::last_write_time(archive_path, ec);
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(source_directory, ec))
+    {
+        if (entry.is_regular_file() && entry.last_write_time(ec) > archive_time)
+        {
+            Logger::get_instance().push_message(LoggingLevel::Warning, "[Shader] {} is older than {}, compiling shaders instead",
+                archive_path.string(), entry.path().string());
+            return false;
+        }
+    }
+#endif
+    return true;
+}
+
+// The default pipeline cannot be built without its shaders, only hot reload keeps an old module
+static void require_valid_shader(const Ref<Shader> &shader)
+{
+    if (shader->is_valid())
+        return;
+
+    Logger::get_instance().push_message(LoggingLevel::Error, "[Renderer] Failed to load shader {}", shader->get_filepath().string());
+    throw std::runtime_error("[Renderer] Failed to load shader " + shader->get_filepath().string());
+}
+
 Application::Application(i32 argc, char **argv)
 {
     m_Window = CreateScope<Window>(1024, 720, "Vulkan Engine");
@@ -37,6 +96,74 @@ Application::Application(i32 argc, char **argv)
     m_Vk = m_Window->get_vk_context();
 
     m_CommandBuffer = CommandBuffer::create();
+    m_CommandRecorder = CreateScope<ParallelCommandRecorder>();
+    m_RenderQueue = CreateScope<RenderQueue>();
+    m_InstanceBatcher = CreateScope<InstanceBatcher>(static_cast<u32>(sizeof(glm::mat4)));
+    m_GeometryPool = CreateScope<GeometryPool>(MESH_STREAM_STRIDES, MAX_GEOMETRY_VERTEX_COUNT, MAX_GEOMETRY_INDEX_COUNT);
+
+    MeshData quad;
+    quad.name = "quad";
+    quad.positions =
+    {
+        // Clockwise winding
+        { -0.5f, -0.5f, 0.0f },
+        { -0.5f,  0.5f, 0.0f },
+        {  0.5f,  0.5f, 0.0f },
+        {  0.5f, -0.5f, 0.0f }
+    };
+
+    quad.colors =
+    {
+        { 0.0f, 0.0f, 1.0f },
+        { 1.0f, 0.0f, 0.0f },
+        { 0.0f, 1.0f, 0.0f },
+        { 0.0f, 1.0f, 0.0f }
+    };
+
+    quad.indices =
+    {
+        0, 1, 2,
+        0, 2, 3
+    };
+
+    m_QuadMesh = Mesh::create(*m_GeometryPool, quad);
+    m_GeometryPool->flush();
+
+    // A mesh file on the command line is drawn next to the quad, cooked archives (see
+    // tools/mesh_cooker) are copied into the pool as they are, sources are imported
+    if (argc > 1 && std::filesystem::path(argv[1]).extension() == ".mesh")
+    {
+        MeshArchive archive;
+        if (archive.open(argv[1]))
+        {
+            for (u32 i = 0; i < archive.get_mesh_count(); ++i)
+            {
+                if (Ref<Mesh> mesh = Mesh::create(*m_GeometryPool, archive, i))
+                    m_ImportedMeshes.push_back(mesh);
+            }
+            m_GeometryPool->flush();
+        }
+    }
+    else if (argc > 1)
+    {
+        GeometryPoolImportSink sink(*m_GeometryPool);
+        MeshImporter().import(argv[1], sink);
+        for (const Ref<Mesh> &mesh : sink.get_meshes())
+        {
+            if (mesh)
+                m_ImportedMeshes.push_back(mesh);
+        }
+    }
+
+    m_ShaderLibrary = CreateScope<ShaderLibrary>();
+    if (is_shader_archive_current("res/shaders.pak", "res/shaders"))
+    {
+        // Cooked shaders skip compilation and reflection entirely
+        m_ShaderLibrary->mount_archive("res/shaders.pak");
+    }
+#ifdef SHADER_RUNTIME_COMPILER
+    m_ShaderLibrary->enable_hot_reload("res/shaders");
+#endif
 
     glm::vec2 size = { static_cast<float>(m_Window->get_window_width()), static_cast<float>(m_Window->get_window_height())};
 
@@ -44,6 +171,16 @@ Application::Application(i32 argc, char **argv)
     m_Camera.set_position(glm::vec3(0.0f, 0.0f, 5.0f)).update_view_matrix();
 
     create_graphics_pipeline();
+
+    const Ref<Shader> cull_shader = m_ShaderLibrary->load("res/shaders/cull.comp", VK_SHADER_STAGE_COMPUTE_BIT, GpuCulling::get_shader_macros());
+    if (cull_shader->is_valid())
+    {
+        m_Culling = CreateScope<GpuCulling>(cull_shader, MAX_INSTANCE_COUNT, CULL_GROUP_COUNT);
+    }
+    else
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[Renderer] Culling shader failed to load, meshes are drawn without GPU culling");
+    }
 }
 
 Application::~Application()
@@ -56,14 +193,30 @@ Application::~Application()
         m_Pipeline->destroy();
     }
 
-    if (m_VertexBuffer)
+    if (m_Culling)
     {
-        m_VertexBuffer->destroy();
+        m_Culling->destroy();
     }
 
-    if (m_IndexBuffer)
+    if (m_ShaderLibrary)
     {
-        m_IndexBuffer->destroy();
+        m_ShaderLibrary->destroy();
+        m_ShaderLibrary.reset();
+    }
+
+    if (m_QuadMesh)
+    {
+        m_QuadMesh->destroy();
+    }
+
+    for (const Ref<Mesh> &mesh : m_ImportedMeshes)
+    {
+        mesh->destroy();
+    }
+
+    if (m_GeometryPool)
+    {
+        m_GeometryPool->destroy();
     }
 
     if (m_UniformBuffer)
@@ -71,6 +224,21 @@ Application::~Application()
         m_UniformBuffer->destroy();
     }
 
+    if (m_IndirectBuffer)
+    {
+        m_IndirectBuffer->destroy();
+    }
+
+    if (m_InstanceBuffer)
+    {
+        m_InstanceBuffer->destroy();
+    }
+
+    if (m_DrawConstantBuffer)
+    {
+        m_DrawConstantBuffer->destroy();
+    }
+
     for (auto layout : m_DescLayouts)
     {
         vkDestroyDescriptorSetLayout(device, layout, VK_NULL_HANDLE);
@@ -81,6 +249,11 @@ Application::~Application()
         m_CommandBuffer->destroy();
     }
 
+    if (m_CommandRecorder)
+    {
+        m_CommandRecorder->destroy();
+    }
+
     imgui_shutdown();
 }
 
@@ -94,13 +267,20 @@ void Application::run()
         {            
             if (auto frame_index = m_Vk->begin_frame())
             {
+                m_ShaderLibrary->update();
+
                 imgui_begin();
                 ImGui::ShowDemoWindow();
                 ImGui::Begin("Settings");
                 ImGui::ColorEdit4("clear color", &m_ClearColor[0]);
+                ImGui::Text("Binds: %u issued, %u skipped", m_BindStats.bind_calls, m_BindStats.skipped_binds);
+                if (m_Culling)
+                    ImGui::Checkbox("GPU culling", &m_GpuCullingEnabled);
                 ImGui::End();
                 imgui_end();
 
+                m_CommandRecorder->begin_frame();
+
                 VkFramebuffer framebuffer = m_Vk->get_framebuffer(*frame_index);
                 record_frame(framebuffer, *frame_index);
 
@@ -151,7 +331,7 @@ void Application::on_update(double delta_time)
     static float y_rot = 0.0f;
     y_rot += delta_time;
 
-    m_UboData.transform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f)) * glm::rotate(glm::mat4(1.0f), y_rot, glm::vec3(0.0f, 1.0f, 0.0f));
+    m_DrawConstants.transform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f)) * glm::rotate(glm::mat4(1.0f), y_rot, glm::vec3(0.0f, 1.0f, 0.0f));
     m_UboData.viewProjection = m_Camera.get_view_projection_matrix();
 }
 
@@ -177,60 +357,90 @@ void Application::create_graphics_pipeline()
     
     m_DescLayouts.clear();
 
-    const Ref<Shader> vertex_shader = CreateRef<Shader>("res/shaders/default.vert", VK_SHADER_STAGE_VERTEX_BIT);
-    const Ref<Shader> fragment_shader = CreateRef<Shader>("res/shaders/default.frag", VK_SHADER_STAGE_FRAGMENT_BIT);
+    const std::vector<Ref<Shader>> shaders = m_ShaderLibrary->load_batch({
+        { "res/shaders/default.vert", VK_SHADER_STAGE_VERTEX_BIT },
+        { "res/shaders/default.frag", VK_SHADER_STAGE_FRAGMENT_BIT },
+    });
+    for (const Ref<Shader> &shader : shaders)
+        require_valid_shader(shader);
+    Ref<Shader> vertex_shader = shaders[0];
+    const Ref<Shader> &fragment_shader = shaders[1];
+
+    // Push constants are guaranteed up to 128 bytes, larger draw constants go through a dynamic uniform buffer
+    VkPushConstantRange push_range = merge_push_constant_ranges({ vertex_shader, fragment_shader });
+    const bool draw_constants_in_buffer = push_range.offset + push_range.size > m_Vk->get_device_limits().maxPushConstantsSize;
+    if (draw_constants_in_buffer)
+    {
+        Logger::get_instance().push_message(LoggingLevel::Info, "[Renderer] {} bytes of draw constants exceed the push constant limit",
+            push_range.size);
+        vertex_shader = m_ShaderLibrary->load("res/shaders/default.vert", VK_SHADER_STAGE_VERTEX_BIT, { { DRAW_CONSTANTS_UNIFORM_BUFFER_MACRO, "1" } });
+        require_valid_shader(vertex_shader);
+        push_range = merge_push_constant_ranges({ vertex_shader, fragment_shader });
+    }
 
     if (m_UniformBuffer)
     {
         m_UniformBuffer->destroy();
     }
-    m_UniformBuffer = UniformBuffer::create(sizeof(UniformBufferData), 0);
 
-    std::vector<Vertex> vertices =
+    if (m_IndirectBuffer)
     {
-        // Position, Color (clockwise winding)
-        {{ -0.5f, -0.5f, 0.0f }, {0.0f, 0.0f, 1.0f}},
-        {{ -0.5f,  0.5f, 0.0f }, {1.0f, 0.0f, 0.0f}},
-        {{  0.5f,  0.5f, 0.0f }, {0.0f, 1.0f, 0.0f}},
-        {{  0.5f, -0.5f, 0.0f }, {0.0f, 1.0f, 0.0f}}
-    };
+        m_IndirectBuffer->destroy();
+        m_IndirectBuffer.reset();
+    }
 
-    std::vector<uint32_t> indices = 
+    if (m_InstanceBuffer)
     {
-        0, 1, 2,
-        0, 2, 3
-    };
+        m_InstanceBuffer->destroy();
+    }
 
-    VkDeviceSize buffer_size = sizeof(vertices[0]) * vertices.size();
-    m_VertexBuffer = VertexBuffer::create(vertices.data(), buffer_size);
-    m_IndexBuffer = IndexBuffer::create(indices);
+    if (m_DrawConstantBuffer)
+    {
+        m_DrawConstantBuffer->destroy();
+        m_DrawConstantBuffer.reset();
+    }
+    m_UniformBuffer = UniformBuffer::create(sizeof(UniformBufferData), 0);
+    m_InstanceBuffer = InstanceBuffer::create(m_InstanceBatcher->get_instance_stride(), MAX_INSTANCE_COUNT);
 
-    // Build vertex input state from reflection if available; fallback to hardcoded Vertex layout
-    VkVertexInputBindingDescription binding_desc = {};
+
+    // Build vertex input state from reflection if available; fallback to the mesh streams and instance transform
+    std::vector<VkVertexInputBindingDescription> binding_desc;
     std::vector<VkVertexInputAttributeDescription> attr_desc;
     const auto& reflected_attrs = vertex_shader->get_vertex_attributes();
     if (!reflected_attrs.empty())
     {
-        binding_desc.binding = 0;
-        binding_desc.stride = vertex_shader->get_vertex_stride();
-        binding_desc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        binding_desc = vertex_shader->get_vertex_bindings(); // copy
         attr_desc = reflected_attrs; // copy
     }
     else
     {
-        binding_desc.binding = 0;
-        binding_desc.stride = sizeof(Vertex);
-        binding_desc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-        attr_desc.resize(2);
+        binding_desc.resize(3);
+        binding_desc[0].binding = 0;
+        binding_desc[0].stride = MESH_STREAM_STRIDES[MESH_STREAM_POSITION];
+        binding_desc[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        binding_desc[1].binding = 1;
+        binding_desc[1].stride = MESH_STREAM_STRIDES[MESH_STREAM_COLOR];
+        binding_desc[1].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        binding_desc[2].binding = 2;
+        binding_desc[2].stride = sizeof(glm::mat4);
+        binding_desc[2].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+        attr_desc.resize(6);
         attr_desc[0].binding = 0;
         attr_desc[0].location = 0;
-        attr_desc[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attr_desc[0].offset = offsetof(Vertex, position);
-        attr_desc[1].binding = 0;
+        attr_desc[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+        attr_desc[0].offset = 0;
+        attr_desc[1].binding = 1;
         attr_desc[1].location = 1;
-        attr_desc[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attr_desc[1].offset = offsetof(Vertex, color);
+        attr_desc[1].format = VK_FORMAT_R8G8B8A8_UNORM;
+        attr_desc[1].offset = 0;
+        for (u32 column = 0; column < 4; ++column)
+        {
+            attr_desc[2 + column].binding = 2;
+            attr_desc[2 + column].location = 2 + column;
+            attr_desc[2 + column].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+            attr_desc[2 + column].offset = column * sizeof(glm::vec4);
+        }
     }
 
     // Merge descriptor set layouts from both shaders
@@ -264,6 +474,18 @@ void Application::create_graphics_pipeline()
     merge_sets(vertex_shader->get_descriptor_set_layout_bindings());
     merge_sets(fragment_shader->get_descriptor_set_layout_bindings());
 
+    // The draw constant block is read at a different offset for every draw
+    u32 draw_constants_size = 0;
+    if (draw_constants_in_buffer)
+    {
+        for (auto &binding : merged_sets[DRAW_CONSTANTS_SET])
+        {
+            if (binding.binding == 0 && binding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+                binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        }
+        draw_constants_size = static_cast<u32>(sizeof(DrawConstants));
+    }
+
     // Create VkDescriptorSetLayout(s)
     std::vector<std::pair<u32, VkDescriptorSetLayout>> set_layout_pairs;
     set_layout_pairs.reserve(merged_sets.size());
@@ -289,23 +511,10 @@ void Application::create_graphics_pipeline()
         m_DescLayouts.push_back(p.second);
     }
 
-    // Merge push constant ranges
-    std::vector<VkPushConstantRange> push_ranges = vertex_shader->get_push_constant_ranges();
-    for (const auto& pr : fragment_shader->get_push_constant_ranges())
-    {
-        bool merged = false;
-        for (auto& ex : push_ranges)
-        {
-            if (ex.offset == pr.offset && ex.size == pr.size)
-            {
-                ex.stageFlags |= pr.stageFlags;
-                merged = true;
-                break;
-            }
-        }
-        if (!merged)
-            push_ranges.push_back(pr);
-    }
+    // A single range visible to every stage that declares push constants
+    std::vector<VkPushConstantRange> push_ranges;
+    if (push_range.size > 0)
+        push_ranges.push_back(push_range);
 
     VkPipelineLayoutCreateInfo layout_create_info = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
@@ -321,19 +530,41 @@ void Application::create_graphics_pipeline()
     VK_ERROR_CHECK(result, "[Vulkan] Failed to create pipeline layout");
 
     GraphicsPipelineInfo pipeline_info {
-        .binding_description = binding_desc,
+        .binding_descriptions = binding_desc,
         .attribute_descriptions = attr_desc,  // This copies the vector
         .layout = pipeline_layout,
         .extent = VulkanContext::get()->get_swap_chain()->get_extent(),
         .render_pass = m_Vk->get_render_pass(),
+        .push_constant_ranges = push_ranges,
+        .attachment_formats = { m_Vk->get_swap_chain()->get_format().format },
     };
+    for (const auto &[set_index, set_layout] : set_layout_pairs)
+        pipeline_info.set_layout_bindings.push_back(merged_sets[set_index]);
 
     m_Pipeline = CreateRef<GraphicsPipeline>();
     m_Pipeline->add_shader(vertex_shader)
         .add_shader(fragment_shader)
         .build(pipeline_info);
+    m_ShaderLibrary->add_dependent(m_Pipeline);
 
     m_UniformBuffer->create_descriptor_set(&m_DescLayouts.front());
+
+    m_DrawConstantLayout = {};
+    if (draw_constants_in_buffer)
+    {
+        auto layout = std::find_if(set_layout_pairs.begin(), set_layout_pairs.end(), [](const auto &p) { return p.first == DRAW_CONSTANTS_SET; });
+        ASSERT(layout != set_layout_pairs.end(), "[Renderer] Draw constants fallback without a descriptor set");
+
+        m_DrawConstantBuffer = DynamicUniformBuffer::create(DRAW_CONSTANT_BUFFER_SIZE, draw_constants_size);
+        m_DrawConstantBuffer->create_descriptor_set(layout->second);
+        m_DrawConstantLayout.uniform_buffer = m_DrawConstantBuffer.get();
+        m_DrawConstantLayout.set = DRAW_CONSTANTS_SET;
+    }
+    else
+    {
+        m_DrawConstantLayout.stages = push_range.stageFlags;
+        m_DrawConstantLayout.offset = push_range.offset;
+    }
 }
 
 void Application::record_frame(VkFramebuffer framebuffer, uint32_t frame_index)
@@ -361,37 +592,166 @@ void Application::record_frame(VkFramebuffer framebuffer, uint32_t frame_index)
     m_CommandBuffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
     VkCommandBuffer command_buffer = m_CommandBuffer->get_active_handle();
 
-    // const glm::mat4 &view_projection = m_Camera.get_view_projection_matrix();
-    // m_CommandBuffer->set_push_constants(VK_SHADER_STAGE_VERTEX_BIT, m_Pipeline->get_layout(), &view_projection, sizeof(glm::mat4));
-
     m_UniformBuffer->set_data(&m_UboData, sizeof(m_UboData));
     
-    GraphicsState state;
-    state.pipeline = m_Pipeline->get_handle();
-    state.pipeline_layout = m_Pipeline->get_layout();
-    state.framebuffer = framebuffer;
-    state.render_pass = m_Vk->get_render_pass();
-    state.scissor = scissor;
-    state.viewport = viewport;
-    state.clear_value = clear_value;
-    state.descriptor_sets = { m_UniformBuffer->get_descriptor_set() };
-    state.index_buffer = { m_IndexBuffer->get_buffer(), 0, VK_INDEX_TYPE_UINT32 };
-    state.vertex_buffers = { m_VertexBuffer->get_buffer() };
-    
-    m_CommandBuffer->set_graphics_state(state);
+    RenderPassState pass;
+    pass.render_pass = m_Vk->get_render_pass();
+    pass.framebuffer = framebuffer;
+    pass.render_area = scissor;
+    pass.clear_value = clear_value;
+
+    // Scene traversal only emits packets, sorting groups equal state before anything is recorded
+    m_RenderQueue->reset();
+    if (m_DrawConstantBuffer)
+        m_DrawConstantBuffer->reset();
+
+    const u32 pipeline = m_RenderQueue->add_pipeline({ m_Pipeline->get_handle(), m_Pipeline->get_layout(), m_DrawConstantLayout });
+    const u32 material = m_RenderQueue->add_material({ { m_UniformBuffer->get_descriptor_set() } });
+
+    // Every mesh shares the pool's buffers, draws only pick the geometry of their index type
+    u32 geometry_indices[2] = {};
+    for (VkIndexType index_type : { VK_INDEX_TYPE_UINT16, VK_INDEX_TYPE_UINT32 })
+    {
+        RenderGeometry geometry = m_GeometryPool->get_render_geometry({ MESH_STREAM_POSITION, MESH_STREAM_COLOR }, index_type);
+        geometry.vertex_buffers.push_back(m_InstanceBuffer->get_buffer());
+        geometry.vertex_offsets.push_back(0);
+        geometry_indices[index_type == VK_INDEX_TYPE_UINT32] = m_RenderQueue->add_geometry(geometry);
+    }
 
-    DrawArguments args;
-    args.vertex_count = m_IndexBuffer->get_count();
-    args.instance_count = 1;
-    m_CommandBuffer->draw_indexed(args);
+    // Every mesh of the scene once, placed within the scene transform
+    auto for_each_instance = [&](auto &&function)
+    {
+        function(*m_QuadMesh, glm::mat4(1.0f));
+        for (const Ref<Mesh> &mesh : m_ImportedMeshes)
+            function(*mesh, glm::mat4(1.0f));
+    };
+
+    bool gpu_culling = m_Culling && m_GpuCullingEnabled;
+    if (gpu_culling)
+    {
+        // Every instance becomes a cull object and the survivors of each index type one indirect
+        // count draw, so recording does not grow with the scene. Instances carry their mesh's
+        // decode, which lets every draw share the same constants.
+        m_CullObjects.clear();
+        m_CullInstances.clear();
+        for_each_instance([&](const Mesh &mesh, const glm::mat4 &instance_transform)
+        {
+            const glm::mat4 transform = m_DrawConstants.transform * instance_transform;
+            DrawPacket draw;
+            mesh.fill_draw(draw, mesh.select_lod(transform, m_Camera.get_position(), m_Camera.get_screen_scale()));
+
+            CullObject object;
+            object.bounding_sphere = transform_bounding_sphere(mesh.get_bounding_sphere(), instance_transform);
+            object.index_count = draw.index_count;
+            object.first_index = draw.first_index;
+            object.vertex_offset = draw.vertex_offset;
+            object.first_instance = static_cast<u32>(m_CullInstances.size());
+            object.group = mesh.get_index_type() == VK_INDEX_TYPE_UINT32;
+            m_CullObjects.push_back(object);
+            m_CullInstances.push_back(instance_transform * get_dequantization_matrix(mesh.get_quantization()));
+        });
+
+        gpu_culling = m_Culling->set_objects(m_CullObjects)
+            && m_InstanceBuffer->set_instances(m_CullInstances.data(), static_cast<u32>(m_CullInstances.size()));
+        if (gpu_culling)
+        {
+            DrawConstants constants = m_DrawConstants;
+            constants.quantization = {};
+            for (u32 group = 0; group < CULL_GROUP_COUNT; ++group)
+            {
+                if (m_Culling->get_group_object_count(group) == 0)
+                    continue;
+
+                DrawPacket packet;
+                packet.pipeline = pipeline;
+                packet.material = material;
+                packet.geometry = geometry_indices[group];
+                packet.sort_key = make_opaque_sort_key(0, pipeline, material, packet.geometry, 0.0f);
+                packet.indirect_draw = m_RenderQueue->add_indirect_draw(m_Culling->get_draw(group));
+                m_RenderQueue->get_draw_list(0).push(packet, constants);
+            }
+        }
+        else
+        {
+            Logger::get_instance().push_message(LoggingLevel::Warning, "[Renderer] {} instances exceed the culling capacity, drawing without GPU culling",
+                m_CullObjects.size());
+        }
+    }
+
+    if (!gpu_culling)
+    {
+        // Every submission of the same draw becomes one instance of a single instanced draw
+        m_InstanceBatcher->reset();
+        for_each_instance([&](const Mesh &mesh, const glm::mat4 &instance_transform)
+        {
+            const glm::mat4 transform = m_DrawConstants.transform * instance_transform;
+
+            DrawPacket packet;
+            packet.pipeline = pipeline;
+            packet.material = material;
+            packet.geometry = geometry_indices[mesh.get_index_type() == VK_INDEX_TYPE_UINT32];
+            // Front to back within equal state, by the view depth of the mesh's bounding sphere center
+            const glm::vec4 center = m_Camera.get_view_matrix() * transform * glm::vec4(glm::vec3(mesh.get_bounding_sphere()), 1.0f);
+            packet.sort_key = make_opaque_sort_key(0, pipeline, material, packet.geometry, -center.z);
+            // Every instance picks its own LOD, instances of different LODs land in different batches
+            mesh.fill_draw(packet, mesh.select_lod(transform, m_Camera.get_position(), m_Camera.get_screen_scale()));
+
+            DrawConstants constants = m_DrawConstants;
+            constants.quantization = mesh.get_quantization();
+            m_InstanceBatcher->add(packet, instance_transform, constants);
+        });
+
+        if (m_InstanceBatcher->get_instance_count() <= m_InstanceBuffer->get_max_instance_count())
+        {
+            m_InstanceBatcher->pack(m_RenderQueue->get_draw_list(0));
+            m_InstanceBuffer->set_instances(m_InstanceBatcher->get_packed_instances().data(), m_InstanceBatcher->get_instance_count());
+        }
+        else
+        {
+            Logger::get_instance().push_message(LoggingLevel::Error, "[Renderer] {} instances exceed the instance buffer",
+                m_InstanceBatcher->get_instance_count());
+        }
+    }
+
+    m_RenderQueue->sort();
+
+    // Runs of packets with equal state are drawn from this buffer with one indirect call each
+    const u32 packet_count = m_RenderQueue->get_packet_count();
+    if (!m_IndirectBuffer || m_IndirectBuffer->get_max_draw_count() < packet_count)
+    {
+        if (Ref<IndirectBuffer> old_buffer = m_IndirectBuffer)
+            m_Vk->defer_destroy([old_buffer]() { old_buffer->destroy(); });
+        m_IndirectBuffer = IndirectBuffer::create(std::max(packet_count, m_IndirectBuffer ? m_IndirectBuffer->get_max_draw_count() * 2 : 256u));
+    }
+    m_RenderQueue->pack_indirect(*m_IndirectBuffer);
+
+    // The scene transform is shared by every instance, culling in the space below it keeps the
+    // cull objects independent of it
+    if (gpu_culling)
+        m_Culling->cull(*m_CommandBuffer, m_UboData.viewProjection * m_DrawConstants.transform);
+
+    // Draws are recorded into secondary buffers on the workers, the primary only executes them
+    m_CommandBuffer->begin_render_pass(pass, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+    m_CommandRecorder->record(*m_CommandBuffer, pass, m_RenderQueue->get_packet_count(), [&](CommandBuffer &secondary, u32 begin, u32 end)
+    {
+        m_RenderQueue->translate(secondary, viewport, scissor, begin, end, m_IndirectBuffer.get());
+    }, RENDER_QUEUE_MIN_CHUNK_SIZE);
 
     if (ImDrawData* draw_data = ImGui::GetDrawData())
     {
-        ImGui_ImplVulkan_RenderDrawData(draw_data, command_buffer);
+        m_CommandRecorder->record(*m_CommandBuffer, pass, 1, [draw_data](CommandBuffer &secondary, u32, u32)
+        {
+            ImGui_ImplVulkan_RenderDrawData(draw_data, secondary.get_active_handle());
+        });
     }
 
+    m_CommandBuffer->end_render_pass();
     m_CommandBuffer->end();
     m_Vk->submit({command_buffer});
+
+    m_BindStats = m_CommandBuffer->get_stats();
+    m_BindStats += m_CommandRecorder->get_frame_stats();
 }
 
 void Application::imgui_init()
@@ -5,21 +5,39 @@
 #include "window.hpp"
 #include "camera.hpp"
 
+#include "renderer/gpu_culling.hpp"
+#include "renderer/render_queue.hpp"
+#include "renderer/vertex.hpp"
+
+#include "vulkan/command_buffer.hpp"
+
 #include <memory>
 #include <vector>
 
 class VulkanContext;
 class CommandBuffer;
+class ParallelCommandRecorder;
+class InstanceBatcher;
 class GraphicsPipeline;
-class VertexBuffer;
-class IndexBuffer;
+class GeometryPool;
+class Mesh;
 class UniformBuffer;
+class IndirectBuffer;
+class InstanceBuffer;
+class DynamicUniformBuffer;
 class Shader;
+class ShaderLibrary;
 
 struct UniformBufferData
 {
     glm::mat4 viewProjection;
+};
+
+// Matches DrawConstants in default.vert
+struct DrawConstants
+{
     glm::mat4 transform;
+    VertexQuantization quantization;
 };
 
 class Application {
@@ -43,14 +61,29 @@ private:
     void imgui_end();
     void imgui_shutdown() const;
 
+    Scope<ShaderLibrary> m_ShaderLibrary;
     Ref<GraphicsPipeline> m_Pipeline;
-    Ref<VertexBuffer> m_VertexBuffer;
-    Ref<IndexBuffer> m_IndexBuffer;
+    Scope<GeometryPool> m_GeometryPool;
+    Ref<Mesh> m_QuadMesh;
+    std::vector<Ref<Mesh>> m_ImportedMeshes;
     Ref<UniformBuffer> m_UniformBuffer;
+    Ref<IndirectBuffer> m_IndirectBuffer;
+    Ref<InstanceBuffer> m_InstanceBuffer;
     UniformBufferData m_UboData;
+    DrawConstants m_DrawConstants;
+    Ref<DynamicUniformBuffer> m_DrawConstantBuffer; // only when draw constants exceed the push constant limit
+    DrawConstantLayout m_DrawConstantLayout;
 
     std::vector<VkDescriptorSetLayout> m_DescLayouts;
     Ref<CommandBuffer> m_CommandBuffer;
+    Scope<ParallelCommandRecorder> m_CommandRecorder;
+    CommandBufferStats m_BindStats; // of the last recorded frame
+    Scope<RenderQueue> m_RenderQueue;
+    Scope<InstanceBatcher> m_InstanceBatcher;
+    Scope<GpuCulling> m_Culling; // nullptr when the cull shader failed to load
+    std::vector<CullObject> m_CullObjects;
+    std::vector<glm::mat4> m_CullInstances;
+    bool m_GpuCullingEnabled = true;
     Camera m_Camera;
     Scope<Window> m_Window;
     VulkanContext *m_Vk;
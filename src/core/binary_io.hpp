@@ -0,0 +1,161 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#ifndef BINARY_IO_HPP
+#define BINARY_IO_HPP
+
+#include "types.hpp"
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <cstring>
+
+// Appends trivially copyable values to a byte buffer in host byte order.
+// Files written with it are caches and cooked data, not an interchange format.
+class BinaryWriter
+{
+public:
+    template<typename T>
+    void write(const T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "BinaryWriter requires a trivially copyable type");
+        write_bytes(&value, sizeof(T));
+    }
+
+    void write_bytes(const void *data, size_t size)
+    {
+        const u8 *bytes = static_cast<const u8 *>(data);
+        m_Buffer.insert(m_Buffer.end(), bytes, bytes + size);
+    }
+
+    void write_string(std::string_view str)
+    {
+        write(static_cast<u32>(str.size()));
+        write_bytes(str.data(), str.size());
+    }
+
+    template<typename T>
+    void write_vector(const std::vector<T> &values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "BinaryWriter requires a trivially copyable type");
+        write(static_cast<u32>(values.size()));
+        write_bytes(values.data(), values.size() * sizeof(T));
+    }
+
+    // Pads with zeros until the buffer size is a multiple of alignment
+    void align(size_t alignment)
+    {
+        const size_t remainder = m_Buffer.size() % alignment;
+        if (remainder != 0)
+            m_Buffer.resize(m_Buffer.size() + alignment - remainder, 0);
+    }
+
+    size_t get_size() const { return m_Buffer.size(); }
+    const std::vector<u8> &get_buffer() const { return m_Buffer; }
+    std::vector<u8> &get_buffer() { return m_Buffer; }
+
+private:
+    std::vector<u8> m_Buffer;
+};
+
+// Reads values written by BinaryWriter. Reading past the end fails the reader
+// instead of throwing, callers check is_valid() once at the end.
+class BinaryReader
+{
+public:
+    BinaryReader(const void *data, size_t size)
+        : m_Data(static_cast<const u8 *>(data)), m_Size(size)
+    {
+    }
+
+    template<typename T>
+    T read()
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "BinaryReader requires a trivially copyable type");
+        T value = {};
+        read_bytes(&value, sizeof(T));
+        return value;
+    }
+
+    bool read_bytes(void *data, size_t size)
+    {
+        if (!m_Valid || size > m_Size - m_Offset)
+        {
+            m_Valid = false;
+            return false;
+        }
+        std::memcpy(data, m_Data + m_Offset, size);
+        m_Offset += size;
+        return true;
+    }
+
+    std::string read_string()
+    {
+        const u32 size = read<u32>();
+        if (!m_Valid || size > m_Size - m_Offset)
+        {
+            m_Valid = false;
+            return {};
+        }
+        std::string str(reinterpret_cast<const char *>(m_Data + m_Offset), size);
+        m_Offset += size;
+        return str;
+    }
+
+    template<typename T>
+    std::vector<T> read_vector()
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "BinaryReader requires a trivially copyable type");
+        const u32 count = read<u32>();
+        if (!m_Valid || count > (m_Size - m_Offset) / sizeof(T))
+        {
+            m_Valid = false;
+            return {};
+        }
+        std::vector<T> values(count);
+        read_bytes(values.data(), count * sizeof(T));
+        return values;
+    }
+
+    // Returns a pointer into the underlying data without copying
+    const u8 *skip(size_t size)
+    {
+        if (!m_Valid || size > m_Size - m_Offset)
+        {
+            m_Valid = false;
+            return nullptr;
+        }
+        const u8 *ptr = m_Data + m_Offset;
+        m_Offset += size;
+        return ptr;
+    }
+
+    void align(size_t alignment)
+    {
+        const size_t remainder = m_Offset % alignment;
+        if (remainder != 0)
+            skip(alignment - remainder);
+    }
+
+    void seek(size_t offset)
+    {
+        if (offset > m_Size)
+            m_Valid = false;
+        else
+            m_Offset = offset;
+    }
+
+    bool is_valid() const { return m_Valid; }
+    bool is_at_end() const { return m_Offset == m_Size; }
+    size_t get_offset() const { return m_Offset; }
+    size_t get_size() const { return m_Size; }
+
+private:
+    const u8 *m_Data = nullptr;
+    size_t m_Size = 0;
+    size_t m_Offset = 0;
+    bool m_Valid = true;
+};
+
+#endif //BINARY_IO_HPP
@@ -3,6 +3,7 @@
 #include "camera.hpp"
 
 #include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
 
 Camera::Camera(float fov, float width, float height, float near_clip, float far_clip)
     : m_Position(0.0f), m_Fov(fov), m_NearClip(near_clip), m_FarClip(far_clip), m_Size({width, height})
@@ -68,3 +69,8 @@ const glm::mat4 &Camera::get_projection_matrix()
 {
     return m_ProjectionMatrix;
 }
+
+float Camera::get_screen_scale() const
+{
+    return m_Size.y / (2.0f * std::tan(glm::radians(m_Fov) * 0.5f));
+}
@@ -28,6 +28,12 @@ public:
     const glm::mat4 &get_view_matrix();
     const glm::mat4 &get_projection_matrix();
 
+    const glm::vec3 &get_position() const { return m_Position; }
+    const glm::vec2 &get_size() const { return m_Size; }
+    float get_fov() const { return m_Fov; }
+    // Pixels a unit spans at distance 1 in front of the camera, divide by the distance for farther
+    float get_screen_scale() const;
+
 private:
     glm::vec3 m_Position;
     glm::mat4 m_ViewMatrix;
@@ -0,0 +1,145 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "file_watcher.hpp"
+#include "logger.hpp"
+
+#include <chrono>
+#include <set>
+
+#ifdef __linux__
+    #include <sys/inotify.h>
+    #include <poll.h>
+    #include <unistd.h>
+#endif
+
+// Editors emit several events per save; changes are reported once the tree was quiet for this long
+static constexpr i32 FILE_WATCHER_SETTLE_MS = 100;
+
+FileWatcher::FileWatcher(const std::filesystem::path &directory, Callback callback)
+    : m_Directory(directory), m_Callback(std::move(callback))
+{
+#ifdef __linux__
+    m_InotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_InotifyFd < 0)
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[FileWatcher] Could not initialize inotify");
+        m_Running = false;
+        return;
+    }
+
+    add_watch(m_Directory);
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(m_Directory, ec))
+    {
+        if (entry.is_directory())
+            add_watch(entry.path());
+    }
+#else
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(m_Directory, ec))
+    {
+        if (entry.is_regular_file())
+            m_Timestamps[entry.path().string()] = entry.last_write_time();
+    }
+#endif
+
+    Logger::get_instance().push_message(LoggingLevel::Info, "[FileWatcher] Watching {}", m_Directory.string());
+    m_Thread = std::thread([this]() { watch_loop(); });
+}
+
+FileWatcher::~FileWatcher()
+{
+    m_Running = false;
+    if (m_Thread.joinable())
+        m_Thread.join();
+
+#ifdef __linux__
+    if (m_InotifyFd >= 0)
+        close(m_InotifyFd);
+#endif
+}
+
+#ifdef __linux__
+void FileWatcher::add_watch(const std::filesystem::path &directory)
+{
+    const i32 wd = inotify_add_watch(m_InotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (wd < 0)
+    {
+        Logger::get_instance().push_message(LoggingLevel::Warning, "[FileWatcher] Could not watch {}", directory.string());
+        return;
+    }
+    m_WatchDescriptors[wd] = directory;
+}
+
+void FileWatcher::watch_loop()
+{
+    alignas(inotify_event) char buffer[4096];
+    std::set<std::filesystem::path> changed;
+
+    while (m_Running)
+    {
+        pollfd pfd = { m_InotifyFd, POLLIN, 0 };
+        const i32 ready = poll(&pfd, 1, FILE_WATCHER_SETTLE_MS);
+
+        if (ready <= 0)
+        {
+            // Quiet period, report what accumulated
+            for (const auto &path : changed)
+                m_Callback(path);
+            changed.clear();
+            continue;
+        }
+
+        ssize_t length = 0;
+        while ((length = read(m_InotifyFd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char *ptr = buffer; ptr < buffer + length; )
+            {
+                const inotify_event *event = reinterpret_cast<const inotify_event *>(ptr);
+                ptr += sizeof(inotify_event) + event->len;
+
+                auto it = m_WatchDescriptors.find(event->wd);
+                if (it == m_WatchDescriptors.end() || event->len == 0)
+                    continue;
+
+                const std::filesystem::path path = it->second / event->name;
+                if (event->mask & IN_ISDIR)
+                {
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                        add_watch(path);
+                    continue;
+                }
+
+                // IN_CREATE alone is followed by IN_CLOSE_WRITE once the content is there
+                if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                    changed.insert(path);
+            }
+        }
+    }
+}
+#else
+void FileWatcher::watch_loop()
+{
+    constexpr auto poll_interval = std::chrono::milliseconds(500);
+
+    while (m_Running)
+    {
+        std::this_thread::sleep_for(poll_interval);
+
+        std::error_code ec;
+        for (const auto &entry : std::filesystem::recursive_directory_iterator(m_Directory, ec))
+        {
+            if (!entry.is_regular_file())
+                continue;
+
+            const auto write_time = entry.last_write_time(ec);
+            auto [it, inserted] = m_Timestamps.try_emplace(entry.path().string(), write_time);
+            if (inserted || it->second != write_time)
+            {
+                it->second = write_time;
+                m_Callback(entry.path());
+            }
+        }
+    }
+}
+#endif
@@ -0,0 +1,45 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#ifndef FILE_WATCHER_HPP
+#define FILE_WATCHER_HPP
+
+#include "types.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+
+// Watches a directory tree on a background thread and reports modified files.
+// Uses inotify on Linux and falls back to polling timestamps elsewhere.
+class FileWatcher
+{
+public:
+    using Callback = std::function<void(const std::filesystem::path &path)>;
+
+    FileWatcher(const std::filesystem::path &directory, Callback callback);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher &) = delete;
+    FileWatcher &operator=(const FileWatcher &) = delete;
+
+private:
+    void watch_loop();
+
+#ifdef __linux__
+    void add_watch(const std::filesystem::path &directory);
+
+    i32 m_InotifyFd = -1;
+    std::unordered_map<i32, std::filesystem::path> m_WatchDescriptors;
+#else
+    std::unordered_map<std::string, std::filesystem::file_time_type> m_Timestamps;
+#endif
+
+    std::filesystem::path m_Directory;
+    Callback m_Callback;
+    std::atomic<bool> m_Running = true;
+    std::thread m_Thread;
+};
+
+#endif //FILE_WATCHER_HPP
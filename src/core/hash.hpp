@@ -0,0 +1,40 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include "types.hpp"
+
+#include <string_view>
+#include <type_traits>
+#include <cstddef>
+
+static constexpr u64 HASH_FNV_OFFSET_BASIS = 14695981039346656037ull;
+static constexpr u64 HASH_FNV_PRIME = 1099511628211ull;
+
+// 64-bit FNV-1a, good enough for cache keys
+static u64 hash_bytes(const void *data, size_t size, u64 seed = HASH_FNV_OFFSET_BASIS)
+{
+    const u8 *bytes = static_cast<const u8 *>(data);
+    u64 hash = seed;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= HASH_FNV_PRIME;
+    }
+    return hash;
+}
+
+static u64 hash_string(std::string_view str, u64 seed = HASH_FNV_OFFSET_BASIS)
+{
+    return hash_bytes(str.data(), str.size(), seed);
+}
+
+template<typename T>
+static void hash_combine(u64 &seed, const T &value)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "hash_combine requires a trivially copyable type");
+    seed = hash_bytes(&value, sizeof(T), seed);
+}
+
+#endif //HASH_HPP
@@ -0,0 +1,306 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "json.hpp"
+
+#include <charconv>
+#include <format>
+
+// Nesting deeper than this is malformed for every format read with it
+static constexpr u32 JSON_MAX_DEPTH = 128;
+
+class JsonParser
+{
+public:
+    explicit JsonParser(std::string_view text)
+        : m_Text(text)
+    {
+    }
+
+    bool parse_document(JsonValue &value)
+    {
+        skip_whitespace();
+        if (!parse_value(value, 0))
+            return false;
+        skip_whitespace();
+        return m_Position == m_Text.size() || fail("Trailing characters");
+    }
+
+    const std::string &get_error() const { return m_Error; }
+
+private:
+    bool fail(const char *reason)
+    {
+        if (m_Error.empty())
+            m_Error = std::format("{} at offset {}", reason, m_Position);
+        return false;
+    }
+
+    void skip_whitespace()
+    {
+        while (m_Position < m_Text.size())
+        {
+            const char c = m_Text[m_Position];
+            if (c != ' ' && c != '\t' && c != '\n' && c != '\r')
+                break;
+            ++m_Position;
+        }
+    }
+
+    bool consume(char c)
+    {
+        if (m_Position < m_Text.size() && m_Text[m_Position] == c)
+        {
+            ++m_Position;
+            return true;
+        }
+        return false;
+    }
+
+    bool consume_literal(std::string_view literal)
+    {
+        if (m_Text.substr(m_Position, literal.size()) != literal)
+            return fail("Invalid literal");
+        m_Position += literal.size();
+        return true;
+    }
+
+    bool parse_value(JsonValue &value, u32 depth)
+    {
+        if (depth > JSON_MAX_DEPTH)
+            return fail("Nesting too deep");
+        if (m_Position >= m_Text.size())
+            return fail("Unexpected end");
+
+        switch (m_Text[m_Position])
+        {
+        case '{': return parse_object(value, depth);
+        case '[': return parse_array(value, depth);
+        case '"':
+            value.m_Type = JsonValue::Type::String;
+            return parse_string(value.m_String);
+        case 't':
+            value.m_Type = JsonValue::Type::Bool;
+            value.m_Bool = true;
+            return consume_literal("true");
+        case 'f':
+            value.m_Type = JsonValue::Type::Bool;
+            value.m_Bool = false;
+            return consume_literal("false");
+        case 'n':
+            value.m_Type = JsonValue::Type::Null;
+            return consume_literal("null");
+        default:
+            return parse_number(value);
+        }
+    }
+
+    bool parse_object(JsonValue &value, u32 depth)
+    {
+        value.m_Type = JsonValue::Type::Object;
+        ++m_Position;
+        skip_whitespace();
+        if (consume('}'))
+            return true;
+
+        while (true)
+        {
+            skip_whitespace();
+            std::string key;
+            if (m_Position >= m_Text.size() || m_Text[m_Position] != '"')
+                return fail("Expected a member name");
+            if (!parse_string(key))
+                return false;
+
+            skip_whitespace();
+            if (!consume(':'))
+                return fail("Expected ':'");
+            skip_whitespace();
+
+            value.m_Members.emplace_back(std::move(key), JsonValue());
+            if (!parse_value(value.m_Members.back().second, depth + 1))
+                return false;
+
+            skip_whitespace();
+            if (consume('}'))
+                return true;
+            if (!consume(','))
+                return fail("Expected ',' or '}'");
+        }
+    }
+
+    bool parse_array(JsonValue &value, u32 depth)
+    {
+        value.m_Type = JsonValue::Type::Array;
+        ++m_Position;
+        skip_whitespace();
+        if (consume(']'))
+            return true;
+
+        while (true)
+        {
+            skip_whitespace();
+            value.m_Elements.emplace_back();
+            if (!parse_value(value.m_Elements.back(), depth + 1))
+                return false;
+
+            skip_whitespace();
+            if (consume(']'))
+                return true;
+            if (!consume(','))
+                return fail("Expected ',' or ']'");
+        }
+    }
+
+    bool parse_number(JsonValue &value)
+    {
+        // from_chars rejects the leading '+' JSON forbids as well, and accepts nothing else extra
+        const char *begin = m_Text.data() + m_Position;
+        const char *end = m_Text.data() + m_Text.size();
+        const auto [ptr, ec] = std::from_chars(begin, end, value.m_Number);
+        if (ec != std::errc() || ptr == begin)
+            return fail("Invalid value");
+
+        value.m_Type = JsonValue::Type::Number;
+        m_Position += ptr - begin;
+        return true;
+    }
+
+    bool parse_hex4(u32 &code)
+    {
+        if (m_Position + 4 > m_Text.size())
+            return fail("Truncated escape");
+        const char *begin = m_Text.data() + m_Position;
+        const auto [ptr, ec] = std::from_chars(begin, begin + 4, code, 16);
+        if (ec != std::errc() || ptr != begin + 4)
+            return fail("Invalid escape");
+        m_Position += 4;
+        return true;
+    }
+
+    static void append_utf8(std::string &out, u32 code)
+    {
+        if (code < 0x80)
+            out += static_cast<char>(code);
+        else if (code < 0x800)
+        {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000)
+        {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool parse_string(std::string &out)
+    {
+        ++m_Position; // opening quote
+        while (m_Position < m_Text.size())
+        {
+            const char c = m_Text[m_Position++];
+            if (c == '"')
+                return true;
+            if (static_cast<u8>(c) < 0x20)
+                return fail("Control character in string");
+            if (c != '\\')
+            {
+                out += c;
+                continue;
+            }
+
+            if (m_Position >= m_Text.size())
+                break;
+            switch (m_Text[m_Position++])
+            {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u':
+            {
+                u32 code = 0;
+                if (!parse_hex4(code))
+                    return false;
+                // Surrogate pairs combine into one code point
+                if (code >= 0xD800 && code < 0xDC00 && m_Text.substr(m_Position, 2) == "\\u")
+                {
+                    m_Position += 2;
+                    u32 low = 0;
+                    if (!parse_hex4(low))
+                        return false;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                append_utf8(out, code);
+                break;
+            }
+            default:
+                return fail("Invalid escape");
+            }
+        }
+        return fail("Unterminated string");
+    }
+
+    std::string_view m_Text;
+    size_t m_Position = 0;
+    std::string m_Error;
+};
+
+const JsonValue *JsonValue::find(std::string_view key) const
+{
+    for (const auto &[name, value] : m_Members)
+    {
+        if (name == key)
+            return &value;
+    }
+    return nullptr;
+}
+
+u32 JsonValue::as_u32(u32 fallback) const
+{
+    if (m_Type != Type::Number || m_Number < 0.0 || m_Number > 4294967295.0)
+        return fallback;
+    return static_cast<u32>(m_Number);
+}
+
+u32 JsonValue::get_u32(std::string_view key, u32 fallback) const
+{
+    const JsonValue *value = find(key);
+    return value ? value->as_u32(fallback) : fallback;
+}
+
+double JsonValue::get_number(std::string_view key, double fallback) const
+{
+    const JsonValue *value = find(key);
+    return value ? value->as_number(fallback) : fallback;
+}
+
+std::string_view JsonValue::get_string(std::string_view key, std::string_view fallback) const
+{
+    const JsonValue *value = find(key);
+    return value ? value->as_string(fallback) : fallback;
+}
+
+bool JsonValue::parse(std::string_view text, JsonValue &value, std::string *error)
+{
+    value = JsonValue();
+    JsonParser parser(text);
+    if (parser.parse_document(value))
+        return true;
+
+    if (error)
+        *error = parser.get_error();
+    return false;
+}
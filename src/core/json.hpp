@@ -0,0 +1,69 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#ifndef JSON_HPP
+#define JSON_HPP
+
+#include "types.hpp"
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Minimal JSON document, enough for asset headers like glTF. Objects keep their members in
+// file order and are searched linearly, they are small and read once.
+class JsonValue
+{
+public:
+    enum class Type : u8
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    Type get_type() const { return m_Type; }
+    bool is_null() const { return m_Type == Type::Null; }
+    bool is_number() const { return m_Type == Type::Number; }
+    bool is_string() const { return m_Type == Type::String; }
+    bool is_array() const { return m_Type == Type::Array; }
+    bool is_object() const { return m_Type == Type::Object; }
+
+    // Member of an object, nullptr when absent or this is not an object
+    const JsonValue *find(std::string_view key) const;
+
+    // Elements of an array, members of an object
+    size_t size() const { return m_Type == Type::Object ? m_Members.size() : m_Elements.size(); }
+    const JsonValue &operator[](size_t index) const { return m_Elements[index]; }
+    const std::vector<JsonValue> &get_elements() const { return m_Elements; }
+    const std::vector<std::pair<std::string, JsonValue>> &get_members() const { return m_Members; }
+
+    // Values of the wrong type return the fallback
+    bool as_bool(bool fallback = false) const { return m_Type == Type::Bool ? m_Bool : fallback; }
+    double as_number(double fallback = 0.0) const { return m_Type == Type::Number ? m_Number : fallback; }
+    u32 as_u32(u32 fallback = 0) const;
+    std::string_view as_string(std::string_view fallback = {}) const { return m_Type == Type::String ? std::string_view(m_String) : fallback; }
+
+    // Shorthands for optional members
+    u32 get_u32(std::string_view key, u32 fallback = 0) const;
+    double get_number(std::string_view key, double fallback = 0.0) const;
+    std::string_view get_string(std::string_view key, std::string_view fallback = {}) const;
+
+    // Parses a whole document, error receives the reason and byte offset on failure
+    static bool parse(std::string_view text, JsonValue &value, std::string *error = nullptr);
+
+private:
+    friend class JsonParser;
+
+    Type m_Type = Type::Null;
+    bool m_Bool = false;
+    double m_Number = 0.0;
+    std::string m_String;
+    std::vector<JsonValue> m_Elements;
+    std::vector<std::pair<std::string, JsonValue>> m_Members;
+};
+
+#endif //JSON_HPP
@@ -9,6 +9,7 @@
 #include <sstream>
 #include <utility>
 #include <iostream>
+#include <mutex>
 
 enum LoggingLevel
 {
@@ -36,6 +37,8 @@ public:
 
     void push_message(std::string message, LoggingLevel level = LoggingLevel::Info)
     {
+        // Shaders and pipelines are built from worker threads
+        std::lock_guard<std::mutex> lock(m_Mutex);
         if (m_Messages.size() > 1024)
             m_Messages.erase(m_Messages.begin());
 
@@ -52,6 +55,7 @@ public:
 
     void clear_messages()
     {
+        std::lock_guard<std::mutex> lock(m_Mutex);
         m_Messages.clear();
     }
 
@@ -139,6 +143,7 @@ private:
 
     std::vector<LogMessage> m_Messages;
     std::stringstream m_Buffer;
+    std::mutex m_Mutex;
 };
 
 #define LOG_ERROR(format, ...) Logger::get_instance().push_message(LoggingLevel::Error, format, __VA_ARGS__)
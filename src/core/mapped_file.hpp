@@ -0,0 +1,40 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include "types.hpp"
+
+#include <filesystem>
+
+// Read-only memory mapping of a whole file. Pages are loaded by the OS on first
+// touch, so large archives cost nothing until their data is actually used.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const std::filesystem::path &path);
+    void close();
+
+    bool is_open() const { return m_Data != nullptr; }
+    const u8 *get_data() const { return m_Data; }
+    size_t get_size() const { return m_Size; }
+
+private:
+    const u8 *m_Data = nullptr;
+    size_t m_Size = 0;
+
+#ifdef _WIN32
+    void *m_File = nullptr;
+    void *m_Mapping = nullptr;
+#else
+    i32 m_Fd = -1;
+#endif
+};
+
+#endif //MAPPED_FILE_HPP
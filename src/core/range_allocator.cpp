@@ -0,0 +1,91 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "range_allocator.hpp"
+
+#include "assert.hpp"
+
+#include <algorithm>
+
+RangeAllocator::RangeAllocator(u64 capacity)
+    : m_Capacity(capacity)
+{
+    reset();
+}
+
+void RangeAllocator::reset()
+{
+    m_FreeRanges.clear();
+    m_Allocations.clear();
+    m_Used = 0;
+    if (m_Capacity > 0)
+        m_FreeRanges.emplace(0, m_Capacity);
+}
+
+u64 RangeAllocator::allocate(u64 size, u64 alignment)
+{
+    if (size == 0)
+        return INVALID_OFFSET;
+
+    alignment = std::max<u64>(1, alignment);
+    for (auto it = m_FreeRanges.begin(); it != m_FreeRanges.end(); ++it)
+    {
+        const u64 range_offset = it->first;
+        const u64 range_size = it->second;
+        const u64 aligned = (range_offset + alignment - 1) / alignment * alignment;
+        const u64 padding = aligned - range_offset;
+        if (padding > range_size || range_size - padding < size)
+            continue;
+
+        // The padding stays part of the allocation, so free() returns it too
+        const u64 allocated = padding + size;
+        m_FreeRanges.erase(it);
+        if (range_size > allocated)
+            m_FreeRanges.emplace(range_offset + allocated, range_size - allocated);
+
+        m_Allocations.emplace(aligned, Allocation{ range_offset, allocated });
+        m_Used += allocated;
+        return aligned;
+    }
+    return INVALID_OFFSET;
+}
+
+void RangeAllocator::free(u64 offset)
+{
+    auto allocation = m_Allocations.find(offset);
+    ASSERT(allocation != m_Allocations.end(), "[RangeAllocator] Freeing a range that was not allocated");
+    if (allocation == m_Allocations.end())
+        return;
+
+    u64 range_offset = allocation->second.start;
+    u64 range_size = allocation->second.size;
+    m_Allocations.erase(allocation);
+    m_Used -= range_size;
+
+    // Merge with the free neighbours on both sides
+    auto next = m_FreeRanges.lower_bound(range_offset);
+    if (next != m_FreeRanges.end() && next->first == range_offset + range_size)
+    {
+        range_size += next->second;
+        next = m_FreeRanges.erase(next);
+    }
+
+    if (next != m_FreeRanges.begin())
+    {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == range_offset)
+        {
+            previous->second += range_size;
+            return;
+        }
+    }
+
+    m_FreeRanges.emplace_hint(next, range_offset, range_size);
+}
+
+u64 RangeAllocator::get_largest_free_range() const
+{
+    u64 largest = 0;
+    for (const auto &[offset, size] : m_FreeRanges)
+        largest = std::max(largest, size);
+    return largest;
+}
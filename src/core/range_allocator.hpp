@@ -0,0 +1,47 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#ifndef RANGE_ALLOCATOR_HPP
+#define RANGE_ALLOCATOR_HPP
+
+#include "types.hpp"
+
+#include <map>
+#include <unordered_map>
+
+// Sub-allocates ranges of a fixed capacity, in whatever unit the owner uses (bytes, vertices,
+// indices). First fit over free ranges ordered by offset, freed ranges merge with their
+// neighbours so the space does not fragment into unusable pieces. Not thread safe.
+class RangeAllocator
+{
+public:
+    static constexpr u64 INVALID_OFFSET = ~0ull;
+
+    explicit RangeAllocator(u64 capacity = 0);
+
+    // Offset of a range of size units aligned to alignment, INVALID_OFFSET when none is free
+    u64 allocate(u64 size, u64 alignment = 1);
+
+    // Releases a range returned by allocate
+    void free(u64 offset);
+
+    void reset();
+
+    u64 get_capacity() const { return m_Capacity; }
+    u64 get_used() const { return m_Used; }
+    // Largest range allocate could still return without alignment
+    u64 get_largest_free_range() const;
+
+private:
+    struct Allocation
+    {
+        u64 start; // before the alignment padding
+        u64 size; // including the padding
+    };
+
+    u64 m_Capacity;
+    u64 m_Used = 0;
+    std::map<u64, u64> m_FreeRanges; // offset -> size
+    std::unordered_map<u64, Allocation> m_Allocations; // by returned offset
+};
+
+#endif //RANGE_ALLOCATOR_HPP
@@ -0,0 +1,79 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(u32 thread_count)
+{
+    if (thread_count == 0)
+    {
+        const u32 hardware_threads = std::thread::hardware_concurrency();
+        thread_count = hardware_threads > 1 ? hardware_threads - 1 : 1;
+    }
+
+    m_Workers.reserve(thread_count);
+    for (u32 i = 0; i < thread_count; ++i)
+    {
+        m_Workers.emplace_back([this]() { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_Condition.notify_all();
+
+    for (auto &worker : m_Workers)
+        worker.join();
+}
+
+void ThreadPool::worker_loop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [this]() { return m_Stopping || !m_Tasks.empty(); });
+            if (m_Stopping && m_Tasks.empty())
+                return;
+
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallel_for(u32 count, const std::function<void(u32 begin, u32 end)> &func, u32 min_chunk_size)
+{
+    if (count == 0)
+        return;
+
+    const u32 chunk_count = std::max(1u, std::min(get_thread_count(), count / std::max(1u, min_chunk_size)));
+    const u32 chunk_size = (count + chunk_count - 1) / chunk_count;
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(chunk_count);
+    for (u32 begin = 0; begin < count; begin += chunk_size)
+    {
+        const u32 end = std::min(count, begin + chunk_size);
+        futures.push_back(submit([&func, begin, end]() { func(begin, end); }));
+    }
+
+    // Wait for every chunk before rethrowing, func is captured by reference
+    for (auto &future : futures)
+        future.wait();
+    for (auto &future : futures)
+        future.get();
+}
+
+ThreadPool &ThreadPool::get_instance()
+{
+    static ThreadPool instance;
+    return instance;
+}
@@ -0,0 +1,57 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include "types.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    explicit ThreadPool(u32 thread_count = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    template<typename Func>
+    auto submit(Func &&func) -> std::future<decltype(func())>
+    {
+        using Result = decltype(func());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+        std::future<Result> future = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Tasks.emplace([task]() { (*task)(); });
+        }
+        m_Condition.notify_one();
+        return future;
+    }
+
+    // Runs func(begin, end) over [0, count) split into chunks, blocks until all chunks finished.
+    // Must not be called from a worker of the same pool.
+    void parallel_for(u32 count, const std::function<void(u32 begin, u32 end)> &func, u32 min_chunk_size = 1);
+
+    u32 get_thread_count() const { return static_cast<u32>(m_Workers.size()); }
+
+    static ThreadPool &get_instance();
+
+private:
+    void worker_loop();
+
+    std::vector<std::thread> m_Workers;
+    std::queue<std::function<void()>> m_Tasks;
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    bool m_Stopping = false;
+};
+
+#endif //THREAD_POOL_HPP
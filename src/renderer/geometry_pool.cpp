@@ -0,0 +1,152 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#include "geometry_pool.hpp"
+
+#include "core/assert.hpp"
+#include "vulkan/buffers.hpp"
+
+#include <cstring>
+
+// Stream bases are aligned for any vertex format and storage buffer views of the arena
+static constexpr VkDeviceSize GEOMETRY_STREAM_ALIGNMENT = 256;
+
+GeometryPool::GeometryPool(const std::vector<u32> &stream_strides, u32 max_vertex_count, u32 max_index_count, VkDeviceSize staging_size)
+    : m_StreamStrides(stream_strides)
+    , m_VertexAllocator(max_vertex_count)
+    , m_IndexAllocator(static_cast<u64>(max_index_count) * sizeof(u32))
+{
+    ASSERT(!m_StreamStrides.empty(), "[GeometryPool] At least one vertex stream is required");
+
+    VkDeviceSize vertex_size = 0;
+    for (u32 stride : m_StreamStrides)
+    {
+        vertex_size = (vertex_size + GEOMETRY_STREAM_ALIGNMENT - 1) & ~(GEOMETRY_STREAM_ALIGNMENT - 1);
+        m_StreamOffsets.push_back(vertex_size);
+        vertex_size += static_cast<VkDeviceSize>(stride) * max_vertex_count;
+    }
+
+    const VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    m_VertexBuffer = CreateRef<VulkanBuffer>(vertex_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    m_VertexBuffer->bind_memory();
+    m_IndexBuffer = CreateRef<VulkanBuffer>(static_cast<VkDeviceSize>(max_index_count) * sizeof(u32),
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    m_IndexBuffer->bind_memory();
+    m_StagingBuffer = StagingBuffer::create(staging_size);
+
+    Logger::get_instance().push_message(LoggingLevel::Info, "[GeometryPool] {} streams, {} vertices, {} indices",
+        m_StreamStrides.size(), max_vertex_count, max_index_count);
+}
+
+GeometryPool::~GeometryPool()
+{
+    ASSERT(!m_VertexBuffer, "Forget to call destroy()");
+}
+
+bool GeometryPool::allocate(u32 vertex_count, u32 index_count, GeometryRange &range)
+{
+    const u64 first_vertex = m_VertexAllocator.allocate(vertex_count);
+    if (first_vertex == RangeAllocator::INVALID_OFFSET)
+        return false;
+
+    // Ranges start on 32-bit boundaries so either index type can address them
+    const VkIndexType index_type = get_mesh_index_type(vertex_count);
+    const u32 index_size = get_index_size(index_type);
+    u64 index_offset = 0;
+    if (index_count > 0)
+    {
+        index_offset = m_IndexAllocator.allocate(static_cast<u64>(index_count) * index_size, sizeof(u32));
+        if (index_offset == RangeAllocator::INVALID_OFFSET)
+        {
+            m_VertexAllocator.free(first_vertex);
+            return false;
+        }
+    }
+
+    range.first_vertex = static_cast<u32>(first_vertex);
+    range.vertex_count = vertex_count;
+    range.first_index = static_cast<u32>(index_offset / index_size);
+    range.index_count = index_count;
+    range.index_type = index_type;
+    return true;
+}
+
+void GeometryPool::free(const GeometryRange &range)
+{
+    m_VertexAllocator.free(range.first_vertex);
+    if (range.index_count > 0)
+        m_IndexAllocator.free(static_cast<u64>(range.first_index) * get_index_size(range.index_type));
+}
+
+void GeometryPool::upload_stream(const GeometryRange &range, u32 stream, const void *data)
+{
+    ASSERT(stream < get_stream_count(), "[GeometryPool] Stream index out of range");
+    const VkDeviceSize stride = m_StreamStrides[stream];
+    m_StagingBuffer->upload(m_VertexBuffer->get_buffer(), m_StreamOffsets[stream] + range.first_vertex * stride,
+        data, range.vertex_count * stride);
+}
+
+void GeometryPool::upload_indices(const GeometryRange &range, const void *indices)
+{
+    const VkDeviceSize index_size = get_index_size(range.index_type);
+    m_StagingBuffer->upload(m_IndexBuffer->get_buffer(), range.first_index * index_size, indices, range.index_count * index_size);
+}
+
+void *GeometryPool::map_stream(const GeometryRange &range, u32 stream)
+{
+    ASSERT(stream < get_stream_count(), "[GeometryPool] Stream index out of range");
+    const VkDeviceSize stride = m_StreamStrides[stream];
+    return m_StagingBuffer->allocate(m_VertexBuffer->get_buffer(), m_StreamOffsets[stream] + range.first_vertex * stride,
+        range.vertex_count * stride);
+}
+
+void *GeometryPool::map_indices(const GeometryRange &range)
+{
+    const VkDeviceSize index_size = get_index_size(range.index_type);
+    return m_StagingBuffer->allocate(m_IndexBuffer->get_buffer(), range.first_index * index_size, range.index_count * index_size);
+}
+
+void GeometryPool::flush()
+{
+    m_StagingBuffer->flush();
+}
+
+RenderGeometry GeometryPool::get_render_geometry(const std::vector<u32> &streams, VkIndexType index_type) const
+{
+    RenderGeometry geometry;
+    const u32 count = streams.empty() ? get_stream_count() : static_cast<u32>(streams.size());
+    for (u32 i = 0; i < count; ++i)
+    {
+        const u32 stream = streams.empty() ? i : streams[i];
+        ASSERT(stream < get_stream_count(), "[GeometryPool] Stream index out of range");
+        geometry.vertex_buffers.push_back(m_VertexBuffer->get_buffer());
+        geometry.vertex_offsets.push_back(m_StreamOffsets[stream]);
+    }
+
+    geometry.index_buffer = m_IndexBuffer->get_buffer();
+    geometry.index_offset = 0;
+    geometry.index_type = index_type;
+    return geometry;
+}
+
+VkBuffer GeometryPool::get_vertex_buffer() const
+{
+    return m_VertexBuffer->get_buffer();
+}
+
+VkBuffer GeometryPool::get_index_buffer() const
+{
+    return m_IndexBuffer->get_buffer();
+}
+
+void GeometryPool::destroy()
+{
+    if (!m_VertexBuffer)
+        return;
+
+    m_VertexBuffer->destroy();
+    m_IndexBuffer->destroy();
+    m_StagingBuffer->destroy();
+    m_VertexBuffer.reset();
+    m_IndexBuffer.reset();
+    m_StagingBuffer.reset();
+}
@@ -0,0 +1,88 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#ifndef GEOMETRY_POOL_HPP
+#define GEOMETRY_POOL_HPP
+
+#include "render_queue.hpp"
+
+#include "vertex.hpp"
+
+#include "core/range_allocator.hpp"
+#include "core/types.hpp"
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+class StagingBuffer;
+class VulkanBuffer;
+
+// Vertices and indices of one mesh inside a GeometryPool
+struct GeometryRange
+{
+    u32 first_vertex = 0; // vertex_offset of the mesh's draws
+    u32 vertex_count = 0;
+    u32 first_index = 0; // in elements of index_type
+    u32 index_count = 0;
+    VkIndexType index_type = VK_INDEX_TYPE_UINT32; // see get_mesh_index_type
+};
+
+// Geometry of every mesh in one device local vertex arena and one index arena. The vertex
+// arena is split into streams, one tightly packed array per attribute group (SoA), and a mesh
+// owns the same vertex range in all of them. Draws then differ only in first_index and
+// vertex_offset, the buffers are bound once, and a pass binds just the streams it reads,
+// depth-only passes only the positions.
+// Meshes of up to 65536 vertices keep 16-bit indices, both widths share the index arena and
+// are bound as two geometries over the same buffer.
+class GeometryPool
+{
+public:
+    // The index arena holds max_index_count 32-bit indices, or twice as many 16-bit ones
+    GeometryPool(const std::vector<u32> &stream_strides, u32 max_vertex_count, u32 max_index_count,
+        VkDeviceSize staging_size = 16 * 1024 * 1024);
+    ~GeometryPool();
+
+    // False when either arena has no free range large enough. The index type follows from vertex_count.
+    bool allocate(u32 vertex_count, u32 index_count, GeometryRange &range);
+    // The GPU may still read the range, free after the last frame using it completed
+    void free(const GeometryRange &range);
+
+    // Copy range.vertex_count elements of the stream's stride, or range.index_count indices of range.index_type
+    void upload_stream(const GeometryRange &range, u32 stream, const void *data);
+    void upload_indices(const GeometryRange &range, const void *indices);
+
+    // Staging memory that flush() copies into the range, to be written in place. nullptr when
+    // the staging space is used up, flush and map again.
+    void *map_stream(const GeometryRange &range, u32 stream);
+    void *map_indices(const GeometryRange &range);
+
+    // Submits pending uploads and waits for them
+    void flush();
+
+    // Binding i reads streams[i], every stream when streams is empty. Draws of a mesh use the
+    // geometry of its range's index type.
+    RenderGeometry get_render_geometry(const std::vector<u32> &streams = {}, VkIndexType index_type = VK_INDEX_TYPE_UINT32) const;
+
+    void destroy();
+
+    u32 get_stream_count() const { return static_cast<u32>(m_StreamStrides.size()); }
+    u32 get_stream_stride(u32 stream) const { return m_StreamStrides[stream]; }
+    VkDeviceSize get_stream_offset(u32 stream) const { return m_StreamOffsets[stream]; }
+    VkBuffer get_vertex_buffer() const;
+    VkBuffer get_index_buffer() const;
+    const Ref<StagingBuffer> &get_staging_buffer() const { return m_StagingBuffer; }
+
+    u32 get_used_vertex_count() const { return static_cast<u32>(m_VertexAllocator.get_used()); }
+    VkDeviceSize get_used_index_size() const { return m_IndexAllocator.get_used(); }
+
+private:
+    std::vector<u32> m_StreamStrides;
+    std::vector<VkDeviceSize> m_StreamOffsets;
+    RangeAllocator m_VertexAllocator; // in vertices
+    RangeAllocator m_IndexAllocator; // in bytes
+
+    Ref<VulkanBuffer> m_VertexBuffer;
+    Ref<VulkanBuffer> m_IndexBuffer;
+    Ref<StagingBuffer> m_StagingBuffer;
+};
+
+#endif
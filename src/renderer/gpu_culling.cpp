@@ -0,0 +1,168 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#include "gpu_culling.hpp"
+
+#include "core/assert.hpp"
+#include "vulkan/buffers.hpp"
+#include "vulkan/command_buffer.hpp"
+#include "vulkan/compute_pipeline.hpp"
+#include "vulkan/vulkan_context.hpp"
+
+#include <algorithm>
+
+// Bindings of set 0 in res/shaders/cull.comp
+static constexpr u32 CULL_PARAMS_BINDING = 0;
+static constexpr u32 CULL_OBJECTS_BINDING = 1;
+static constexpr u32 CULL_COMMANDS_BINDING = 2;
+static constexpr u32 CULL_COUNTS_BINDING = 3;
+
+GpuCulling::GpuCulling(const Ref<Shader> &cull_shader, u32 max_object_count, u32 max_group_count)
+    : m_GroupObjectCounts(std::max(1u, max_group_count), 0), m_GroupFirstCommands(std::max(1u, max_group_count), 0),
+    m_MaxObjectCount(std::max(1u, max_object_count)), m_WrittenCommandCount(m_MaxObjectCount)
+{
+    const std::vector<ShaderMacro> &macros = cull_shader->get_macros();
+    ASSERT(VulkanContext::get()->is_compute_subgroup_ballot_supported()
+        || std::none_of(macros.begin(), macros.end(), [](const ShaderMacro &macro) { return macro.name == "CULL_SUBGROUP_BALLOT"; }),
+        "[Culling] Shader needs subgroup ballots the device does not support");
+
+    m_Pipeline = ComputePipeline::create(cull_shader);
+
+    m_ParamsBuffer = CreateRef<VulkanBuffer>(sizeof(CullParams), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+    m_ParamsBuffer->bind_memory();
+    m_ObjectBuffer = StorageBuffer::create(sizeof(CullObject) * m_MaxObjectCount);
+    m_CommandBuffer = StorageBuffer::create(sizeof(VkDrawIndexedIndirectCommand) * m_MaxObjectCount,
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    m_CountBuffer = StorageBuffer::create(sizeof(u32) * m_GroupObjectCounts.size(),
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+
+    m_Pipeline->bind_uniform_buffer(0, CULL_PARAMS_BINDING, m_ParamsBuffer->get_buffer());
+    m_Pipeline->bind_storage_buffer(0, CULL_OBJECTS_BINDING, m_ObjectBuffer->get_buffer());
+    m_Pipeline->bind_storage_buffer(0, CULL_COMMANDS_BINDING, m_CommandBuffer->get_buffer());
+    m_Pipeline->bind_storage_buffer(0, CULL_COUNTS_BINDING, m_CountBuffer->get_buffer());
+}
+
+GpuCulling::~GpuCulling()
+{
+    ASSERT(!m_Pipeline, "Forget to call destroy()");
+}
+
+std::vector<ShaderMacro> GpuCulling::get_shader_macros()
+{
+    std::vector<ShaderMacro> macros;
+    if (VulkanContext::get()->is_compute_subgroup_ballot_supported())
+        macros.push_back({ "CULL_SUBGROUP_BALLOT" });
+    return macros;
+}
+
+bool GpuCulling::set_objects(const std::vector<CullObject> &objects)
+{
+    if (objects.size() > m_MaxObjectCount)
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[Culling] {} objects exceed the capacity of {}",
+            objects.size(), m_MaxObjectCount);
+        return false;
+    }
+
+    const u32 group_count = get_max_group_count();
+    auto invalid = std::find_if(objects.begin(), objects.end(), [group_count](const CullObject &object) { return object.group >= group_count; });
+    if (invalid != objects.end())
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[Culling] Group {} is out of range, {} groups", invalid->group, group_count);
+        return false;
+    }
+
+    // Counting sort by group, every group gets a contiguous range of commands
+    std::fill(m_GroupObjectCounts.begin(), m_GroupObjectCounts.end(), 0);
+    for (const CullObject &object : objects)
+        ++m_GroupObjectCounts[object.group];
+
+    u32 first_command = 0;
+    for (u32 group = 0; group < group_count; ++group)
+    {
+        m_GroupFirstCommands[group] = first_command;
+        first_command += m_GroupObjectCounts[group];
+    }
+
+    m_Objects.resize(objects.size());
+    m_GroupCursors.assign(m_GroupFirstCommands.begin(), m_GroupFirstCommands.end());
+    for (const CullObject &object : objects)
+    {
+        CullObject &sorted = m_Objects[m_GroupCursors[object.group]++];
+        sorted = object;
+        sorted.first_command = m_GroupFirstCommands[object.group];
+    }
+
+    if (!m_Objects.empty())
+        m_ObjectBuffer->set_data(m_Objects.data(), sizeof(CullObject) * m_Objects.size());
+    return true;
+}
+
+void GpuCulling::cull(CommandBuffer &command_buffer, const glm::mat4 &view_projection)
+{
+    CullParams params = {};
+    const std::array<glm::vec4, 6> planes = extract_frustum_planes(view_projection);
+    std::copy(planes.begin(), planes.end(), params.frustum_planes);
+    params.object_count = get_object_count();
+    m_ParamsBuffer->set_data(&params, sizeof(params));
+
+    // Without drawIndirectCount every command of a group is drawn, so the commands of culled
+    // objects need an instance count of zero. The previous cull wrote at most one command per
+    // object it had, everything past those is still zero.
+    const VkBuffer commands = m_CommandBuffer->get_buffer();
+    const VkBuffer counts = m_CountBuffer->get_buffer();
+    command_buffer.fill_buffer(counts, 0, VK_WHOLE_SIZE, 0);
+    if (!VulkanContext::get()->is_draw_indirect_count_supported() && m_WrittenCommandCount > 0)
+    {
+        command_buffer.fill_buffer(commands, 0, sizeof(VkDrawIndexedIndirectCommand) * m_WrittenCommandCount, 0);
+        m_WrittenCommandCount = get_object_count();
+    }
+
+    for (VkBuffer buffer : { commands, counts })
+    {
+        command_buffer.buffer_barrier(buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    }
+
+    if (!m_Objects.empty())
+    {
+        command_buffer.bind_compute_pipeline(*m_Pipeline);
+        command_buffer.dispatch(m_Pipeline->get_group_count(get_object_count(), 0));
+    }
+
+    for (VkBuffer buffer : { commands, counts })
+    {
+        command_buffer.buffer_barrier(buffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+    }
+}
+
+RenderIndirectDraw GpuCulling::get_draw(u32 group) const
+{
+    RenderIndirectDraw draw;
+    draw.buffer = m_CommandBuffer->get_buffer();
+    draw.offset = static_cast<VkDeviceSize>(m_GroupFirstCommands[group]) * sizeof(VkDrawIndexedIndirectCommand);
+    draw.count_buffer = VulkanContext::get()->is_draw_indirect_count_supported() ? m_CountBuffer->get_buffer() : VK_NULL_HANDLE;
+    draw.count_offset = static_cast<VkDeviceSize>(group) * sizeof(u32);
+    draw.max_draw_count = m_GroupObjectCounts[group];
+    draw.stride = sizeof(VkDrawIndexedIndirectCommand);
+    return draw;
+}
+
+void GpuCulling::destroy()
+{
+    if (!m_Pipeline)
+        return;
+
+    m_Pipeline->destroy();
+    m_Pipeline.reset();
+    m_ParamsBuffer->destroy();
+    m_ObjectBuffer->destroy();
+    m_CommandBuffer->destroy();
+    m_CountBuffer->destroy();
+    m_ParamsBuffer.reset();
+    m_ObjectBuffer.reset();
+    m_CommandBuffer.reset();
+    m_CountBuffer.reset();
+}
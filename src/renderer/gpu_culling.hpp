@@ -0,0 +1,135 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#ifndef GPU_CULLING_HPP
+#define GPU_CULLING_HPP
+
+#include "render_queue.hpp"
+
+#include "core/types.hpp"
+#include "vulkan/shader_reflection.hpp"
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <type_traits>
+#include <vector>
+
+class CommandBuffer;
+class ComputePipeline;
+class Shader;
+class StorageBuffer;
+class VulkanBuffer;
+
+// Matches CullObject in res/shaders/cull.comp (std430). The draw of a visible object is
+// appended to the commands of its group, groups are drawn separately.
+struct CullObject
+{
+    glm::vec4 bounding_sphere = glm::vec4(0.0f); // center in the space cull() is given, radius in w
+    u32 index_count = 0;
+    u32 first_index = 0;
+    i32 vertex_offset = 0;
+    u32 first_instance = 0;
+    u32 group = 0;
+    u32 first_command = 0; // of the group, filled by set_objects
+    u32 reserved[2] = {};
+};
+static_assert(sizeof(CullObject) == 48 && std::is_trivially_copyable_v<CullObject>);
+
+// Bounding sphere of an object placed with transform, for CullObject::bounding_sphere. The
+// largest scale axis bounds the radius. A zero radius means unknown bounds, such objects are
+// never culled.
+static glm::vec4 transform_bounding_sphere(const glm::vec4 &sphere, const glm::mat4 &transform)
+{
+    if (sphere.w <= 0.0f)
+        return glm::vec4(glm::vec3(transform[3]), FLT_MAX);
+
+    const float scale = std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])),
+        glm::length(glm::vec3(transform[2])) });
+    return glm::vec4(glm::vec3(transform * glm::vec4(glm::vec3(sphere), 1.0f)), sphere.w * scale);
+}
+
+// Gribb-Hartmann planes as (normal, distance) with normals pointing inside, normalized so
+// dot(plane.xyz, p) + plane.w is a signed distance. Near is z >= 0, the camera projection
+// (glm::perspectiveZO) uses the [0, 1] depth range.
+static std::array<glm::vec4, 6> extract_frustum_planes(const glm::mat4 &view_projection)
+{
+    const glm::vec4 row_x = { view_projection[0][0], view_projection[1][0], view_projection[2][0], view_projection[3][0] };
+    const glm::vec4 row_y = { view_projection[0][1], view_projection[1][1], view_projection[2][1], view_projection[3][1] };
+    const glm::vec4 row_z = { view_projection[0][2], view_projection[1][2], view_projection[2][2], view_projection[3][2] };
+    const glm::vec4 row_w = { view_projection[0][3], view_projection[1][3], view_projection[2][3], view_projection[3][3] };
+
+    std::array<glm::vec4, 6> planes = {
+        row_w + row_x, // left
+        row_w - row_x, // right
+        row_w + row_y, // bottom
+        row_w - row_y, // top
+        row_z, // near
+        row_w - row_z, // far
+    };
+
+    for (glm::vec4 &plane : planes)
+        plane /= glm::length(glm::vec3(plane));
+    return planes;
+}
+
+// Frustum culling on the GPU. Objects are uploaded to a storage buffer, each frame one
+// dispatch appends the draws of the visible ones to an indirect buffer and one indirect count
+// draw per group consumes them, so recording does not depend on the object count.
+// Objects that differ in bound state, like the index type of their geometry, go to
+// different groups.
+class GpuCulling
+{
+public:
+    // cull_shader is res/shaders/cull.comp loaded with get_shader_macros()
+    GpuCulling(const Ref<Shader> &cull_shader, u32 max_object_count, u32 max_group_count);
+    ~GpuCulling();
+
+    // Macros of the cull shader on this device: CULL_SUBGROUP_BALLOT when compute shaders
+    // support ballots, otherwise every visible object takes its own atomic
+    static std::vector<ShaderMacro> get_shader_macros();
+
+    // Uploads the objects to cull, grouped so each group's commands are contiguous. False when
+    // there are more than max_object_count or a group is out of range.
+    bool set_objects(const std::vector<CullObject> &objects);
+
+    // Outside of a render pass. Resets the draw counts, culls every object with the planes of
+    // view_projection and makes the written draws visible to the draw indirect stage.
+    void cull(CommandBuffer &command_buffer, const glm::mat4 &view_projection);
+
+    // The visible draws of a group, for a packet with the group's pipeline and geometry.
+    // Without drawIndirectCount every object of the group is drawn, culled ones with no instances.
+    RenderIndirectDraw get_draw(u32 group) const;
+
+    void destroy();
+
+    u32 get_object_count() const { return static_cast<u32>(m_Objects.size()); }
+    u32 get_group_object_count(u32 group) const { return m_GroupObjectCounts[group]; }
+    u32 get_max_object_count() const { return m_MaxObjectCount; }
+    u32 get_max_group_count() const { return static_cast<u32>(m_GroupObjectCounts.size()); }
+
+private:
+    // Matches CullParams in res/shaders/cull.comp (std140)
+    struct CullParams
+    {
+        glm::vec4 frustum_planes[6];
+        u32 object_count;
+        u32 reserved[3];
+    };
+
+    Ref<ComputePipeline> m_Pipeline;
+    Ref<VulkanBuffer> m_ParamsBuffer;
+    Ref<StorageBuffer> m_ObjectBuffer;
+    Ref<StorageBuffer> m_CommandBuffer;
+    Ref<StorageBuffer> m_CountBuffer;
+
+    std::vector<CullObject> m_Objects; // with first_command, kept for its capacity
+    std::vector<u32> m_GroupObjectCounts;
+    std::vector<u32> m_GroupFirstCommands;
+    std::vector<u32> m_GroupCursors;
+    u32 m_MaxObjectCount;
+    u32 m_WrittenCommandCount; // commands the last cull may have written, all of them before the first
+};
+
+#endif
@@ -0,0 +1,102 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#include "instance_batcher.hpp"
+
+#include "core/hash.hpp"
+
+#include <cstring>
+
+size_t InstanceBatcher::BatchKeyHash::operator()(const BatchKey &key) const
+{
+    u64 hash = key.constants_hash;
+    hash_combine(hash, key.pipeline);
+    hash_combine(hash, key.material);
+    hash_combine(hash, key.geometry);
+    hash_combine(hash, key.index_count);
+    hash_combine(hash, key.first_index);
+    hash_combine(hash, key.vertex_offset);
+    hash_combine(hash, key.constants_size);
+    return static_cast<size_t>(hash);
+}
+
+InstanceBatcher::InstanceBatcher(u32 instance_stride)
+    : m_InstanceStride(instance_stride)
+{
+    ASSERT(m_InstanceStride > 0, "[InstanceBatcher] Instance stride must not be zero");
+}
+
+void InstanceBatcher::reset()
+{
+    m_BatchLookup.clear();
+    m_Batches.clear();
+    m_InstanceBatches.clear();
+    m_Submitted.clear();
+    m_Constants.clear();
+}
+
+void InstanceBatcher::add(const DrawPacket &draw, const void *instance_data, const void *constants, u32 constants_size)
+{
+    const BatchKey key = { draw.pipeline, draw.material, draw.geometry, draw.index_count, draw.first_index, draw.vertex_offset,
+        constants_size, constants_size > 0 ? hash_bytes(constants, constants_size) : 0 };
+
+    u32 batch = static_cast<u32>(m_Batches.size());
+    auto [it, inserted] = m_BatchLookup.try_emplace(key, batch);
+    const bool same_constants = !inserted && (constants_size == 0
+        || std::memcmp(m_Constants.data() + m_Batches[it->second].packet.constants_offset, constants, constants_size) == 0);
+
+    if (same_constants)
+    {
+        batch = it->second;
+    }
+    else
+    {
+        // New batch, or a hash collision which gets its own batch outside the lookup
+        DrawPacket packet = draw;
+        packet.constants_offset = static_cast<u32>(m_Constants.size());
+        packet.constants_size = constants_size;
+        if (constants_size > 0)
+        {
+            const u8 *bytes = static_cast<const u8 *>(constants);
+            m_Constants.insert(m_Constants.end(), bytes, bytes + constants_size);
+        }
+        m_Batches.push_back({ packet, 0 });
+    }
+
+    ++m_Batches[batch].instance_count;
+    m_InstanceBatches.push_back(batch);
+
+    const u8 *bytes = static_cast<const u8 *>(instance_data);
+    m_Submitted.insert(m_Submitted.end(), bytes, bytes + m_InstanceStride);
+}
+
+void InstanceBatcher::pack(DrawList &draw_list, u32 first_instance)
+{
+    // Counting sort of the submissions by batch, each batch keeps its submission order
+    m_Cursors.resize(m_Batches.size());
+    u32 offset = 0;
+    for (size_t i = 0; i < m_Batches.size(); ++i)
+    {
+        m_Cursors[i] = offset;
+        offset += m_Batches[i].instance_count;
+    }
+
+    m_Packed.resize(m_Submitted.size());
+    for (u32 i = 0; i < get_instance_count(); ++i)
+    {
+        const u32 slot = m_Cursors[m_InstanceBatches[i]]++;
+        std::memcpy(m_Packed.data() + static_cast<size_t>(slot) * m_InstanceStride,
+            m_Submitted.data() + static_cast<size_t>(i) * m_InstanceStride, m_InstanceStride);
+    }
+
+    // The cursors now point at the end of their batch
+    for (size_t i = 0; i < m_Batches.size(); ++i)
+    {
+        DrawPacket packet = m_Batches[i].packet;
+        packet.instance_count = m_Batches[i].instance_count;
+        packet.first_instance = first_instance + m_Cursors[i] - m_Batches[i].instance_count;
+        if (packet.constants_size > 0)
+            draw_list.push(packet, m_Constants.data() + packet.constants_offset, packet.constants_size);
+        else
+            draw_list.push(packet);
+    }
+}
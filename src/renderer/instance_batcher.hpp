@@ -0,0 +1,96 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#ifndef INSTANCE_BATCHER_HPP
+#define INSTANCE_BATCHER_HPP
+
+#include "render_queue.hpp"
+
+#include "core/assert.hpp"
+#include "core/types.hpp"
+
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Turns repeated submissions of the same draw into instanced draws. Submissions sharing
+// pipeline, material, geometry, index range and per-draw constants form one batch, their per-instance data is
+// packed contiguously for an InstanceBuffer and the batch becomes a single DrawPacket.
+// The geometry of those packets has to bind the instance buffer at the shader's
+// instance-rate binding, first_instance then selects the batch's range.
+class InstanceBatcher
+{
+public:
+    explicit InstanceBatcher(u32 instance_stride);
+
+    // Drops every submission, call once per frame
+    void reset();
+
+    // instance_data points at instance_stride bytes. The draw's instance_count and first_instance
+    // are ignored, the batch keeps the sort key of its first submission. Constants are shared by
+    // the whole batch, anything that differs per object belongs in the instance data.
+    void add(const DrawPacket &draw, const void *instance_data, const void *constants = nullptr, u32 constants_size = 0);
+
+    template<typename T>
+    void add(const DrawPacket &draw, const T &instance)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Instance data has to be trivially copyable");
+        ASSERT(sizeof(T) == m_InstanceStride, "[InstanceBatcher] Instance type does not match the stride");
+        add(draw, static_cast<const void *>(&instance));
+    }
+
+    template<typename T, typename C>
+    void add(const DrawPacket &draw, const T &instance, const C &constants)
+    {
+        static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_copyable_v<C>, "Instance data and constants have to be trivially copyable");
+        ASSERT(sizeof(T) == m_InstanceStride, "[InstanceBatcher] Instance type does not match the stride");
+        add(draw, static_cast<const void *>(&instance), &constants, static_cast<u32>(sizeof(C)));
+    }
+
+    // Groups the instances by batch and pushes one packet per batch, drawing its range of the
+    // packed instances placed at first_instance of the instance buffer
+    void pack(DrawList &draw_list, u32 first_instance = 0);
+
+    // Instance data of the last pack(), get_instance_count() instances of instance_stride bytes
+    const std::vector<u8> &get_packed_instances() const { return m_Packed; }
+
+    u32 get_instance_stride() const { return m_InstanceStride; }
+    u32 get_instance_count() const { return static_cast<u32>(m_InstanceBatches.size()); }
+    u32 get_batch_count() const { return static_cast<u32>(m_Batches.size()); }
+
+private:
+    struct BatchKey
+    {
+        u32 pipeline;
+        u32 material;
+        u32 geometry;
+        u32 index_count;
+        u32 first_index;
+        i32 vertex_offset;
+        u32 constants_size;
+        u64 constants_hash; // equal hashes are confirmed by comparing the bytes
+
+        bool operator==(const BatchKey &other) const = default;
+    };
+
+    struct BatchKeyHash
+    {
+        size_t operator()(const BatchKey &key) const;
+    };
+
+    struct Batch
+    {
+        DrawPacket packet; // constants_offset is into m_Constants
+        u32 instance_count = 0;
+    };
+
+    u32 m_InstanceStride;
+    std::unordered_map<BatchKey, u32, BatchKeyHash> m_BatchLookup;
+    std::vector<Batch> m_Batches;
+    std::vector<u32> m_InstanceBatches; // batch of every submission, in submission order
+    std::vector<u8> m_Submitted; // instance data in submission order
+    std::vector<u8> m_Packed; // instance data grouped by batch
+    std::vector<u8> m_Constants; // constants of every batch
+    std::vector<u32> m_Cursors;
+};
+
+#endif
@@ -1,3 +1,175 @@
 // Copyright 2025, Evangelion Manuhutu
 
-#include "mesh.hpp"
\ No newline at end of file
+#include "mesh.hpp"
+#include "mesh_archive.hpp"
+
+#include "core/assert.hpp"
+
+Mesh::Mesh(GeometryPool &pool, const MeshData &data)
+    : m_Name(data.name)
+{
+    ASSERT(pool.get_stream_count() == MESH_STREAM_COUNT && data.colors.size() == data.positions.size(),
+        "[Mesh] Mesh data has to provide every pool stream");
+
+    const u32 vertex_count = data.get_vertex_count();
+    const u32 index_count = static_cast<u32>(data.indices.size());
+    if (!pool.allocate(vertex_count, index_count, m_Range))
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[Mesh] Geometry pool is full, {} vertices and {} indices do not fit",
+            vertex_count, index_count);
+        return;
+    }
+
+    m_Pool = &pool;
+    m_Lods = data.lods;
+    if (m_Lods.empty())
+        m_Lods.push_back({ 0, index_count });
+    m_Meshlets = data.meshlets;
+    m_BoundingSphere = data.bounding_sphere;
+    if (m_BoundingSphere.w == 0.0f && index_count > 0)
+        m_BoundingSphere = compute_bounding_sphere(data.positions.data(), data.indices.data(), index_count);
+
+    glm::vec3 bounds_min = vertex_count > 0 ? data.positions[0] : glm::vec3(0.0f);
+    glm::vec3 bounds_max = bounds_min;
+    for (const glm::vec3 &position : data.positions)
+    {
+        bounds_min = glm::min(bounds_min, position);
+        bounds_max = glm::max(bounds_max, position);
+    }
+    m_Quantization = make_vertex_quantization(bounds_min, bounds_max);
+
+    std::vector<PackedPosition> positions(vertex_count);
+    std::vector<PackedColor> colors(vertex_count);
+    for (u32 i = 0; i < vertex_count; ++i)
+    {
+        positions[i] = encode_position(data.positions[i], m_Quantization);
+        colors[i] = encode_color(data.colors[i]);
+    }
+    pool.upload_stream(m_Range, MESH_STREAM_POSITION, positions.data());
+    pool.upload_stream(m_Range, MESH_STREAM_COLOR, colors.data());
+
+    if (index_count == 0)
+        return;
+    if (m_Range.index_type == VK_INDEX_TYPE_UINT16)
+    {
+        const std::vector<u16> indices(data.indices.begin(), data.indices.end());
+        pool.upload_indices(m_Range, indices.data());
+    }
+    else
+    {
+        pool.upload_indices(m_Range, data.indices.data());
+    }
+}
+
+Mesh::Mesh(GeometryPool &pool, const GeometryRange &range, const VertexQuantization &quantization, const std::string &name)
+    : m_Pool(&pool), m_Range(range), m_Quantization(quantization), m_Name(name)
+{
+    m_Lods.push_back({ 0, range.index_count });
+}
+
+Mesh::~Mesh()
+{
+    ASSERT(!m_Pool, "Forget to call destroy()");
+}
+
+Ref<Mesh> Mesh::create(GeometryPool &pool, const MeshData &data)
+{
+    Ref<Mesh> mesh = CreateRef<Mesh>(pool, data);
+    return mesh->is_valid() ? mesh : nullptr;
+}
+
+Ref<Mesh> Mesh::create(GeometryPool &pool, const MeshArchive &archive, u32 mesh)
+{
+    const MeshArchiveEntry &entry = archive.get_entry(mesh);
+
+    GeometryRange range;
+    if (!pool.allocate(entry.vertex_count, entry.index_count, range))
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[Mesh] Geometry pool is full, skipping {} with {} vertices",
+            entry.name, entry.vertex_count);
+        return nullptr;
+    }
+
+    // Blobs are in the arena layout already, the only copy is mapping -> staging
+    for (u32 stream = 0; stream < pool.get_stream_count(); ++stream)
+        pool.upload_stream(range, stream, archive.get_stream(entry, stream));
+    if (entry.index_count > 0)
+        pool.upload_indices(range, archive.get_indices(entry));
+
+    Ref<Mesh> result = CreateRef<Mesh>(pool, range, entry.quantization, entry.name);
+    result->m_BoundingSphere = entry.bounding_sphere;
+    result->m_Lods.assign(archive.get_lods(entry), archive.get_lods(entry) + entry.lod_count);
+    result->m_Meshlets.assign(archive.get_meshlets(entry), archive.get_meshlets(entry) + entry.meshlet_count);
+    return result;
+}
+
+void Mesh::fill_draw(DrawPacket &packet, u32 lod) const
+{
+    const MeshLod &range = m_Lods[std::min(lod, get_lod_count() - 1)];
+    packet.index_count = range.index_count;
+    packet.first_index = m_Range.first_index + range.first_index;
+    packet.vertex_offset = static_cast<i32>(m_Range.first_vertex);
+}
+
+u32 Mesh::select_lod(const glm::mat4 &transform, const glm::vec3 &camera_position, float screen_scale, float max_pixel_error) const
+{
+    // Errors grow along the chain, the largest scale axis bounds how far the transform stretches them
+    const glm::vec3 center = glm::vec3(transform * glm::vec4(glm::vec3(m_BoundingSphere), 1.0f));
+    const float scale = std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])),
+        glm::length(glm::vec3(transform[2])) });
+    const float distance = std::max(glm::length(center - camera_position) - m_BoundingSphere.w * scale, 1e-3f);
+    const float pixels_per_unit = scale * screen_scale / distance;
+
+    u32 lod = 0;
+    while (lod + 1 < get_lod_count() && m_Lods[lod + 1].error * pixels_per_unit <= max_pixel_error)
+        ++lod;
+    return lod;
+}
+
+void Mesh::destroy()
+{
+    if (!m_Pool)
+        return;
+
+    m_Pool->free(m_Range);
+    m_Pool = nullptr;
+    m_Range = {};
+}
+
+bool GeometryPoolImportSink::begin_mesh(u32 mesh, const ImportedMeshDesc &desc)
+{
+    if (m_Meshes.size() <= mesh)
+        m_Meshes.resize(mesh + 1);
+
+    GeometryRange range;
+    if (!m_Pool.allocate(desc.vertex_count, desc.index_count, range))
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[Mesh] Geometry pool is full, skipping {} with {} vertices",
+            desc.name, desc.vertex_count);
+        return false;
+    }
+
+    m_Meshes[mesh] = CreateRef<Mesh>(m_Pool, range, desc.quantization, desc.name);
+    return true;
+}
+
+void *GeometryPoolImportSink::map_vertices(u32 mesh, u32 stream, u32 first, u32 count)
+{
+    GeometryRange range = m_Meshes[mesh]->get_range();
+    range.first_vertex += first;
+    range.vertex_count = count;
+    return m_Pool.map_stream(range, stream);
+}
+
+void *GeometryPoolImportSink::map_indices(u32 mesh, u32 first, u32 count)
+{
+    GeometryRange range = m_Meshes[mesh]->get_range();
+    range.first_index += first;
+    range.index_count = count;
+    return m_Pool.map_indices(range);
+}
+
+void GeometryPoolImportSink::flush()
+{
+    m_Pool.flush();
+}
@@ -3,12 +3,94 @@
 #ifndef MESH_HPP
 #define MESH_HPP
 
+#include "geometry_pool.hpp"
+#include "mesh_data.hpp"
+#include "mesh_importer.hpp"
+#include "vertex.hpp"
+
+#include <vector>
+
+// Vertices and indices living in a range of a GeometryPool. A mesh owns no buffers, draws
+// bind the pool's geometry and select the mesh through first_index and vertex_offset.
+// Cooked meshes also carry their LOD chain and meshlets, other meshes have a single LOD.
+class MeshArchive;
+
+// Screen space error in pixels a LOD may show before a finer one is drawn
+static constexpr float MESH_LOD_PIXEL_ERROR = 1.0f;
+
 class Mesh
 {
 public:
+    // Packs the vertices and indices of data into staging memory, LOD 0 covers all indices
+    // unless data has LODs
+    Mesh(GeometryPool &pool, const MeshData &data);
+    // Takes over a range allocated from pool whose data the caller uploads, positions encoded with quantization
+    Mesh(GeometryPool &pool, const GeometryRange &range, const VertexQuantization &quantization, const std::string &name = {});
+    ~Mesh();
+
+    // nullptr when the pool has no room for the mesh. The upload is pending until pool.flush().
+    static Ref<Mesh> create(GeometryPool &pool, const MeshData &data);
+
+    // Copies the mesh's blobs from the mapped archive into staging memory, nullptr when the
+    // pool has no room. The upload is pending until pool.flush().
+    static Ref<Mesh> create(GeometryPool &pool, const MeshArchive &archive, u32 mesh);
+
+    // Sets the index range of the LOD and the vertex offset of the packet, the rest is up to the caller
+    void fill_draw(DrawPacket &packet, u32 lod = 0) const;
+
+    // Coarsest LOD whose error, projected at the distance of the transformed bounding sphere,
+    // stays within max_pixel_error. screen_scale is Camera::get_screen_scale().
+    u32 select_lod(const glm::mat4 &transform, const glm::vec3 &camera_position, float screen_scale,
+        float max_pixel_error = MESH_LOD_PIXEL_ERROR) const;
+
+    // Returns the range to the pool
+    void destroy();
+
+    bool is_valid() const { return m_Pool != nullptr; }
+    const GeometryRange &get_range() const { return m_Range; }
+    u32 get_vertex_count() const { return m_Range.vertex_count; }
+    u32 get_index_count() const { return m_Range.index_count; }
+    VkIndexType get_index_type() const { return m_Range.index_type; }
+    // Positions are stored quantized, draws pass this to the vertex shader
+    const VertexQuantization &get_quantization() const { return m_Quantization; }
+
+    const std::string &get_name() const { return m_Name; }
+    const glm::vec4 &get_bounding_sphere() const { return m_BoundingSphere; } // zero radius when unknown
+    u32 get_lod_count() const { return static_cast<u32>(m_Lods.size()); }
+    const MeshLod &get_lod(u32 lod) const { return m_Lods[lod]; }
+    const std::vector<Meshlet> &get_meshlets() const { return m_Meshlets; }
 
 private:
+    GeometryPool *m_Pool = nullptr;
+    GeometryRange m_Range;
+    VertexQuantization m_Quantization;
+    std::string m_Name;
+    glm::vec4 m_BoundingSphere = glm::vec4(0.0f);
+    std::vector<MeshLod> m_Lods; // LOD 0 covers every index unless cooked with a chain
+    std::vector<Meshlet> m_Meshlets;
+};
 
+// Imports straight into the staging memory of a GeometryPool, every imported mesh becomes a
+// Mesh. Meshes that do not fit in the pool are skipped and stay nullptr.
+class GeometryPoolImportSink : public MeshImportSink
+{
+public:
+    explicit GeometryPoolImportSink(GeometryPool &pool)
+        : m_Pool(pool)
+    {
+    }
+
+    bool begin_mesh(u32 mesh, const ImportedMeshDesc &desc) override;
+    void *map_vertices(u32 mesh, u32 stream, u32 first, u32 count) override;
+    void *map_indices(u32 mesh, u32 first, u32 count) override;
+    void flush() override;
+
+    // Indexed like the meshes passed to begin_mesh
+    const std::vector<Ref<Mesh>> &get_meshes() const { return m_Meshes; }
+
+private:
+    GeometryPool &m_Pool;
+    std::vector<Ref<Mesh>> m_Meshes;
 };
 
-#endif
\ No newline at end of file
+#endif
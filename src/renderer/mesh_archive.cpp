@@ -0,0 +1,244 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#include "mesh_archive.hpp"
+
+#include "core/binary_io.hpp"
+#include "core/logger.hpp"
+
+#include <cstring>
+#include <fstream>
+
+// Vertex stream exactly as the GeometryPool arena stores it
+static void write_stream(BinaryWriter &writer, const MeshData &mesh, u32 stream, const VertexQuantization &quantization)
+{
+    switch (stream)
+    {
+    case MESH_STREAM_POSITION:
+        for (const glm::vec3 &position : mesh.positions)
+            writer.write(encode_position(position, quantization));
+        break;
+    case MESH_STREAM_COLOR:
+        for (const glm::vec3 &color : mesh.colors)
+            writer.write(encode_color(color));
+        break;
+    default:
+        break;
+    }
+}
+
+static void write_indices(BinaryWriter &writer, const MeshData &mesh)
+{
+    if (get_mesh_index_type(mesh.get_vertex_count()) == VK_INDEX_TYPE_UINT16)
+    {
+        for (u32 index : mesh.indices)
+            writer.write(static_cast<u16>(index));
+    }
+    else
+    {
+        writer.write_bytes(mesh.indices.data(), mesh.indices.size() * sizeof(u32));
+    }
+}
+
+static bool is_range_valid(u64 offset, u64 count, u64 element_size, u64 file_size)
+{
+    return offset % MESH_ARCHIVE_ALIGNMENT == 0 && offset <= file_size && count <= (file_size - offset) / element_size;
+}
+
+bool MeshArchive::open(const std::filesystem::path &path)
+{
+    close();
+
+    if (!m_File.open(path))
+        return false;
+
+    const u8 *data = m_File.get_data();
+    const size_t size = m_File.get_size();
+
+    BinaryReader reader(data, size);
+    const MeshArchiveHeader header = reader.read<MeshArchiveHeader>();
+    bool header_valid = reader.is_valid()
+        && header.magic == MESH_ARCHIVE_MAGIC
+        && header.version == MESH_ARCHIVE_VERSION
+        && header.file_size == size
+        && header.index_offset % alignof(MeshArchiveEntry) == 0
+        && header.index_offset <= size
+        && header.mesh_count <= (size - header.index_offset) / sizeof(MeshArchiveEntry);
+
+    // Blobs are copied as they are, so they have to be in the layout this build uses
+    header_valid = header_valid && header.stream_count == MESH_STREAM_COUNT;
+    for (u32 stream = 0; header_valid && stream < MESH_STREAM_COUNT; ++stream)
+        header_valid = header.stream_strides[stream] == MESH_STREAM_STRIDES[stream];
+
+    if (!header_valid)
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[MeshArchive] Invalid or outdated archive {}", path.string());
+        m_File.close();
+        return false;
+    }
+
+    const MeshArchiveEntry *entries = reinterpret_cast<const MeshArchiveEntry *>(data + header.index_offset);
+    for (u32 i = 0; i < header.mesh_count; ++i)
+    {
+        const MeshArchiveEntry &entry = entries[i];
+        bool entry_valid = entry.lod_count > 0
+            && std::memchr(entry.name, 0, MESH_ARCHIVE_NAME_SIZE) != nullptr
+            && is_range_valid(entry.lod_offset, entry.lod_count, sizeof(MeshLod), size)
+            && is_range_valid(entry.meshlet_offset, entry.meshlet_count, sizeof(Meshlet), size)
+            && is_range_valid(entry.indices_offset, entry.index_count, get_index_size(get_mesh_index_type(entry.vertex_count)), size);
+        for (u32 stream = 0; entry_valid && stream < MESH_STREAM_COUNT; ++stream)
+            entry_valid = is_range_valid(entry.stream_offsets[stream], entry.vertex_count, MESH_STREAM_STRIDES[stream], size);
+
+        // Index values are not checked, that would touch every page of the file
+        const MeshLod *lods = entry_valid ? reinterpret_cast<const MeshLod *>(data + entry.lod_offset) : nullptr;
+        for (u32 lod = 0; entry_valid && lod < entry.lod_count; ++lod)
+        {
+            entry_valid = lods[lod].first_index <= entry.index_count && lods[lod].index_count <= entry.index_count - lods[lod].first_index
+                && lods[lod].first_meshlet <= entry.meshlet_count && lods[lod].meshlet_count <= entry.meshlet_count - lods[lod].first_meshlet;
+        }
+
+        if (!entry_valid)
+        {
+            Logger::get_instance().push_message(LoggingLevel::Error, "[MeshArchive] Corrupt entry {} in {}", i, path.string());
+            m_File.close();
+            return false;
+        }
+    }
+
+    m_Path = path;
+    m_Entries = entries;
+    m_MeshCount = header.mesh_count;
+
+    Logger::get_instance().push_message(LoggingLevel::Info, "[MeshArchive] Mapped {} ({} meshes, {} bytes)", path.string(), m_MeshCount, size);
+    return true;
+}
+
+void MeshArchive::close()
+{
+    m_File.close();
+    m_Entries = nullptr;
+    m_MeshCount = 0;
+    m_Path.clear();
+}
+
+const MeshLod *MeshArchive::get_lods(const MeshArchiveEntry &entry) const
+{
+    return reinterpret_cast<const MeshLod *>(m_File.get_data() + entry.lod_offset);
+}
+
+const Meshlet *MeshArchive::get_meshlets(const MeshArchiveEntry &entry) const
+{
+    return reinterpret_cast<const Meshlet *>(m_File.get_data() + entry.meshlet_offset);
+}
+
+const void *MeshArchive::get_stream(const MeshArchiveEntry &entry, u32 stream) const
+{
+    return m_File.get_data() + entry.stream_offsets[stream];
+}
+
+const void *MeshArchive::get_indices(const MeshArchiveEntry &entry) const
+{
+    return m_File.get_data() + entry.indices_offset;
+}
+
+void MeshArchiveWriter::add(MeshData mesh)
+{
+    m_Meshes.push_back(std::move(mesh));
+}
+
+bool MeshArchiveWriter::write(const std::filesystem::path &path) const
+{
+    std::vector<MeshArchiveEntry> index(m_Meshes.size());
+
+    // Blobs go after the index, fill the index while laying them out
+    BinaryWriter blobs;
+    const u64 index_offset = sizeof(MeshArchiveHeader);
+    const u64 blob_offset = index_offset + index.size() * sizeof(MeshArchiveEntry);
+    auto align_blob = [&blobs, blob_offset]()
+    {
+        while ((blob_offset + blobs.get_size()) % MESH_ARCHIVE_ALIGNMENT != 0)
+            blobs.write<u8>(0);
+        return blob_offset + blobs.get_size();
+    };
+
+    for (size_t i = 0; i < m_Meshes.size(); ++i)
+    {
+        const MeshData &mesh = m_Meshes[i];
+        MeshArchiveEntry &entry = index[i];
+        if (mesh.lods.empty() || mesh.colors.size() != mesh.positions.size())
+        {
+            Logger::get_instance().push_message(LoggingLevel::Error, "[MeshArchive] Mesh {} is not cooked", mesh.name);
+            return false;
+        }
+
+        entry = {};
+        std::strncpy(entry.name, mesh.name.c_str(), MESH_ARCHIVE_NAME_SIZE - 1);
+        entry.bounding_sphere = mesh.bounding_sphere;
+        glm::vec3 bounds_min = mesh.positions.empty() ? glm::vec3(0.0f) : mesh.positions[0];
+        glm::vec3 bounds_max = bounds_min;
+        for (const glm::vec3 &position : mesh.positions)
+        {
+            bounds_min = glm::min(bounds_min, position);
+            bounds_max = glm::max(bounds_max, position);
+        }
+        entry.quantization = make_vertex_quantization(bounds_min, bounds_max);
+        entry.vertex_count = mesh.get_vertex_count();
+        entry.index_count = static_cast<u32>(mesh.indices.size());
+        entry.lod_count = static_cast<u32>(mesh.lods.size());
+        entry.meshlet_count = static_cast<u32>(mesh.meshlets.size());
+
+        entry.lod_offset = align_blob();
+        blobs.write_bytes(mesh.lods.data(), mesh.lods.size() * sizeof(MeshLod));
+        entry.meshlet_offset = align_blob();
+        blobs.write_bytes(mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet));
+
+        for (u32 stream = 0; stream < MESH_STREAM_COUNT; ++stream)
+        {
+            entry.stream_offsets[stream] = align_blob();
+            write_stream(blobs, mesh, stream, entry.quantization);
+        }
+
+        entry.indices_offset = align_blob();
+        write_indices(blobs, mesh);
+    }
+
+    MeshArchiveHeader header = {};
+    header.magic = MESH_ARCHIVE_MAGIC;
+    header.version = MESH_ARCHIVE_VERSION;
+    header.mesh_count = static_cast<u32>(index.size());
+    header.stream_count = MESH_STREAM_COUNT;
+    for (u32 stream = 0; stream < MESH_STREAM_COUNT; ++stream)
+        header.stream_strides[stream] = MESH_STREAM_STRIDES[stream];
+    header.index_offset = index_offset;
+    header.file_size = blob_offset + blobs.get_size();
+
+    std::filesystem::path temp_path = path;
+    temp_path += ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            Logger::get_instance().push_message(LoggingLevel::Error, "[MeshArchive] Could not write {}", temp_path.string());
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(MeshArchiveEntry)));
+        file.write(reinterpret_cast<const char *>(blobs.get_buffer().data()), static_cast<std::streamsize>(blobs.get_size()));
+        if (!file)
+        {
+            Logger::get_instance().push_message(LoggingLevel::Error, "[MeshArchive] Could not write {}", temp_path.string());
+            return false;
+        }
+    }
+
+    // The running engine may have the old archive mapped, replace it rather than overwrite it in place
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec)
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[MeshArchive] Could not replace {}: {}", path.string(), ec.message());
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
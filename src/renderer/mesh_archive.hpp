@@ -0,0 +1,98 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#ifndef MESH_ARCHIVE_HPP
+#define MESH_ARCHIVE_HPP
+
+#include "mesh_data.hpp"
+
+#include "core/mapped_file.hpp"
+
+#include <filesystem>
+
+// Cooked meshes packed into one file:
+//   MeshArchiveHeader
+//   MeshArchiveEntry[mesh_count]
+//   per mesh: MeshLod[lod_count], Meshlet[meshlet_count], then every vertex stream and the
+//   indices, each in the exact layout of the GeometryPool arenas and aligned to MESH_ARCHIVE_ALIGNMENT
+// The file is mapped and its blobs are copied into staging memory as they are, loading does
+// no decoding at all. Vertices are stored quantized and indices in the mesh's index type, the
+// same packed formats the runtime importer writes. Data is in host byte order.
+static constexpr u32 MESH_ARCHIVE_MAGIC = 0x4853454D; // 'MESH'
+static constexpr u32 MESH_ARCHIVE_VERSION = 2;
+static constexpr u32 MESH_ARCHIVE_ALIGNMENT = 256;
+static constexpr u32 MESH_ARCHIVE_MAX_STREAMS = 8;
+static constexpr u32 MESH_ARCHIVE_NAME_SIZE = 64;
+
+struct MeshArchiveHeader
+{
+    u32 magic;
+    u32 version;
+    u32 mesh_count;
+    u32 stream_count;
+    u32 stream_strides[MESH_ARCHIVE_MAX_STREAMS]; // must match MESH_STREAM_STRIDES
+    u64 index_offset;
+    u64 file_size;
+};
+
+struct MeshArchiveEntry
+{
+    char name[MESH_ARCHIVE_NAME_SIZE]; // null terminated, truncated
+    glm::vec4 bounding_sphere;
+    VertexQuantization quantization; // decodes the positions
+    u32 vertex_count;
+    u32 index_count; // of every LOD
+    u32 lod_count;
+    u32 meshlet_count;
+    u64 lod_offset;
+    u64 meshlet_offset;
+    u64 stream_offsets[MESH_ARCHIVE_MAX_STREAMS];
+    u64 indices_offset; // of get_mesh_index_type(vertex_count)
+};
+
+class MeshArchive
+{
+public:
+    MeshArchive() = default;
+
+    MeshArchive(const MeshArchive &) = delete;
+    MeshArchive &operator=(const MeshArchive &) = delete;
+
+    // Maps the archive and validates every range, false when missing, malformed or cooked
+    // for other vertex streams
+    bool open(const std::filesystem::path &path);
+    void close();
+    bool is_open() const { return m_Entries != nullptr; }
+
+    u32 get_mesh_count() const { return m_MeshCount; }
+    const MeshArchiveEntry &get_entry(u32 mesh) const { return m_Entries[mesh]; }
+
+    // Point into the mapping, valid while the archive is open
+    const MeshLod *get_lods(const MeshArchiveEntry &entry) const;
+    const Meshlet *get_meshlets(const MeshArchiveEntry &entry) const;
+    const void *get_stream(const MeshArchiveEntry &entry, u32 stream) const;
+    const void *get_indices(const MeshArchiveEntry &entry) const;
+
+    const std::filesystem::path &get_path() const { return m_Path; }
+
+private:
+    MappedFile m_File;
+    std::filesystem::path m_Path;
+    const MeshArchiveEntry *m_Entries = nullptr;
+    u32 m_MeshCount = 0;
+};
+
+// Builds an archive in memory, used by the offline MeshCooker
+class MeshArchiveWriter
+{
+public:
+    // The mesh needs its LODs and meshlets, see build_meshlets
+    void add(MeshData mesh);
+    bool write(const std::filesystem::path &path) const;
+
+    size_t get_mesh_count() const { return m_Meshes.size(); }
+
+private:
+    std::vector<MeshData> m_Meshes;
+};
+
+#endif
@@ -0,0 +1,115 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#include "mesh_data.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static glm::vec4 compute_normal_cone(const MeshData &mesh, const u32 *indices, u32 index_count)
+{
+    glm::vec3 normal_sum(0.0f);
+    std::vector<glm::vec3> normals;
+    normals.reserve(index_count / 3);
+    for (u32 i = 0; i + 2 < index_count; i += 3)
+    {
+        const glm::vec3 &a = mesh.positions[indices[i]];
+        const glm::vec3 cross = glm::cross(mesh.positions[indices[i + 1]] - a, mesh.positions[indices[i + 2]] - a);
+        const float length = glm::length(cross);
+        if (length <= 0.0f)
+            continue;
+        normals.push_back(cross / length);
+        normal_sum += normals.back();
+    }
+
+    const float sum_length = glm::length(normal_sum);
+    if (normals.empty() || sum_length <= 0.0f)
+        return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+    const glm::vec3 axis = normal_sum / sum_length;
+    float min_dot = 1.0f;
+    for (const glm::vec3 &normal : normals)
+        min_dot = std::min(min_dot, glm::dot(axis, normal));
+
+    // A spread of 90 degrees or more faces every direction
+    if (min_dot <= 0.0f)
+        return glm::vec4(axis, 1.0f);
+
+    return glm::vec4(axis, std::sqrt(1.0f - min_dot * min_dot));
+}
+
+void build_meshlets(MeshData &mesh)
+{
+    if (mesh.lods.empty())
+    {
+        MeshLod lod;
+        lod.index_count = static_cast<u32>(mesh.indices.size());
+        mesh.lods.push_back(lod);
+    }
+
+    mesh.meshlets.clear();
+    mesh.bounding_sphere = compute_bounding_sphere(mesh.positions.data(), mesh.indices.data(), mesh.lods[0].index_count);
+
+    // Local vertex slots of the open meshlet, stamped with the meshlet number instead of cleared
+    std::vector<u32> vertex_stamp(mesh.positions.size(), ~0u);
+    for (MeshLod &lod : mesh.lods)
+    {
+        lod.first_meshlet = static_cast<u32>(mesh.meshlets.size());
+
+        // Trailing indices that do not form a triangle are left out, no meshlet could take them
+        const u32 lod_end = lod.first_index + lod.index_count - lod.index_count % 3;
+        u32 begin = lod.first_index;
+        while (begin < lod_end)
+        {
+            const u32 stamp = static_cast<u32>(mesh.meshlets.size());
+            u32 vertex_count = 0;
+            u32 end = begin;
+            while (end + 2 < lod_end && (end - begin) / 3 < MESHLET_MAX_TRIANGLES)
+            {
+                u32 new_vertices = 0;
+                for (u32 k = 0; k < 3; ++k)
+                    new_vertices += vertex_stamp[mesh.indices[end + k]] != stamp;
+                if (vertex_count + new_vertices > MESHLET_MAX_VERTICES)
+                    break;
+
+                for (u32 k = 0; k < 3; ++k)
+                    vertex_stamp[mesh.indices[end + k]] = stamp;
+                vertex_count += new_vertices;
+                end += 3;
+            }
+
+            Meshlet meshlet;
+            meshlet.first_index = begin;
+            meshlet.index_count = end - begin;
+            meshlet.bounding_sphere = compute_bounding_sphere(mesh.positions.data(), mesh.indices.data() + begin, meshlet.index_count);
+            meshlet.cone = compute_normal_cone(mesh, mesh.indices.data() + begin, meshlet.index_count);
+            mesh.meshlets.push_back(meshlet);
+            begin = end;
+        }
+
+        lod.meshlet_count = static_cast<u32>(mesh.meshlets.size()) - lod.first_meshlet;
+    }
+}
+
+bool MeshDataImportSink::begin_mesh(u32 mesh, const ImportedMeshDesc &desc)
+{
+    if (m_Meshes.size() <= mesh)
+        m_Meshes.resize(mesh + 1);
+
+    MeshData &data = m_Meshes[mesh];
+    data.name = desc.name;
+    data.positions.resize(desc.vertex_count);
+    data.colors.resize(desc.vertex_count);
+    data.indices.resize(desc.index_count);
+    return true;
+}
+
+void *MeshDataImportSink::map_vertices(u32 mesh, u32 stream, u32 first, u32 count)
+{
+    MeshData &data = m_Meshes[mesh];
+    return (stream == MESH_STREAM_POSITION ? data.positions.data() : data.colors.data()) + first;
+}
+
+void *MeshDataImportSink::map_indices(u32 mesh, u32 first, u32 count)
+{
+    return m_Meshes[mesh].indices.data() + first;
+}
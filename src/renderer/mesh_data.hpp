@@ -0,0 +1,105 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#ifndef MESH_DATA_HPP
+#define MESH_DATA_HPP
+
+#include "mesh_importer.hpp"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Meshlet limits, small enough for the triangles of one meshlet to share a few vertex cache lines
+static constexpr u32 MESHLET_MAX_VERTICES = 64;
+static constexpr u32 MESHLET_MAX_TRIANGLES = 124;
+
+// One level of detail, a range of the mesh's indices over the shared vertices
+struct MeshLod
+{
+    u32 first_index = 0; // relative to the mesh
+    u32 index_count = 0;
+    u32 first_meshlet = 0;
+    u32 meshlet_count = 0;
+    float error = 0.0f; // object space deviation from LOD 0
+    u32 reserved[3] = {};
+};
+static_assert(sizeof(MeshLod) == 32 && std::is_trivially_copyable_v<MeshLod>);
+
+// Triangles of a mesh that are culled together, their indices are contiguous. The bounding
+// sphere and index range are what a CullObject of the meshlet takes.
+struct Meshlet
+{
+    glm::vec4 bounding_sphere = glm::vec4(0.0f); // object space center, radius in w
+    // Normal cone: every triangle faces away from an eye where
+    // dot(center - eye, cone.xyz) >= cone.w * length(center - eye) + radius. cone.w is 1 when they never all do.
+    glm::vec4 cone = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    u32 first_index = 0; // relative to the mesh
+    u32 index_count = 0;
+    u32 reserved[2] = {};
+};
+static_assert(sizeof(Meshlet) == 48 && std::is_trivially_copyable_v<Meshlet>);
+
+// Geometry of one mesh in CPU memory, what the offline cooking steps work on
+struct MeshData
+{
+    std::string name;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> colors;
+    std::vector<u32> indices; // every LOD's triangles, LOD 0 first
+    std::vector<MeshLod> lods; // empty until cooked, then at least LOD 0
+    std::vector<Meshlet> meshlets;
+    glm::vec4 bounding_sphere = glm::vec4(0.0f);
+
+    u32 get_vertex_count() const { return static_cast<u32>(positions.size()); }
+};
+
+// Bounding sphere of the referenced vertices, centered on their bounds
+static glm::vec4 compute_bounding_sphere(const glm::vec3 *positions, const u32 *indices, u32 index_count)
+{
+    if (index_count == 0)
+        return glm::vec4(0.0f);
+
+    glm::vec3 min = positions[indices[0]];
+    glm::vec3 max = min;
+    for (u32 i = 1; i < index_count; ++i)
+    {
+        min = glm::min(min, positions[indices[i]]);
+        max = glm::max(max, positions[indices[i]]);
+    }
+
+    const glm::vec3 center = (min + max) * 0.5f;
+    float radius_squared = 0.0f;
+    for (u32 i = 0; i < index_count; ++i)
+    {
+        const glm::vec3 offset = positions[indices[i]] - center;
+        radius_squared = std::max(radius_squared, glm::dot(offset, offset));
+    }
+    return glm::vec4(center, std::sqrt(radius_squared));
+}
+
+// Splits the triangles of every LOD into meshlets in index order and fills bounds, meshlets and
+// lod meshlet ranges. A mesh without LODs gets LOD 0 over all indices first.
+void build_meshlets(MeshData &mesh);
+
+// Collects imported meshes in memory for the offline tools, never runs out of space. The
+// importer writes straight into the MeshData at full precision, positions are quantized once
+// when a mesh is packed for the GPU.
+class MeshDataImportSink : public MeshImportSink
+{
+public:
+    MeshImportFormat get_format() const override { return MeshImportFormat::Float; }
+    bool begin_mesh(u32 mesh, const ImportedMeshDesc &desc) override;
+    void *map_vertices(u32 mesh, u32 stream, u32 first, u32 count) override;
+    void *map_indices(u32 mesh, u32 first, u32 count) override;
+    void flush() override {}
+
+    std::vector<MeshData> &get_meshes() { return m_Meshes; }
+
+private:
+    std::vector<MeshData> m_Meshes;
+};
+
+#endif
@@ -0,0 +1,798 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#include "mesh_importer.hpp"
+
+#include "core/json.hpp"
+#include "core/logger.hpp"
+#include "core/mapped_file.hpp"
+#include "core/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cfloat>
+#include <cstring>
+#include <format>
+#include <type_traits>
+
+// Elements decoded by one job, small enough to balance across workers and to fit staging
+// memory many times over
+static constexpr u32 IMPORT_JOB_ELEMENT_COUNT = 64 * 1024;
+// OBJ text parsed by one job, about as many vertices as IMPORT_JOB_ELEMENT_COUNT
+static constexpr size_t OBJ_CHUNK_SIZE = 1024 * 1024;
+
+static constexpr u32 GLB_MAGIC = 0x46546C67; // "glTF"
+static constexpr u32 GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+static constexpr u32 GLB_CHUNK_BIN = 0x004E4942; // "BIN\0"
+
+static constexpr u32 GLTF_COMPONENT_BYTE = 5120;
+static constexpr u32 GLTF_COMPONENT_UNSIGNED_BYTE = 5121;
+static constexpr u32 GLTF_COMPONENT_SHORT = 5122;
+static constexpr u32 GLTF_COMPONENT_UNSIGNED_SHORT = 5123;
+static constexpr u32 GLTF_COMPONENT_UNSIGNED_INT = 5125;
+static constexpr u32 GLTF_COMPONENT_FLOAT = 5126;
+static constexpr u32 GLTF_MODE_TRIANGLES = 4;
+
+MeshImporter::MeshImporter(ThreadPool *thread_pool)
+    : m_ThreadPool(thread_pool ? thread_pool : &ThreadPool::get_instance())
+{
+}
+
+bool MeshImporter::import(const std::filesystem::path &path, MeshImportSink &sink)
+{
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+
+    if (extension == ".glb" || extension == ".gltf")
+        return import_gltf(path, sink);
+    if (extension == ".obj")
+        return import_obj(path, sink);
+
+    Logger::get_instance().push_message(LoggingLevel::Error, "[MeshImporter] Unsupported mesh format {}", path.string());
+    return false;
+}
+
+bool MeshImporter::run_jobs(std::vector<ImportJob> &jobs, MeshImportSink &sink)
+{
+    std::vector<void *> destinations;
+    size_t next = 0;
+    bool flushed = false;
+    while (next < jobs.size())
+    {
+        // Destinations are mapped serially, the sink does not have to be thread safe
+        const size_t wave_begin = next;
+        destinations.clear();
+        for (; next < jobs.size(); ++next)
+        {
+            const ImportJob &job = jobs[next];
+            void *mapped[MAX_JOB_TARGETS] = {};
+            bool complete = true;
+            for (u32 i = 0; i < job.target_count && complete; ++i)
+            {
+                const ImportTarget &target = job.targets[i];
+                if (target.count == 0)
+                    continue;
+                mapped[i] = target.stream == INDEX_TARGET
+                    ? sink.map_indices(job.mesh, target.first, target.count)
+                    : sink.map_vertices(job.mesh, target.stream, target.first, target.count);
+                complete = mapped[i] != nullptr;
+            }
+
+            // A job that only partly fit is mapped again after the flush. The ranges it already
+            // got are copied unwritten, the second copy overwrites them.
+            if (!complete)
+                break;
+            destinations.insert(destinations.end(), mapped, mapped + MAX_JOB_TARGETS);
+        }
+
+        const u32 wave_size = static_cast<u32>(next - wave_begin);
+        if (wave_size == 0)
+        {
+            if (flushed)
+            {
+                Logger::get_instance().push_message(LoggingLevel::Error, "[MeshImporter] Sink has no room for a single job");
+                return false;
+            }
+            sink.flush();
+            flushed = true;
+            continue;
+        }
+
+        m_ThreadPool->parallel_for(wave_size, [&](u32 begin, u32 end)
+        {
+            for (u32 i = begin; i < end; ++i)
+                jobs[wave_begin + i].decode(destinations.data() + static_cast<size_t>(i) * MAX_JOB_TARGETS);
+        });
+
+        sink.flush();
+        flushed = true;
+    }
+    return true;
+}
+
+// Element i of a stream in the layout the sink asked for
+static void write_position(void *dst, u32 i, const glm::vec3 &position, const VertexQuantization &quantization, MeshImportFormat format)
+{
+    if (format == MeshImportFormat::Float)
+        static_cast<glm::vec3 *>(dst)[i] = position;
+    else
+        static_cast<PackedPosition *>(dst)[i] = encode_position(position, quantization);
+}
+
+static void write_color(void *dst, u32 i, const glm::vec3 &color, MeshImportFormat format)
+{
+    if (format == MeshImportFormat::Float)
+        static_cast<glm::vec3 *>(dst)[i] = color;
+    else
+        static_cast<PackedColor *>(dst)[i] = encode_color(color);
+}
+
+// ====== glTF ======
+namespace
+{
+    struct GltfBuffer
+    {
+        const u8 *data = nullptr;
+        size_t size = 0;
+    };
+
+    // Strided view of one accessor, validated against its buffer
+    struct GltfAccessor
+    {
+        const u8 *data = nullptr;
+        u32 count = 0;
+        u32 stride = 0;
+        u32 component_type = 0;
+        u32 component_count = 0;
+        bool normalized = false;
+        bool has_bounds = false; // min and max are given for three components
+        glm::vec3 min = glm::vec3(0.0f);
+        glm::vec3 max = glm::vec3(0.0f);
+    };
+}
+
+static u32 get_gltf_component_size(u32 component_type)
+{
+    switch (component_type)
+    {
+    case GLTF_COMPONENT_BYTE:
+    case GLTF_COMPONENT_UNSIGNED_BYTE: return 1;
+    case GLTF_COMPONENT_SHORT:
+    case GLTF_COMPONENT_UNSIGNED_SHORT: return 2;
+    case GLTF_COMPONENT_UNSIGNED_INT:
+    case GLTF_COMPONENT_FLOAT: return 4;
+    default: return 0;
+    }
+}
+
+static u32 get_gltf_component_count(std::string_view type)
+{
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    return 0;
+}
+
+template<typename T>
+static T load_unaligned(const u8 *data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+static float read_gltf_component(const u8 *data, u32 component_type, bool normalized)
+{
+    switch (component_type)
+    {
+    case GLTF_COMPONENT_FLOAT: return load_unaligned<float>(data);
+    case GLTF_COMPONENT_UNSIGNED_BYTE: return normalized ? data[0] / 255.0f : data[0];
+    case GLTF_COMPONENT_UNSIGNED_SHORT:
+    {
+        const u16 value = load_unaligned<u16>(data);
+        return normalized ? value / 65535.0f : value;
+    }
+    case GLTF_COMPONENT_BYTE:
+    {
+        const float value = static_cast<signed char>(data[0]);
+        return normalized ? std::max(value / 127.0f, -1.0f) : value;
+    }
+    case GLTF_COMPONENT_SHORT:
+    {
+        const float value = load_unaligned<i16>(data);
+        return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+    }
+    case GLTF_COMPONENT_UNSIGNED_INT: return static_cast<float>(load_unaligned<u32>(data));
+    default: return 0.0f;
+    }
+}
+
+static u32 read_gltf_index(const u8 *data, u32 component_type)
+{
+    switch (component_type)
+    {
+    case GLTF_COMPONENT_UNSIGNED_BYTE: return data[0];
+    case GLTF_COMPONENT_UNSIGNED_SHORT: return load_unaligned<u16>(data);
+    default: return load_unaligned<u32>(data);
+    }
+}
+
+static bool resolve_gltf_accessor(const JsonValue &document, const std::vector<GltfBuffer> &buffers, u32 index, GltfAccessor &accessor)
+{
+    const JsonValue *accessors = document.find("accessors");
+    const JsonValue *views = document.find("bufferViews");
+    if (!accessors || !accessors->is_array() || index >= accessors->size() || !views || !views->is_array())
+        return false;
+
+    // Sparse accessors and accessors without a view (all zeros) do not occur in mesh exports
+    const JsonValue &desc = (*accessors)[index];
+    const u32 view_index = desc.get_u32("bufferView", ~0u);
+    if (desc.find("sparse") || view_index >= views->size())
+        return false;
+
+    const JsonValue &view = (*views)[view_index];
+    const u32 buffer_index = view.get_u32("buffer", ~0u);
+    if (buffer_index >= buffers.size() || !buffers[buffer_index].data)
+        return false;
+
+    accessor.component_type = desc.get_u32("componentType");
+    accessor.component_count = get_gltf_component_count(desc.get_string("type"));
+    accessor.normalized = desc.find("normalized") && desc.find("normalized")->as_bool();
+    accessor.count = desc.get_u32("count");
+
+    const u32 element_size = get_gltf_component_size(accessor.component_type) * accessor.component_count;
+    if (element_size == 0)
+        return false;
+    accessor.stride = std::max(view.get_u32("byteStride"), element_size);
+
+    const GltfBuffer &buffer = buffers[buffer_index];
+    const u64 view_offset = view.get_u32("byteOffset");
+    const u64 view_length = view.get_u32("byteLength");
+    const u64 offset = desc.get_u32("byteOffset");
+    if (view_offset + view_length > buffer.size)
+        return false;
+    if (accessor.count > 0 && offset + static_cast<u64>(accessor.stride) * (accessor.count - 1) + element_size > view_length)
+        return false;
+
+    accessor.data = buffer.data + view_offset + offset;
+
+    // Required for positions, but in component units, so only float bounds are usable directly
+    const JsonValue *min = desc.find("min");
+    const JsonValue *max = desc.find("max");
+    accessor.has_bounds = accessor.component_type == GLTF_COMPONENT_FLOAT && min && max && min->is_array() && max->is_array()
+        && min->size() >= 3 && max->size() >= 3;
+    for (u32 c = 0; accessor.has_bounds && c < 3; ++c)
+    {
+        accessor.min[c] = static_cast<float>((*min)[c].as_number());
+        accessor.max[c] = static_cast<float>((*max)[c].as_number());
+    }
+    return true;
+}
+
+static void get_gltf_position_bounds(const GltfAccessor &positions, glm::vec3 &min, glm::vec3 &max)
+{
+    if (positions.has_bounds)
+    {
+        min = positions.min;
+        max = positions.max;
+        return;
+    }
+
+    const u32 component_size = get_gltf_component_size(positions.component_type);
+    min = glm::vec3(FLT_MAX);
+    max = glm::vec3(-FLT_MAX);
+    const u8 *src = positions.data;
+    for (u32 i = 0; i < positions.count; ++i, src += positions.stride)
+    {
+        for (u32 c = 0; c < 3; ++c)
+        {
+            const float value = read_gltf_component(src + c * component_size, positions.component_type, positions.normalized);
+            min[c] = std::min(min[c], value);
+            max[c] = std::max(max[c], value);
+        }
+    }
+}
+
+bool MeshImporter::import_gltf(const std::filesystem::path &path, MeshImportSink &sink)
+{
+    const MeshImportFormat format = sink.get_format();
+    MappedFile file;
+    if (!file.open(path))
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[MeshImporter] Could not open {}", path.string());
+        return false;
+    }
+
+    std::string_view json_text;
+    GltfBuffer binary_chunk;
+    if (file.get_size() >= 12 && load_unaligned<u32>(file.get_data()) == GLB_MAGIC)
+    {
+        // Header, then a JSON chunk and an optional BIN chunk, each with length and type
+        const u32 version = load_unaligned<u32>(file.get_data() + 4);
+        const size_t length = std::min<size_t>(load_unaligned<u32>(file.get_data() + 8), file.get_size());
+        size_t offset = 12;
+        while (version == 2 && offset + 8 <= length)
+        {
+            const u32 chunk_length = load_unaligned<u32>(file.get_data() + offset);
+            const u32 chunk_type = load_unaligned<u32>(file.get_data() + offset + 4);
+            offset += 8;
+            if (offset + chunk_length > length)
+                break;
+
+            if (chunk_type == GLB_CHUNK_JSON && json_text.empty())
+                json_text = std::string_view(reinterpret_cast<const char *>(file.get_data() + offset), chunk_length);
+            else if (chunk_type == GLB_CHUNK_BIN && !binary_chunk.data)
+                binary_chunk = { file.get_data() + offset, chunk_length };
+            offset += (static_cast<size_t>(chunk_length) + 3) & ~static_cast<size_t>(3);
+        }
+
+        if (version != 2 || json_text.empty())
+        {
+            Logger::get_instance().push_message(LoggingLevel::Error, "[MeshImporter] {} is not a glTF 2.0 binary", path.string());
+            return false;
+        }
+    }
+    else
+    {
+        json_text = std::string_view(reinterpret_cast<const char *>(file.get_data()), file.get_size());
+    }
+
+    JsonValue document;
+    std::string error;
+    if (!JsonValue::parse(json_text, document, &error) || !document.is_object())
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[MeshImporter] Invalid glTF in {}: {}", path.string(), error);
+        return false;
+    }
+
+    // Buffer 0 without uri is the BIN chunk, the others are mapped from files next to the asset
+    std::vector<GltfBuffer> buffers;
+    std::vector<Scope<MappedFile>> buffer_files;
+    if (const JsonValue *buffer_descs = document.find("buffers"); buffer_descs && buffer_descs->is_array())
+    {
+        for (size_t i = 0; i < buffer_descs->size(); ++i)
+        {
+            const std::string_view uri = (*buffer_descs)[i].get_string("uri");
+            GltfBuffer buffer;
+            if (uri.empty())
+            {
+                if (i == 0)
+                    buffer = binary_chunk;
+            }
+            else if (uri.starts_with("data:"))
+            {
+                Logger::get_instance().push_message(LoggingLevel::Warning, "[MeshImporter] Embedded data URIs are not supported in {}",
+                    path.string());
+            }
+            else
+            {
+                Scope<MappedFile> buffer_file = CreateScope<MappedFile>();
+                const std::filesystem::path buffer_path = path.parent_path() / std::filesystem::path(uri);
+                if (buffer_file->open(buffer_path))
+                {
+                    buffer = { buffer_file->get_data(), buffer_file->get_size() };
+                    buffer_files.push_back(std::move(buffer_file));
+                }
+                else
+                {
+                    Logger::get_instance().push_message(LoggingLevel::Warning, "[MeshImporter] Could not open buffer {}", buffer_path.string());
+                }
+            }
+
+            // The declared length may be shorter than the padded chunk
+            buffer.size = std::min<size_t>(buffer.size, (*buffer_descs)[i].get_u32("byteLength"));
+            buffers.push_back(buffer);
+        }
+    }
+
+    std::vector<ImportJob> jobs;
+    u32 mesh_index = 0;
+    const JsonValue *meshes = document.find("meshes");
+    for (size_t m = 0; meshes && meshes->is_array() && m < meshes->size(); ++m)
+    {
+        const JsonValue &mesh = (*meshes)[m];
+        const JsonValue *primitives = mesh.find("primitives");
+        const std::string_view mesh_name = mesh.get_string("name");
+        for (size_t p = 0; primitives && primitives->is_array() && p < primitives->size(); ++p)
+        {
+            const JsonValue &primitive = (*primitives)[p];
+            const JsonValue *attributes = primitive.find("attributes");
+            if (primitive.get_u32("mode", GLTF_MODE_TRIANGLES) != GLTF_MODE_TRIANGLES || !attributes)
+                continue;
+
+            GltfAccessor positions;
+            GltfAccessor colors;
+            GltfAccessor indices;
+            const bool has_colors = attributes->find("COLOR_0") != nullptr;
+            const bool has_indices = primitive.find("indices") != nullptr;
+            if (!resolve_gltf_accessor(document, buffers, attributes->get_u32("POSITION", ~0u), positions) || positions.component_count != 3
+                || (has_colors && (!resolve_gltf_accessor(document, buffers, attributes->get_u32("COLOR_0"), colors) || colors.component_count < 3
+                    || colors.count != positions.count))
+                || (has_indices && (!resolve_gltf_accessor(document, buffers, primitive.get_u32("indices"), indices) || indices.component_count != 1
+                    || indices.component_type == GLTF_COMPONENT_FLOAT)))
+            {
+                Logger::get_instance().push_message(LoggingLevel::Warning, "[MeshImporter] Skipping primitive {} of mesh {} in {}, unsupported accessors",
+                    p, m, path.string());
+                continue;
+            }
+
+            ImportedMeshDesc desc;
+            desc.name = primitives->size() > 1 ? std::format("{}[{}]", mesh_name, p) : std::string(mesh_name);
+            desc.vertex_count = positions.count;
+            desc.index_count = has_indices ? indices.count : positions.count;
+            desc.index_count -= desc.index_count % 3;
+            if (desc.vertex_count == 0 || desc.index_count < 3)
+                continue;
+
+            glm::vec3 bounds_min;
+            glm::vec3 bounds_max;
+            get_gltf_position_bounds(positions, bounds_min, bounds_max);
+            desc.quantization = make_vertex_quantization(bounds_min, bounds_max);
+
+            const u32 mesh_id = mesh_index++;
+            if (!sink.begin_mesh(mesh_id, desc))
+                continue;
+
+            const u32 vertex_count = desc.vertex_count;
+            const VertexQuantization quantization = desc.quantization;
+            const VkIndexType index_type = get_import_index_type(format, vertex_count);
+            for (u32 first = 0; first < desc.vertex_count; first += IMPORT_JOB_ELEMENT_COUNT)
+            {
+                const u32 count = std::min(IMPORT_JOB_ELEMENT_COUNT, desc.vertex_count - first);
+
+                ImportJob position_job;
+                position_job.mesh = mesh_id;
+                position_job.target_count = 1;
+                position_job.targets[0] = { MESH_STREAM_POSITION, first, count };
+                position_job.decode = [positions, quantization, format, first, count](void *const *destinations)
+                {
+                    const u8 *src = positions.data + static_cast<size_t>(positions.stride) * first;
+                    const u32 component_size = get_gltf_component_size(positions.component_type);
+                    for (u32 i = 0; i < count; ++i, src += positions.stride)
+                    {
+                        glm::vec3 position;
+                        for (u32 c = 0; c < 3; ++c)
+                            position[c] = read_gltf_component(src + c * component_size, positions.component_type, positions.normalized);
+                        write_position(destinations[0], i, position, quantization, format);
+                    }
+                };
+                jobs.push_back(std::move(position_job));
+
+                ImportJob color_job;
+                color_job.mesh = mesh_id;
+                color_job.target_count = 1;
+                color_job.targets[0] = { MESH_STREAM_COLOR, first, count };
+                color_job.decode = [colors, has_colors, format, first, count](void *const *destinations)
+                {
+                    if (!has_colors)
+                    {
+                        for (u32 i = 0; i < count; ++i)
+                            write_color(destinations[0], i, glm::vec3(1.0f), format);
+                        return;
+                    }
+
+                    const u32 component_size = get_gltf_component_size(colors.component_type);
+                    const u8 *src = colors.data + static_cast<size_t>(colors.stride) * first;
+                    for (u32 i = 0; i < count; ++i, src += colors.stride)
+                    {
+                        glm::vec3 color;
+                        for (u32 c = 0; c < 3; ++c)
+                            color[c] = read_gltf_component(src + c * component_size, colors.component_type, colors.normalized);
+                        write_color(destinations[0], i, color, format);
+                    }
+                };
+                jobs.push_back(std::move(color_job));
+            }
+
+            for (u32 first = 0; first < desc.index_count; first += IMPORT_JOB_ELEMENT_COUNT)
+            {
+                const u32 count = std::min(IMPORT_JOB_ELEMENT_COUNT, desc.index_count - first);
+
+                ImportJob index_job;
+                index_job.mesh = mesh_id;
+                index_job.target_count = 1;
+                index_job.targets[0] = { INDEX_TARGET, first, count };
+                index_job.decode = [indices, has_indices, vertex_count, index_type, first, count](void *const *destinations)
+                {
+                    auto decode = [&](auto *dst)
+                    {
+                        using Index = std::remove_pointer_t<decltype(dst)>;
+                        if (!has_indices)
+                        {
+                            for (u32 i = 0; i < count; ++i)
+                                dst[i] = static_cast<Index>(first + i);
+                            return;
+                        }
+
+                        // Out of range indices would read past the mesh on the GPU
+                        const u8 *src = indices.data + static_cast<size_t>(indices.stride) * first;
+                        for (u32 i = 0; i < count; ++i, src += indices.stride)
+                        {
+                            const u32 index = read_gltf_index(src, indices.component_type);
+                            dst[i] = static_cast<Index>(index < vertex_count ? index : 0);
+                        }
+                    };
+
+                    if (index_type == VK_INDEX_TYPE_UINT16)
+                        decode(static_cast<u16 *>(destinations[0]));
+                    else
+                        decode(static_cast<u32 *>(destinations[0]));
+                };
+                jobs.push_back(std::move(index_job));
+            }
+        }
+    }
+
+    if (!run_jobs(jobs, sink))
+        return false;
+
+    Logger::get_instance().push_message(LoggingLevel::Info, "[MeshImporter] Imported {} meshes from {}", mesh_index, path.string());
+    return true;
+}
+
+// ====== OBJ ======
+namespace
+{
+    struct ObjChunk
+    {
+        const char *begin;
+        const char *end;
+        u32 first_vertex = 0;
+        u32 vertex_count = 0;
+        u32 first_index = 0;
+        u32 index_count = 0;
+        glm::vec3 bounds_min = glm::vec3(FLT_MAX);
+        glm::vec3 bounds_max = glm::vec3(-FLT_MAX);
+    };
+}
+
+static bool is_obj_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static const char *skip_obj_space(const char *p, const char *end)
+{
+    while (p < end && is_obj_space(*p))
+        ++p;
+    return p;
+}
+
+// Line starting at p without its newline, p moves to the next line
+static std::string_view next_obj_line(const char *&p, const char *end)
+{
+    const char *line_end = static_cast<const char *>(std::memchr(p, '\n', end - p));
+    if (!line_end)
+        line_end = end;
+    std::string_view line(p, line_end - p);
+    p = line_end < end ? line_end + 1 : end;
+    return line;
+}
+
+// 'v' for positions, 'f' for faces, 0 for every other statement
+static char get_obj_statement(std::string_view line, const char *&args)
+{
+    const char *p = skip_obj_space(line.data(), line.data() + line.size());
+    const char *end = line.data() + line.size();
+    if (end - p < 2 || (p[0] != 'v' && p[0] != 'f') || !is_obj_space(p[1]))
+        return 0;
+    args = p + 2;
+    return p[0];
+}
+
+// Up to max_count numbers of a statement's arguments, returns how many were read
+static u32 parse_obj_floats(const char *p, const char *end, float *values, u32 max_count)
+{
+    u32 count = 0;
+    while (count < max_count)
+    {
+        p = skip_obj_space(p, end);
+        const auto [ptr, ec] = std::from_chars(p, end, values[count]);
+        if (ec != std::errc())
+            break;
+        p = ptr;
+        ++count;
+    }
+    return count;
+}
+
+// Vertex references of a face, the position index of each "v/vt/vn" token
+template<typename Func>
+static u32 for_each_obj_face_vertex(const char *p, const char *end, Func &&func)
+{
+    u32 count = 0;
+    while (true)
+    {
+        p = skip_obj_space(p, end);
+        if (p >= end)
+            return count;
+
+        i64 index = 0;
+        const auto [ptr, ec] = std::from_chars(p, end, index);
+        if (ec != std::errc())
+            return count;
+        func(index);
+        ++count;
+
+        p = ptr;
+        while (p < end && !is_obj_space(*p))
+            ++p;
+    }
+}
+
+bool MeshImporter::import_obj(const std::filesystem::path &path, MeshImportSink &sink)
+{
+    const MeshImportFormat format = sink.get_format();
+    MappedFile file;
+    if (!file.open(path))
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[MeshImporter] Could not open {}", path.string());
+        return false;
+    }
+
+    // Chunks end on line breaks, so every statement is parsed by exactly one job
+    const char *text = reinterpret_cast<const char *>(file.get_data());
+    const char *text_end = text + file.get_size();
+    std::vector<ObjChunk> chunks;
+    for (const char *p = text; p < text_end;)
+    {
+        const char *chunk_end = p + std::min(OBJ_CHUNK_SIZE, static_cast<size_t>(text_end - p));
+        if (chunk_end < text_end)
+        {
+            const char *line_end = static_cast<const char *>(std::memchr(chunk_end, '\n', text_end - chunk_end));
+            chunk_end = line_end ? line_end + 1 : text_end;
+        }
+        chunks.push_back({ p, chunk_end });
+        p = chunk_end;
+    }
+
+    // First pass counts, so every chunk knows where its vertices and indices go, and bounds the
+    // positions, which are quantized against them
+    m_ThreadPool->parallel_for(static_cast<u32>(chunks.size()), [&chunks](u32 begin, u32 end)
+    {
+        for (u32 c = begin; c < end; ++c)
+        {
+            ObjChunk &chunk = chunks[c];
+            for (const char *p = chunk.begin; p < chunk.end;)
+            {
+                const std::string_view line = next_obj_line(p, chunk.end);
+                const char *args = nullptr;
+                const char statement = get_obj_statement(line, args);
+                if (statement == 'v')
+                {
+                    float position[3] = {};
+                    parse_obj_floats(args, line.data() + line.size(), position, 3);
+                    chunk.bounds_min = glm::min(chunk.bounds_min, glm::vec3(position[0], position[1], position[2]));
+                    chunk.bounds_max = glm::max(chunk.bounds_max, glm::vec3(position[0], position[1], position[2]));
+                    ++chunk.vertex_count;
+                }
+                else if (statement == 'f')
+                {
+                    const u32 face_vertices = for_each_obj_face_vertex(args, line.data() + line.size(), [](i64) {});
+                    if (face_vertices >= 3)
+                        chunk.index_count += (face_vertices - 2) * 3;
+                }
+            }
+        }
+    });
+
+    u64 vertex_total = 0;
+    u64 index_total = 0;
+    glm::vec3 bounds_min = glm::vec3(FLT_MAX);
+    glm::vec3 bounds_max = glm::vec3(-FLT_MAX);
+    for (ObjChunk &chunk : chunks)
+    {
+        chunk.first_vertex = static_cast<u32>(vertex_total);
+        chunk.first_index = static_cast<u32>(index_total);
+        vertex_total += chunk.vertex_count;
+        index_total += chunk.index_count;
+        bounds_min = glm::min(bounds_min, chunk.bounds_min);
+        bounds_max = glm::max(bounds_max, chunk.bounds_max);
+    }
+
+    if (vertex_total == 0 || index_total == 0 || vertex_total > ~0u || index_total > ~0u)
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[MeshImporter] {} has no triangles or too many vertices", path.string());
+        return false;
+    }
+
+    ImportedMeshDesc desc;
+    desc.name = path.stem().string();
+    desc.vertex_count = static_cast<u32>(vertex_total);
+    desc.index_count = static_cast<u32>(index_total);
+    desc.quantization = make_vertex_quantization(bounds_min, bounds_max);
+    if (!sink.begin_mesh(0, desc))
+        return true;
+
+    std::atomic<u32> invalid_references = 0;
+    std::vector<ImportJob> jobs;
+    jobs.reserve(chunks.size());
+    for (const ObjChunk &chunk : chunks)
+    {
+        ImportJob job;
+        job.mesh = 0;
+        job.target_count = 3;
+        job.targets[0] = { MESH_STREAM_POSITION, chunk.first_vertex, chunk.vertex_count };
+        job.targets[1] = { MESH_STREAM_COLOR, chunk.first_vertex, chunk.vertex_count };
+        job.targets[2] = { INDEX_TARGET, chunk.first_index, chunk.index_count };
+        job.decode = [chunk, vertex_count = desc.vertex_count, quantization = desc.quantization, format, &invalid_references](void *const *destinations)
+        {
+            auto decode = [&](auto *indices)
+            {
+                using Index = std::remove_pointer_t<decltype(indices)>;
+                u32 vertex = chunk.first_vertex; // vertices declared so far, relative references count back from here
+                u32 invalid = 0;
+                Index face[3] = {};
+
+                for (const char *p = chunk.begin; p < chunk.end;)
+                {
+                    const std::string_view line = next_obj_line(p, chunk.end);
+                    const char *line_end = line.data() + line.size();
+                    const char *args = nullptr;
+                    const char statement = get_obj_statement(line, args);
+                    if (statement == 'v')
+                    {
+                        // "v x y z [r g b]", colors are a common extension
+                        float values[6] = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+                        if (parse_obj_floats(args, line_end, values, 6) < 6)
+                            values[3] = values[4] = values[5] = 1.0f;
+
+                        write_position(destinations[0], vertex - chunk.first_vertex, glm::vec3(values[0], values[1], values[2]), quantization, format);
+                        write_color(destinations[1], vertex - chunk.first_vertex, glm::vec3(values[3], values[4], values[5]), format);
+                        ++vertex;
+                    }
+                    else if (statement == 'f')
+                    {
+                        // Fan triangulation: (0, i - 1, i) for every vertex past the second
+                        u32 face_vertex = 0;
+                        for_each_obj_face_vertex(args, line_end, [&](i64 reference)
+                        {
+                            const i64 resolved = reference > 0 ? reference - 1 : static_cast<i64>(vertex) + reference;
+                            Index index = 0;
+                            if (reference != 0 && resolved >= 0 && resolved < vertex_count)
+                                index = static_cast<Index>(resolved);
+                            else
+                                ++invalid;
+
+                            if (face_vertex < 2)
+                                face[face_vertex] = index;
+                            else
+                            {
+                                indices[0] = face[0];
+                                indices[1] = face[1];
+                                indices[2] = index;
+                                indices += 3;
+                                face[1] = index;
+                            }
+                            ++face_vertex;
+                        });
+                    }
+                }
+
+                if (invalid > 0)
+                    invalid_references.fetch_add(invalid, std::memory_order_relaxed);
+            };
+
+            if (get_import_index_type(format, vertex_count) == VK_INDEX_TYPE_UINT16)
+                decode(static_cast<u16 *>(destinations[2]));
+            else
+                decode(static_cast<u32 *>(destinations[2]));
+        };
+        jobs.push_back(std::move(job));
+    }
+
+    if (!run_jobs(jobs, sink))
+        return false;
+
+    if (invalid_references > 0)
+    {
+        Logger::get_instance().push_message(LoggingLevel::Warning, "[MeshImporter] {} invalid vertex references in {} were replaced by vertex 0",
+            invalid_references.load(), path.string());
+    }
+
+    Logger::get_instance().push_message(LoggingLevel::Info, "[MeshImporter] Imported {} vertices and {} triangles from {}",
+        desc.vertex_count, desc.index_count / 3, path.string());
+    return true;
+}
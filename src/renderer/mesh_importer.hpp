@@ -0,0 +1,111 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#ifndef MESH_IMPORTER_HPP
+#define MESH_IMPORTER_HPP
+
+#include "vertex.hpp"
+
+#include "core/types.hpp"
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// Layout the importer decodes into a sink's memory
+enum class MeshImportFormat : u32
+{
+    Packed = 0, // MESH_STREAM_STRIDES streams and get_mesh_index_type(vertex_count) indices, as the GPU reads them
+    Float, // a glm::vec3 per vertex in every stream and u32 indices, full precision for the offline tools
+};
+
+static u32 get_import_stream_stride(MeshImportFormat format, u32 stream)
+{
+    return format == MeshImportFormat::Float ? static_cast<u32>(sizeof(glm::vec3)) : MESH_STREAM_STRIDES[stream];
+}
+
+static VkIndexType get_import_index_type(MeshImportFormat format, u32 vertex_count)
+{
+    return format == MeshImportFormat::Float ? VK_INDEX_TYPE_UINT32 : get_mesh_index_type(vertex_count);
+}
+
+struct ImportedMeshDesc
+{
+    std::string name;
+    u32 vertex_count = 0;
+    u32 index_count = 0; // triangle list, relative to the mesh's first vertex
+    VertexQuantization quantization; // of the mesh's position bounds, packed positions are encoded with it
+};
+
+// Receives imported geometry. The importer asks for destination memory and decodes the
+// source straight into it, so a sink backed by staging memory gets its data without any
+// intermediate copy. Every call comes from the importing thread, only the writes to the
+// returned memory happen on workers.
+class MeshImportSink
+{
+public:
+    virtual ~MeshImportSink() = default;
+
+    // Announces a mesh before any of its data, in file order. False skips the mesh.
+    virtual bool begin_mesh(u32 mesh, const ImportedMeshDesc &desc) = 0;
+
+    // Layout of everything the sink maps, asked once per import
+    virtual MeshImportFormat get_format() const { return MeshImportFormat::Packed; }
+
+    // Memory for count elements of a stream (get_import_stream_stride) or count indices of
+    // get_import_index_type, starting at first. nullptr when the sink is out of space until
+    // the next flush().
+    virtual void *map_vertices(u32 mesh, u32 stream, u32 first, u32 count) = 0;
+    virtual void *map_indices(u32 mesh, u32 first, u32 count) = 0;
+
+    // Everything mapped so far has been written
+    virtual void flush() = 0;
+};
+
+// Loads the triangle geometry of glTF 2.0 (.glb, or .gltf with its buffers in files) and OBJ.
+// The source is memory mapped and split into chunks of work that decode in parallel on the
+// thread pool. Positions and vertex colors fill the mesh streams in the sink's format, missing
+// colors are white.
+// glTF primitives become one mesh each, node transforms are not applied. An OBJ file is one
+// mesh whose vertices are its positions, faces are fan triangulated.
+class MeshImporter
+{
+public:
+    explicit MeshImporter(ThreadPool *thread_pool = nullptr);
+
+    // False when the file could not be read or parsed, meshes passed to the sink before a
+    // failure keep whatever was written
+    bool import(const std::filesystem::path &path, MeshImportSink &sink);
+
+private:
+    // Up to one destination per stream plus the indices
+    static constexpr u32 MAX_JOB_TARGETS = MESH_STREAM_COUNT + 1;
+    static constexpr u32 INDEX_TARGET = ~0u;
+
+    struct ImportTarget
+    {
+        u32 stream = 0; // INDEX_TARGET for indices
+        u32 first = 0;
+        u32 count = 0;
+    };
+
+    struct ImportJob
+    {
+        u32 mesh = 0;
+        u32 target_count = 0;
+        ImportTarget targets[MAX_JOB_TARGETS];
+        std::function<void(void *const *destinations)> decode;
+    };
+
+    bool import_gltf(const std::filesystem::path &path, MeshImportSink &sink);
+    bool import_obj(const std::filesystem::path &path, MeshImportSink &sink);
+
+    // Maps as many jobs as the sink has room for, decodes them in parallel, flushes and repeats
+    bool run_jobs(std::vector<ImportJob> &jobs, MeshImportSink &sink);
+
+    ThreadPool *m_ThreadPool;
+};
+
+#endif
@@ -0,0 +1,335 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+// Lines of the simulated vertex fetch cache, direct mapped
+static constexpr u32 FETCH_CACHE_LINE_SIZE = 64;
+static constexpr u32 FETCH_CACHE_LINE_COUNT = 64;
+
+// FIFO cache: a vertex is resident while fewer than cache_size misses happened since its own.
+// Timestamps start far enough ahead that zero never counts as resident, reset() moves past every entry.
+class VertexCacheSimulator
+{
+public:
+    VertexCacheSimulator(u32 vertex_count, u32 cache_size)
+        : m_Timestamps(vertex_count, 0), m_CacheSize(cache_size), m_Time(cache_size + 1)
+    {
+    }
+
+    // True on a miss
+    bool access(u32 vertex)
+    {
+        if (m_Time - m_Timestamps[vertex] <= m_CacheSize)
+            return false;
+        m_Timestamps[vertex] = m_Time++;
+        return true;
+    }
+
+    u32 access_triangle(const u32 *triangle)
+    {
+        return static_cast<u32>(access(triangle[0])) + access(triangle[1]) + access(triangle[2]);
+    }
+
+    void reset() { m_Time += m_CacheSize + 1; }
+
+private:
+    std::vector<u32> m_Timestamps;
+    u32 m_CacheSize;
+    u32 m_Time;
+};
+
+MeshOptimizerStats analyze_mesh(const u32 *indices, u32 index_count, u32 vertex_count, u32 cache_size)
+{
+    MeshOptimizerStats stats;
+    const u32 triangle_count = index_count / 3;
+    if (triangle_count == 0 || vertex_count == 0)
+        return stats;
+
+    VertexCacheSimulator cache(vertex_count, cache_size);
+    std::vector<bool> referenced(vertex_count, false);
+    std::vector<u64> line_tags(FETCH_CACHE_LINE_COUNT, ~0ull);
+    const u32 stride = MESH_STREAM_STRIDES[MESH_STREAM_POSITION];
+
+    u32 transformed = 0;
+    u32 unique = 0;
+    u64 fetched_bytes = 0;
+    for (u32 i = 0; i < triangle_count * 3; ++i)
+    {
+        const u32 vertex = indices[i];
+        if (!referenced[vertex])
+        {
+            referenced[vertex] = true;
+            ++unique;
+        }
+
+        if (!cache.access(vertex))
+            continue;
+        ++transformed;
+
+        // Only transformed vertices are fetched, a vertex may straddle two lines
+        const u64 first_line = static_cast<u64>(vertex) * stride / FETCH_CACHE_LINE_SIZE;
+        const u64 last_line = (static_cast<u64>(vertex) * stride + stride - 1) / FETCH_CACHE_LINE_SIZE;
+        for (u64 line = first_line; line <= last_line; ++line)
+        {
+            u64 &tag = line_tags[line % FETCH_CACHE_LINE_COUNT];
+            if (tag != line)
+            {
+                tag = line;
+                fetched_bytes += FETCH_CACHE_LINE_SIZE;
+            }
+        }
+    }
+
+    stats.acmr = static_cast<float>(transformed) / triangle_count;
+    stats.atvr = static_cast<float>(transformed) / unique;
+    stats.overfetch = static_cast<float>(fetched_bytes) / (static_cast<u64>(unique) * stride);
+    return stats;
+}
+
+void optimize_vertex_cache(u32 *indices, u32 index_count, u32 vertex_count, std::vector<u32> *cluster_starts, u32 cache_size)
+{
+    const u32 triangle_count = index_count / 3;
+    if (cluster_starts)
+        cluster_starts->clear();
+    if (triangle_count == 0)
+        return;
+
+    // Triangles around every vertex, as offsets into one array
+    std::vector<u32> live_triangles(vertex_count, 0);
+    for (u32 i = 0; i < triangle_count * 3; ++i)
+        ++live_triangles[indices[i]];
+
+    std::vector<u32> adjacency_offsets(vertex_count + 1, 0);
+    for (u32 v = 0; v < vertex_count; ++v)
+        adjacency_offsets[v + 1] = adjacency_offsets[v] + live_triangles[v];
+
+    std::vector<u32> adjacency(triangle_count * 3);
+    std::vector<u32> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+    for (u32 t = 0; t < triangle_count; ++t)
+    {
+        for (u32 k = 0; k < 3; ++k)
+            adjacency[fill[indices[t * 3 + k]]++] = t;
+    }
+
+    const std::vector<u32> source(indices, indices + triangle_count * 3);
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<u32> cache_times(vertex_count, 0);
+    std::vector<u32> dead_end;
+    std::vector<u32> candidates;
+    dead_end.reserve(triangle_count * 3);
+
+    u32 time = cache_size + 1;
+    u32 cursor = 0;
+    u32 output = 0;
+    u32 fan_vertex = 0;
+    while (live_triangles[fan_vertex] == 0 && fan_vertex + 1 < vertex_count)
+        ++fan_vertex;
+    if (cluster_starts)
+        cluster_starts->push_back(0);
+
+    while (fan_vertex != ~0u)
+    {
+        // Emit every remaining triangle around the fan vertex
+        candidates.clear();
+        for (u32 a = adjacency_offsets[fan_vertex]; a < adjacency_offsets[fan_vertex + 1]; ++a)
+        {
+            const u32 t = adjacency[a];
+            if (emitted[t])
+                continue;
+            emitted[t] = true;
+
+            for (u32 k = 0; k < 3; ++k)
+            {
+                const u32 v = source[t * 3 + k];
+                indices[output++] = v;
+                dead_end.push_back(v);
+                candidates.push_back(v);
+                --live_triangles[v];
+                if (time - cache_times[v] > cache_size)
+                    cache_times[v] = time++;
+            }
+        }
+
+        // Next fan: the candidate that has been in the cache longest and whose remaining
+        // triangles still fit before it leaves. Candidates that do not fit go to the dead end path.
+        u32 best_vertex = ~0u;
+        u32 best_priority = 0;
+        for (u32 v : candidates)
+        {
+            if (live_triangles[v] == 0)
+                continue;
+            u32 priority = 0;
+            const u32 cache_position = time - cache_times[v];
+            if (cache_position + 2 * live_triangles[v] <= cache_size)
+                priority = cache_position;
+            if (priority > best_priority)
+            {
+                best_priority = priority;
+                best_vertex = v;
+            }
+        }
+
+        if (best_vertex == ~0u)
+        {
+            // Dead end: recently used vertices first, then the next vertex in input order
+            while (!dead_end.empty() && best_vertex == ~0u)
+            {
+                const u32 v = dead_end.back();
+                dead_end.pop_back();
+                if (live_triangles[v] > 0)
+                    best_vertex = v;
+            }
+            while (best_vertex == ~0u && cursor < vertex_count)
+            {
+                if (live_triangles[cursor] > 0)
+                    best_vertex = cursor;
+                ++cursor;
+            }
+
+            if (cluster_starts && best_vertex != ~0u)
+                cluster_starts->push_back(output / 3);
+        }
+        fan_vertex = best_vertex;
+    }
+}
+
+void optimize_overdraw(u32 *indices, u32 index_count, const glm::vec3 *positions, u32 vertex_count, const std::vector<u32> &cluster_starts,
+    float threshold, u32 cache_size)
+{
+    const u32 triangle_count = index_count / 3;
+    if (triangle_count == 0)
+        return;
+
+    // Soft boundaries: within each hard cluster, end a cluster as soon as its own ACMR is within
+    // threshold of the whole cluster's, so reordering costs little vertex cache efficiency
+    VertexCacheSimulator cache(vertex_count, cache_size);
+    std::vector<u32> starts;
+    for (size_t c = 0; c < cluster_starts.size(); ++c)
+    {
+        const u32 begin = cluster_starts[c];
+        const u32 end = c + 1 < cluster_starts.size() ? cluster_starts[c + 1] : triangle_count;
+        if (begin >= end)
+            continue;
+
+        cache.reset();
+        u32 cluster_misses = 0;
+        for (u32 t = begin; t < end; ++t)
+            cluster_misses += cache.access_triangle(indices + t * 3);
+        const float cluster_acmr = static_cast<float>(cluster_misses) / (end - begin);
+
+        cache.reset();
+        starts.push_back(begin);
+        u32 soft_begin = begin;
+        u32 misses = 0;
+        for (u32 t = begin; t < end; ++t)
+        {
+            misses += cache.access_triangle(indices + t * 3);
+            if (t + 1 < end && static_cast<float>(misses) / (t + 1 - soft_begin) <= cluster_acmr * threshold)
+            {
+                starts.push_back(t + 1);
+                soft_begin = t + 1;
+                misses = 0;
+                cache.reset();
+            }
+        }
+    }
+    if (starts.empty())
+        starts.push_back(0);
+
+    // Area weighted centroid and normal of every cluster
+    const u32 cluster_count = static_cast<u32>(starts.size());
+    std::vector<glm::vec3> centroids(cluster_count, glm::vec3(0.0f));
+    std::vector<glm::vec3> normals(cluster_count, glm::vec3(0.0f));
+    glm::vec3 mesh_centroid(0.0f);
+    float mesh_area = 0.0f;
+    for (u32 c = 0; c < cluster_count; ++c)
+    {
+        const u32 end = c + 1 < cluster_count ? starts[c + 1] : triangle_count;
+        float area = 0.0f;
+        for (u32 t = starts[c]; t < end; ++t)
+        {
+            const glm::vec3 &a = positions[indices[t * 3]];
+            const glm::vec3 &b = positions[indices[t * 3 + 1]];
+            const glm::vec3 &p = positions[indices[t * 3 + 2]];
+            const glm::vec3 normal = glm::cross(b - a, p - a);
+            const float triangle_area = glm::length(normal);
+            centroids[c] += (a + b + p) * (triangle_area / 3.0f);
+            normals[c] += normal;
+            area += triangle_area;
+        }
+
+        mesh_centroid += centroids[c];
+        mesh_area += area;
+        centroids[c] = area > 0.0f ? centroids[c] / area : positions[indices[starts[c] * 3]];
+        const float normal_length = glm::length(normals[c]);
+        normals[c] = normal_length > 0.0f ? normals[c] / normal_length : glm::vec3(0.0f);
+    }
+    if (mesh_area > 0.0f)
+        mesh_centroid /= mesh_area;
+
+    // Clusters on the outside facing outward occlude the clusters behind them from most views
+    std::vector<float> scores(cluster_count);
+    for (u32 c = 0; c < cluster_count; ++c)
+        scores[c] = glm::dot(centroids[c] - mesh_centroid, normals[c]);
+
+    std::vector<u32> order(cluster_count);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&scores](u32 a, u32 b) { return scores[a] > scores[b]; });
+
+    const std::vector<u32> source(indices, indices + triangle_count * 3);
+    u32 output = 0;
+    for (u32 c : order)
+    {
+        const u32 begin = starts[c] * 3;
+        const u32 end = (c + 1 < cluster_count ? starts[c + 1] : triangle_count) * 3;
+        std::copy(source.begin() + begin, source.begin() + end, indices + output);
+        output += end - begin;
+    }
+}
+
+void optimize_vertex_fetch(MeshData &mesh)
+{
+    const u32 vertex_count = mesh.get_vertex_count();
+    std::vector<u32> remap(vertex_count, ~0u);
+    u32 next = 0;
+    for (u32 &index : mesh.indices)
+    {
+        if (remap[index] == ~0u)
+            remap[index] = next++;
+        index = remap[index];
+    }
+
+    std::vector<glm::vec3> positions(next);
+    std::vector<glm::vec3> colors(next);
+    for (u32 v = 0; v < vertex_count; ++v)
+    {
+        if (remap[v] == ~0u)
+            continue;
+        positions[remap[v]] = mesh.positions[v];
+        colors[remap[v]] = mesh.colors[v];
+    }
+    mesh.positions = std::move(positions);
+    mesh.colors = std::move(colors);
+}
+
+void optimize_mesh(MeshData &mesh)
+{
+    const u32 vertex_count = mesh.get_vertex_count();
+    std::vector<MeshLod> lods = mesh.lods;
+    if (lods.empty())
+        lods.push_back({ 0, static_cast<u32>(mesh.indices.size()) });
+
+    std::vector<u32> cluster_starts;
+    for (const MeshLod &lod : lods)
+    {
+        u32 *indices = mesh.indices.data() + lod.first_index;
+        optimize_vertex_cache(indices, lod.index_count, vertex_count, &cluster_starts);
+        optimize_overdraw(indices, lod.index_count, mesh.positions.data(), vertex_count, cluster_starts);
+    }
+
+    // LOD 0 comes first in the indices, so its fetches are the ones made linear
+    optimize_vertex_fetch(mesh);
+}
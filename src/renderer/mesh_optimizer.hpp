@@ -0,0 +1,44 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#ifndef MESH_OPTIMIZER_HPP
+#define MESH_OPTIMIZER_HPP
+
+#include "mesh_data.hpp"
+
+#include <vector>
+
+// Post-transform cache modelled by the optimizer and its statistics. 16 entries is below what
+// current GPUs effectively keep per batch, so orders tuned for it do not thrash larger caches.
+static constexpr u32 MESH_OPTIMIZER_CACHE_SIZE = 16;
+// A cluster may be this much worse than the vertex cache order before overdraw sorting splits it
+static constexpr float MESH_OPTIMIZER_OVERDRAW_THRESHOLD = 1.05f;
+
+struct MeshOptimizerStats
+{
+    float acmr = 0.0f; // transformed vertices per triangle, 0.5 is ideal for large grids, 3 is the worst
+    float atvr = 0.0f; // transformed vertices per referenced vertex, 1 is ideal
+    float overfetch = 0.0f; // position bytes read through 64 byte lines per referenced position byte, 1 is ideal
+};
+
+// Simulates a FIFO vertex cache and a small cache of position lines over the triangles
+MeshOptimizerStats analyze_mesh(const u32 *indices, u32 index_count, u32 vertex_count, u32 cache_size = MESH_OPTIMIZER_CACHE_SIZE);
+
+// Tipsify (Sander et al. 2007): fans around the most recently used vertex that still fits in the
+// cache, linear in the triangle count. cluster_starts receives the first triangle of every run
+// that began after a cache dead end, the hard boundaries overdraw sorting may reorder.
+void optimize_vertex_cache(u32 *indices, u32 index_count, u32 vertex_count, std::vector<u32> *cluster_starts = nullptr,
+    u32 cache_size = MESH_OPTIMIZER_CACHE_SIZE);
+
+// Splits the clusters further wherever that costs less than threshold in ACMR, then orders them
+// so clusters facing away from the mesh center draw first and occlude the rest
+void optimize_overdraw(u32 *indices, u32 index_count, const glm::vec3 *positions, u32 vertex_count, const std::vector<u32> &cluster_starts,
+    float threshold = MESH_OPTIMIZER_OVERDRAW_THRESHOLD, u32 cache_size = MESH_OPTIMIZER_CACHE_SIZE);
+
+// Renumbers vertices in order of first use so fetches walk memory linearly, unreferenced
+// vertices are dropped. Applies to every stream and every LOD.
+void optimize_vertex_fetch(MeshData &mesh);
+
+// All of the above, on each LOD's triangles (all indices when there are no LODs yet)
+void optimize_mesh(MeshData &mesh);
+
+#endif
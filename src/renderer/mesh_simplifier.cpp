@@ -0,0 +1,403 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#include "mesh_simplifier.hpp"
+
+#include <cfloat>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+
+// Vertices are points in position + color space, the quadrics measure squared distances there
+static constexpr u32 QUADRIC_DIMENSION = 6;
+static constexpr u32 QUADRIC_MATRIX_SIZE = QUADRIC_DIMENSION * (QUADRIC_DIMENSION + 1) / 2;
+
+// Border planes are this much stiffer than the surface, so open edges stay in place
+static constexpr double BORDER_WEIGHT = 10.0;
+// Border vertices where the outline turns by more than 60 degrees are corners and never move
+static constexpr float BORDER_CORNER_COSINE = 0.5f;
+
+// Symmetric matrix packed by rows of its upper triangle, evaluates v^T A v + 2 b^T v + c.
+// weight is the area the quadric was accumulated over, error / weight is a mean squared distance.
+struct Quadric
+{
+    double a[QUADRIC_MATRIX_SIZE] = {};
+    double b[QUADRIC_DIMENSION] = {};
+    double c = 0.0;
+    double weight = 0.0;
+
+    Quadric &operator+=(const Quadric &other)
+    {
+        for (u32 i = 0; i < QUADRIC_MATRIX_SIZE; ++i)
+            a[i] += other.a[i];
+        for (u32 i = 0; i < QUADRIC_DIMENSION; ++i)
+            b[i] += other.b[i];
+        c += other.c;
+        weight += other.weight;
+        return *this;
+    }
+
+    double evaluate(const double *v) const
+    {
+        double result = c;
+        u32 k = 0;
+        for (u32 i = 0; i < QUADRIC_DIMENSION; ++i)
+        {
+            result += 2.0 * b[i] * v[i] + a[k++] * v[i] * v[i];
+            for (u32 j = i + 1; j < QUADRIC_DIMENSION; ++j)
+                result += 2.0 * a[k++] * v[i] * v[j];
+        }
+        return result;
+    }
+};
+
+static double dot(const double *a, const double *b, u32 count)
+{
+    double result = 0.0;
+    for (u32 i = 0; i < count; ++i)
+        result += a[i] * b[i];
+    return result;
+}
+
+// Distance to the plane through p, q and r in attribute space, weighted by the triangle's area
+static void add_triangle_quadric(Quadric &quadric, const double *p, const double *q, const double *r, double area)
+{
+    double e1[QUADRIC_DIMENSION];
+    double e2[QUADRIC_DIMENSION];
+    for (u32 i = 0; i < QUADRIC_DIMENSION; ++i)
+    {
+        e1[i] = q[i] - p[i];
+        e2[i] = r[i] - p[i];
+    }
+
+    const double e1_length = std::sqrt(dot(e1, e1, QUADRIC_DIMENSION));
+    if (e1_length <= DBL_EPSILON || area <= 0.0)
+        return;
+    for (double &value : e1)
+        value /= e1_length;
+
+    const double projection = dot(e2, e1, QUADRIC_DIMENSION);
+    for (u32 i = 0; i < QUADRIC_DIMENSION; ++i)
+        e2[i] -= projection * e1[i];
+    const double e2_length = std::sqrt(dot(e2, e2, QUADRIC_DIMENSION));
+    if (e2_length <= DBL_EPSILON)
+        return;
+    for (double &value : e2)
+        value /= e2_length;
+
+    // A = I - e1 e1^T - e2 e2^T, b = (p.e1) e1 + (p.e2) e2 - p, c = p.p - (p.e1)^2 - (p.e2)^2
+    const double p_e1 = dot(p, e1, QUADRIC_DIMENSION);
+    const double p_e2 = dot(p, e2, QUADRIC_DIMENSION);
+    u32 k = 0;
+    for (u32 i = 0; i < QUADRIC_DIMENSION; ++i)
+    {
+        for (u32 j = i; j < QUADRIC_DIMENSION; ++j)
+            quadric.a[k++] += area * ((i == j ? 1.0 : 0.0) - e1[i] * e1[j] - e2[i] * e2[j]);
+        quadric.b[i] += area * (p_e1 * e1[i] + p_e2 * e2[i] - p[i]);
+    }
+    quadric.c += area * (dot(p, p, QUADRIC_DIMENSION) - p_e1 * p_e1 - p_e2 * p_e2);
+    quadric.weight += area;
+}
+
+// Distance to the plane through the border edge a-b that stands perpendicular on its triangle.
+// Positions only, and without area so it does not dilute the surface error.
+static void add_border_quadric(Quadric &quadric, const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &face_normal)
+{
+    const glm::vec3 edge = b - a;
+    const glm::vec3 normal = glm::cross(edge, face_normal);
+    const float normal_length = glm::length(normal);
+    if (normal_length <= 0.0f)
+        return;
+
+    const glm::vec3 m = normal / normal_length;
+    const double weight = BORDER_WEIGHT * glm::dot(edge, edge);
+    const double d = glm::dot(m, a);
+    u32 k = 0;
+    for (u32 i = 0; i < QUADRIC_DIMENSION; ++i)
+    {
+        for (u32 j = i; j < QUADRIC_DIMENSION; ++j)
+            quadric.a[k++] += i < 3 && j < 3 ? weight * m[i] * m[j] : 0.0;
+        quadric.b[i] += i < 3 ? -weight * d * m[i] : 0.0;
+    }
+    quadric.c += weight * d * d;
+}
+
+namespace
+{
+    struct Collapse
+    {
+        float cost;
+        u32 from;
+        u32 to;
+        u32 from_version;
+        u32 to_version;
+
+        bool operator>(const Collapse &other) const { return cost > other.cost; }
+    };
+}
+
+void build_lods(MeshData &mesh, u32 max_lod_count, float reduction)
+{
+    if (!mesh.lods.empty())
+    {
+        const MeshLod &lod = mesh.lods[0];
+        mesh.indices.erase(mesh.indices.begin() + lod.first_index + lod.index_count, mesh.indices.end());
+        mesh.indices.erase(mesh.indices.begin(), mesh.indices.begin() + lod.first_index);
+    }
+    mesh.meshlets.clear();
+    mesh.lods.assign(1, MeshLod{ 0, static_cast<u32>(mesh.indices.size()) });
+
+    const u32 vertex_count = mesh.get_vertex_count();
+    const u32 triangle_count = static_cast<u32>(mesh.indices.size() / 3);
+    if (max_lod_count <= 1 || triangle_count <= MESH_LOD_MIN_TRIANGLE_COUNT)
+        return;
+
+    // Attributes are normalized to the bounding sphere, errors scale back by its radius
+    const glm::vec4 sphere = compute_bounding_sphere(mesh.positions.data(), mesh.indices.data(), triangle_count * 3);
+    const float radius = sphere.w > 0.0f ? sphere.w : 1.0f;
+    std::vector<double> attributes(static_cast<size_t>(vertex_count) * QUADRIC_DIMENSION);
+    for (u32 v = 0; v < vertex_count; ++v)
+    {
+        double *attribute = attributes.data() + static_cast<size_t>(v) * QUADRIC_DIMENSION;
+        const glm::vec3 position = (mesh.positions[v] - glm::vec3(sphere)) / radius;
+        for (u32 c = 0; c < 3; ++c)
+        {
+            attribute[c] = position[c];
+            attribute[3 + c] = mesh.colors[v][c] * MESH_SIMPLIFY_COLOR_WEIGHT;
+        }
+    }
+    auto get_attributes = [&attributes](u32 v) { return attributes.data() + static_cast<size_t>(v) * QUADRIC_DIMENSION; };
+
+    // Vertices sharing a position are attribute seams, moving one alone would tear the surface
+    std::vector<bool> locked(vertex_count, false);
+    {
+        std::unordered_map<u64, u32> first_at_position;
+        first_at_position.reserve(vertex_count);
+        for (u32 v = 0; v < vertex_count; ++v)
+        {
+            u32 bits[3];
+            std::memcpy(bits, &mesh.positions[v], sizeof(bits));
+            const u64 key = (static_cast<u64>(bits[0]) * 73856093ull) ^ (static_cast<u64>(bits[1]) * 19349663ull << 21)
+                ^ (static_cast<u64>(bits[2]) * 83492791ull << 42);
+            auto [it, inserted] = first_at_position.try_emplace(key, v);
+            if (!inserted && mesh.positions[it->second] == mesh.positions[v])
+                locked[v] = locked[it->second] = true;
+        }
+    }
+
+    // Edges used by a single triangle are open borders, by more than two non-manifold
+    std::unordered_map<u64, u32> edge_uses;
+    edge_uses.reserve(static_cast<size_t>(triangle_count) * 3);
+    auto edge_key = [](u32 a, u32 b) { return a < b ? (static_cast<u64>(a) << 32) | b : (static_cast<u64>(b) << 32) | a; };
+    for (u32 i = 0; i < triangle_count * 3; ++i)
+        ++edge_uses[edge_key(mesh.indices[i], mesh.indices[i - i % 3 + (i + 1) % 3])];
+
+    std::vector<Quadric> quadrics(vertex_count);
+    // Open borders as loops in triangle winding order, ~0u off the border. A vertex where several
+    // loops meet is locked.
+    std::vector<u32> border_next(vertex_count, ~0u);
+    std::vector<u32> border_previous(vertex_count, ~0u);
+    std::vector<std::vector<u32>> vertex_triangles(vertex_count);
+    for (u32 t = 0; t < triangle_count; ++t)
+    {
+        const u32 *triangle = mesh.indices.data() + t * 3;
+        const glm::vec3 &p0 = mesh.positions[triangle[0]];
+        const glm::vec3 face_normal = glm::cross(mesh.positions[triangle[1]] - p0, mesh.positions[triangle[2]] - p0);
+        const double area = 0.5 * glm::length(face_normal) / (static_cast<double>(radius) * radius);
+
+        Quadric quadric;
+        add_triangle_quadric(quadric, get_attributes(triangle[0]), get_attributes(triangle[1]), get_attributes(triangle[2]), area);
+        for (u32 k = 0; k < 3; ++k)
+        {
+            quadrics[triangle[k]] += quadric;
+            vertex_triangles[triangle[k]].push_back(t);
+
+            const u32 a = triangle[k];
+            const u32 b = triangle[(k + 1) % 3];
+            const u32 uses = edge_uses[edge_key(a, b)];
+            if (uses == 1)
+            {
+                Quadric border_quadric;
+                add_border_quadric(border_quadric, (mesh.positions[a] - glm::vec3(sphere)) / radius,
+                    (mesh.positions[b] - glm::vec3(sphere)) / radius, face_normal);
+                quadrics[a] += border_quadric;
+                quadrics[b] += border_quadric;
+                locked[a] = locked[a] || border_next[a] != ~0u;
+                locked[b] = locked[b] || border_previous[b] != ~0u;
+                border_next[a] = b;
+                border_previous[b] = a;
+            }
+            else if (uses > 2)
+            {
+                locked[a] = locked[b] = true;
+            }
+        }
+    }
+
+    // Loops broken by inconsistent winding cannot be followed. Corners of the outline stay, sliding
+    // them along one edge would cut them off.
+    for (u32 v = 0; v < vertex_count; ++v)
+    {
+        if ((border_next[v] == ~0u) != (border_previous[v] == ~0u))
+            locked[v] = true;
+        else if (border_next[v] != ~0u)
+        {
+            const glm::vec3 incoming = mesh.positions[v] - mesh.positions[border_previous[v]];
+            const glm::vec3 outgoing = mesh.positions[border_next[v]] - mesh.positions[v];
+            locked[v] = locked[v] || glm::dot(incoming, outgoing) < BORDER_CORNER_COSINE * glm::length(incoming) * glm::length(outgoing);
+        }
+    }
+
+    // Moving from onto to, FLT_MAX when not allowed. Border vertices only slide along their border
+    // edges, crossing the surface to another border vertex would cut the outline.
+    auto get_cost = [&](u32 from, u32 to)
+    {
+        if (locked[from] || (border_next[from] != ~0u && to != border_next[from] && to != border_previous[from]))
+            return FLT_MAX;
+        const Quadric &q_from = quadrics[from];
+        const Quadric &q_to = quadrics[to];
+        const double *target = get_attributes(to);
+        const double weight = std::max(q_from.weight + q_to.weight, DBL_EPSILON);
+        return static_cast<float>(std::max((q_from.evaluate(target) + q_to.evaluate(target)) / weight, 0.0));
+    };
+
+    std::vector<u32> versions(vertex_count, 0);
+    std::vector<bool> removed(vertex_count, false);
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+    auto push_edge = [&](u32 a, u32 b)
+    {
+        const float a_to_b = get_cost(a, b);
+        const float b_to_a = get_cost(b, a);
+        if (a_to_b == FLT_MAX && b_to_a == FLT_MAX)
+            return;
+        if (a_to_b <= b_to_a)
+            queue.push({ a_to_b, a, b, versions[a], versions[b] });
+        else
+            queue.push({ b_to_a, b, a, versions[b], versions[a] });
+    };
+
+    for (const auto &[key, uses] : edge_uses)
+        push_edge(static_cast<u32>(key >> 32), static_cast<u32>(key & 0xFFFFFFFF));
+
+    // Triangles keep their slot and are rewritten in place, removed ones are marked
+    std::vector<u32> triangles(mesh.indices.begin(), mesh.indices.end());
+    std::vector<bool> triangle_removed(triangle_count, false);
+    u32 live_triangles = triangle_count;
+    u32 target_triangles = static_cast<u32>(triangle_count * reduction);
+    u32 last_lod_triangles = triangle_count;
+    float max_cost = 0.0f;
+
+    auto emit_lod = [&]()
+    {
+        MeshLod lod;
+        lod.first_index = static_cast<u32>(mesh.indices.size());
+        for (u32 t = 0; t < triangle_count; ++t)
+        {
+            if (!triangle_removed[t])
+                mesh.indices.insert(mesh.indices.end(), triangles.begin() + t * 3, triangles.begin() + t * 3 + 3);
+        }
+        lod.index_count = static_cast<u32>(mesh.indices.size()) - lod.first_index;
+        lod.error = std::sqrt(max_cost) * radius;
+        mesh.lods.push_back(lod);
+        last_lod_triangles = live_triangles;
+    };
+
+    // Rejects collapses that would turn a remaining triangle by more than ~75 degrees. Any turn
+    // short of a flip would let a triangle fold over in a few steps.
+    auto flips_triangles = [&](u32 from, u32 to)
+    {
+        for (u32 t : vertex_triangles[from])
+        {
+            const u32 *triangle = triangles.data() + t * 3;
+            if (triangle_removed[t] || triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                continue;
+
+            glm::vec3 corners[3];
+            for (u32 k = 0; k < 3; ++k)
+                corners[k] = mesh.positions[triangle[k]];
+            const glm::vec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+            for (u32 k = 0; k < 3; ++k)
+            {
+                if (triangle[k] == from)
+                    corners[k] = mesh.positions[to];
+            }
+            const glm::vec3 after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+            if (glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after))
+                return true;
+        }
+        return false;
+    };
+
+    while (!queue.empty() && mesh.lods.size() < max_lod_count)
+    {
+        const Collapse collapse = queue.top();
+        queue.pop();
+        const u32 from = collapse.from;
+        const u32 to = collapse.to;
+        if (removed[from] || removed[to] || versions[from] != collapse.from_version || versions[to] != collapse.to_version)
+            continue;
+        if (flips_triangles(from, to))
+            continue;
+
+        // Triangles on the edge disappear, the others move over to the kept vertex
+        for (u32 t : vertex_triangles[from])
+        {
+            u32 *triangle = triangles.data() + t * 3;
+            if (triangle_removed[t])
+                continue;
+            if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+            {
+                triangle_removed[t] = true;
+                --live_triangles;
+                continue;
+            }
+            for (u32 k = 0; k < 3; ++k)
+            {
+                if (triangle[k] == from)
+                    triangle[k] = to;
+            }
+            vertex_triangles[to].push_back(t);
+        }
+
+        // The kept vertex takes over the border edge that led past it
+        if (border_next[from] == to)
+        {
+            border_previous[to] = border_previous[from];
+            border_next[border_previous[from]] = to;
+        }
+        else if (border_previous[from] == to)
+        {
+            border_next[to] = border_next[from];
+            border_previous[border_next[from]] = to;
+        }
+
+        quadrics[to] += quadrics[from];
+        removed[from] = true;
+        vertex_triangles[from].clear();
+        ++versions[to];
+        max_cost = std::max(max_cost, collapse.cost);
+
+        std::vector<u32> &around = vertex_triangles[to];
+        around.erase(std::remove_if(around.begin(), around.end(), [&triangle_removed](u32 t) { return triangle_removed[t]; }), around.end());
+        for (u32 t : around)
+        {
+            for (u32 k = 0; k < 3; ++k)
+            {
+                const u32 other = triangles[t * 3 + k];
+                if (other != to)
+                    push_edge(to, other);
+            }
+        }
+
+        if (live_triangles <= target_triangles)
+        {
+            emit_lod();
+            if (live_triangles <= MESH_LOD_MIN_TRIANGLE_COUNT)
+                break;
+            target_triangles = static_cast<u32>(live_triangles * reduction);
+        }
+    }
+
+    // Whatever the collapses reached is still worth a level when it saves a tenth of the triangles
+    if (mesh.lods.size() < max_lod_count && live_triangles * 10 <= last_lod_triangles * 9)
+        emit_lod();
+}
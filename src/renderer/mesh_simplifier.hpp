@@ -0,0 +1,28 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#ifndef MESH_SIMPLIFIER_HPP
+#define MESH_SIMPLIFIER_HPP
+
+#include "mesh_data.hpp"
+
+// Each LOD aims for MESH_LOD_REDUCTION of the previous one's triangles. The chain ends at
+// MESH_MAX_LOD_COUNT levels, below MESH_LOD_MIN_TRIANGLE_COUNT triangles or when no edge can
+// collapse anymore.
+static constexpr u32 MESH_MAX_LOD_COUNT = 6;
+static constexpr float MESH_LOD_REDUCTION = 0.5f;
+static constexpr u32 MESH_LOD_MIN_TRIANGLE_COUNT = 32;
+
+// How far a full step in one color channel counts, as a fraction of the mesh radius. Keeps
+// collapses from smearing vertex colors across flat regions.
+static constexpr float MESH_SIMPLIFY_COLOR_WEIGHT = 0.1f;
+
+// Builds the LOD chain of a mesh by edge collapse under quadric error metrics (Garland and
+// Heckbert 1998) over position and color. Collapses move a vertex onto a neighbour, so every
+// LOD is a range of indices over the mesh's unchanged vertices. Open borders only collapse
+// along themselves, their corners and vertices shared by attribute seams never move.
+// LOD 0 keeps the current indices (LOD 0's range when the mesh already has LODs), the coarser
+// LODs are appended to mesh.indices. Their MeshLod.error is the object space deviation from
+// LOD 0. Meshlets have to be rebuilt afterwards.
+void build_lods(MeshData &mesh, u32 max_lod_count = MESH_MAX_LOD_COUNT, float reduction = MESH_LOD_REDUCTION);
+
+#endif
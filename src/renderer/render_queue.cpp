@@ -0,0 +1,199 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#include "render_queue.hpp"
+
+#include "core/assert.hpp"
+#include "vulkan/buffers.hpp"
+#include "vulkan/command_buffer.hpp"
+#include "vulkan/vulkan_context.hpp"
+
+#include <algorithm>
+
+RenderQueue::RenderQueue(u32 draw_list_count)
+    : m_DrawLists(std::max(1u, draw_list_count))
+{
+}
+
+void RenderQueue::reset()
+{
+    for (DrawList &list : m_DrawLists)
+        list.clear();
+
+    m_Packets.clear();
+    m_Constants.clear();
+    m_SortItems.clear();
+    m_Pipelines.clear();
+    m_Materials.clear();
+    m_Geometries.clear();
+    m_IndirectDraws.clear();
+}
+
+u32 RenderQueue::add_pipeline(const RenderPipelineState &pipeline)
+{
+    m_Pipelines.push_back(pipeline);
+    return static_cast<u32>(m_Pipelines.size() - 1);
+}
+
+u32 RenderQueue::add_material(const RenderMaterial &material)
+{
+    m_Materials.push_back(material);
+    return static_cast<u32>(m_Materials.size() - 1);
+}
+
+u32 RenderQueue::add_geometry(const RenderGeometry &geometry)
+{
+    m_Geometries.push_back(geometry);
+    return static_cast<u32>(m_Geometries.size() - 1);
+}
+
+u32 RenderQueue::add_indirect_draw(const RenderIndirectDraw &draw)
+{
+    m_IndirectDraws.push_back(draw);
+    return static_cast<u32>(m_IndirectDraws.size() - 1);
+}
+
+void RenderQueue::sort()
+{
+    m_Packets.clear();
+    m_Constants.clear();
+    for (const DrawList &list : m_DrawLists)
+    {
+        // Constant offsets move from the list's arena into the merged one
+        const u32 constants_base = static_cast<u32>(m_Constants.size());
+        m_Constants.insert(m_Constants.end(), list.get_constants().begin(), list.get_constants().end());
+        for (DrawPacket packet : list.get_packets())
+        {
+            packet.constants_offset += constants_base;
+            m_Packets.push_back(packet);
+        }
+    }
+
+    m_SortItems.resize(m_Packets.size());
+    for (size_t i = 0; i < m_Packets.size(); ++i)
+        m_SortItems[i] = { m_Packets[i].sort_key, static_cast<u32>(i) };
+    radix_sort(m_SortItems, m_SortScratch);
+}
+
+bool RenderQueue::pack_indirect(IndirectBuffer &indirect_buffer) const
+{
+    if (get_packet_count() > indirect_buffer.get_max_draw_count())
+        return false;
+
+    // Straight into the mapped buffer, no per-frame staging of the arguments
+    for (u32 i = 0; i < get_packet_count(); ++i)
+    {
+        const DrawPacket &packet = get_packet(i);
+        DrawArguments args;
+        args.vertex_count = packet.index_count;
+        args.instance_count = packet.instance_count;
+        args.first_vertex = packet.first_index;
+        args.first_instance = packet.first_instance;
+        args.vertex_offset = packet.vertex_offset;
+        indirect_buffer.set_draw(i, args);
+    }
+    indirect_buffer.set_draw_count(get_packet_count());
+    return true;
+}
+
+void RenderQueue::translate(CommandBuffer &command_buffer, const VkViewport &viewport, const VkRect2D &scissor, u32 begin, u32 end,
+    const IndirectBuffer *indirect_buffer) const
+{
+    ASSERT(end <= get_packet_count(), "[RenderQueue] Packet range out of bounds");
+    ASSERT(!indirect_buffer || (indirect_buffer->is_indexed() && indirect_buffer->get_max_draw_count() >= get_packet_count()),
+        "[RenderQueue] Indirect buffer was not packed from this queue");
+
+    // Instanced packets start past instance 0, which indirect commands only may with drawIndirectFirstInstance
+    const bool draw_indirect = indirect_buffer && VulkanContext::get()->is_multi_draw_indirect_supported();
+
+    command_buffer.set_viewport(viewport);
+    command_buffer.set_scissor(scissor);
+
+    for (u32 i = begin; i < end;)
+    {
+        const DrawPacket &packet = get_packet(i);
+        const RenderPipelineState &pipeline = m_Pipelines[packet.pipeline];
+        const RenderMaterial &material = m_Materials[packet.material];
+        const RenderGeometry &geometry = m_Geometries[packet.geometry];
+
+        command_buffer.bind_graphics_pipeline(pipeline.pipeline);
+        if (!material.descriptor_sets.empty())
+            command_buffer.bind_descriptor_sets(pipeline.layout, material.descriptor_sets);
+        if (!geometry.vertex_buffers.empty())
+            command_buffer.bind_vertex_buffers(geometry.vertex_buffers, geometry.vertex_offsets);
+
+        if (geometry.index_buffer)
+            command_buffer.bind_index_buffer(geometry.index_buffer, geometry.index_offset, geometry.index_type);
+
+        if (packet.constants_size > 0 && !set_draw_constants(command_buffer, pipeline, packet))
+        {
+            ++i;
+            continue;
+        }
+
+        if (packet.indirect_draw != RENDER_QUEUE_NO_INDIRECT_DRAW)
+        {
+            ASSERT(geometry.index_buffer, "[RenderQueue] Indirect draws need indexed geometry");
+            const RenderIndirectDraw &draw = m_IndirectDraws[packet.indirect_draw];
+            if (draw.count_buffer)
+                command_buffer.draw_indexed_indirect_count(draw.buffer, draw.offset, draw.count_buffer, draw.count_offset, draw.max_draw_count, draw.stride);
+            else
+                command_buffer.draw_indexed_indirect(draw.buffer, draw.offset, draw.max_draw_count, draw.stride);
+            ++i;
+            continue;
+        }
+
+        if (draw_indirect && geometry.index_buffer)
+        {
+            // Sorting put packets with equal state next to each other, constants change per draw
+            u32 run_end = i + 1;
+            while (run_end < end && packet.constants_size == 0)
+            {
+                const DrawPacket &next = get_packet(run_end);
+                if (next.pipeline != packet.pipeline || next.material != packet.material || next.geometry != packet.geometry
+                    || next.constants_size > 0 || next.indirect_draw != RENDER_QUEUE_NO_INDIRECT_DRAW)
+                    break;
+                ++run_end;
+            }
+
+            command_buffer.draw_indexed_indirect(indirect_buffer->get_buffer(), indirect_buffer->get_command_offset(i), run_end - i,
+                indirect_buffer->get_stride());
+            i = run_end;
+            continue;
+        }
+
+        DrawArguments args;
+        args.vertex_count = packet.index_count;
+        args.instance_count = packet.instance_count;
+        args.first_vertex = packet.first_index;
+        args.first_instance = packet.first_instance;
+        args.vertex_offset = packet.vertex_offset;
+
+        if (geometry.index_buffer)
+            command_buffer.draw_indexed(args);
+        else
+            command_buffer.draw(args);
+        ++i;
+    }
+}
+
+bool RenderQueue::set_draw_constants(CommandBuffer &command_buffer, const RenderPipelineState &pipeline, const DrawPacket &packet) const
+{
+    const DrawConstantLayout &constants = pipeline.constants;
+    const u8 *data = m_Constants.data() + packet.constants_offset;
+
+    if (!constants.uniform_buffer)
+    {
+        command_buffer.set_push_constants(constants.stages, pipeline.layout, data, packet.constants_size, constants.offset);
+        return true;
+    }
+
+    const u32 dynamic_offset = constants.uniform_buffer->push(data, packet.constants_size);
+    if (dynamic_offset == DynamicUniformBuffer::INVALID_OFFSET)
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[RenderQueue] Draw constant buffer is full, draw skipped");
+        return false;
+    }
+
+    command_buffer.bind_dynamic_descriptor_set(pipeline.layout, constants.set, constants.uniform_buffer->get_descriptor_set(), dynamic_offset);
+    return true;
+}
@@ -0,0 +1,243 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#ifndef RENDER_QUEUE_HPP
+#define RENDER_QUEUE_HPP
+
+#include "core/types.hpp"
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <bit>
+#include <type_traits>
+#include <vector>
+
+class CommandBuffer;
+class DynamicUniformBuffer;
+class IndirectBuffer;
+
+// Sort key layouts, the most significant field changes least often after sorting.
+//   opaque:      pass:4 | pipeline:12 | material:16 | geometry:12 | depth:20      state first, front to back within equal state
+//   translucent: pass:4 | ~depth:24   | pipeline:12 | material:16 | geometry:8   back to front
+// Fields are truncated to their width, which only coarsens the ordering, the packet keeps the full indices.
+static constexpr u32 SORT_KEY_OPAQUE_DEPTH_BITS = 20;
+static constexpr u32 SORT_KEY_TRANSLUCENT_DEPTH_BITS = 24;
+
+// Fewer packets than this per thread are not worth their own secondary command buffer
+static constexpr u32 RENDER_QUEUE_MIN_CHUNK_SIZE = 64;
+
+// DrawPacket::indirect_draw of packets that draw their own index range
+static constexpr u32 RENDER_QUEUE_NO_INDIRECT_DRAW = ~0u;
+
+// Positive floats order like their bit patterns, so the top bits are a monotonic depth bucket
+static u32 quantize_sort_depth(float view_depth, u32 bits)
+{
+    const float depth = view_depth > 0.0f ? view_depth : 0.0f;
+    return std::bit_cast<u32>(depth) >> (32 - bits);
+}
+
+static u64 make_opaque_sort_key(u32 pass, u32 pipeline, u32 material, u32 geometry, float view_depth)
+{
+    return (static_cast<u64>(pass & 0xF) << 60)
+        | (static_cast<u64>(pipeline & 0xFFF) << 48)
+        | (static_cast<u64>(material & 0xFFFF) << 32)
+        | (static_cast<u64>(geometry & 0xFFF) << 20)
+        | static_cast<u64>(quantize_sort_depth(view_depth, SORT_KEY_OPAQUE_DEPTH_BITS));
+}
+
+static u64 make_translucent_sort_key(u32 pass, u32 pipeline, u32 material, u32 geometry, float view_depth)
+{
+    const u32 inverted_depth = ~quantize_sort_depth(view_depth, SORT_KEY_TRANSLUCENT_DEPTH_BITS) & 0xFFFFFF;
+    return (static_cast<u64>(pass & 0xF) << 60)
+        | (static_cast<u64>(inverted_depth) << 36)
+        | (static_cast<u64>(pipeline & 0xFFF) << 24)
+        | (static_cast<u64>(material & 0xFFFF) << 8)
+        | static_cast<u64>(geometry & 0xFF);
+}
+
+// Sort key of a packet and its position in the unsorted packets
+struct DrawSortItem
+{
+    u64 key;
+    u32 index;
+};
+
+// LSD radix sort on bytes, stable for equal keys. Each pass is a counting sort, passes where
+// every key has the same byte are skipped, which is common for the pass and pipeline fields.
+static void radix_sort(std::vector<DrawSortItem> &items, std::vector<DrawSortItem> &scratch)
+{
+    const size_t count = items.size();
+    scratch.resize(count);
+    for (u32 shift = 0; shift < 64; shift += 8)
+    {
+        std::array<u32, 256> offsets = {};
+        for (const DrawSortItem &item : items)
+            ++offsets[(item.key >> shift) & 0xFF];
+
+        if (count == 0 || offsets[(items[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        u32 sum = 0;
+        for (u32 &offset : offsets)
+        {
+            const u32 digit_count = offset;
+            offset = sum;
+            sum += digit_count;
+        }
+
+        for (const DrawSortItem &item : items)
+            scratch[offsets[(item.key >> shift) & 0xFF]++] = item;
+        items.swap(scratch);
+    }
+}
+
+// One draw, references state by index into the queue's tables so the stream stays POD
+struct DrawPacket
+{
+    u64 sort_key = 0;
+    u32 pipeline = 0;
+    u32 material = 0;
+    u32 geometry = 0;
+    u32 index_count = 0; // vertex count for geometry without index buffer
+    u32 first_index = 0;
+    i32 vertex_offset = 0;
+    u32 instance_count = 1;
+    u32 first_instance = 0;
+    u32 constants_offset = 0; // into the per-draw constants of the owning DrawList
+    u32 constants_size = 0; // no per-draw constants when zero
+    u32 indirect_draw = RENDER_QUEUE_NO_INDIRECT_DRAW; // into the queue's indirect draws, which replace the index range
+};
+static_assert(std::is_trivially_copyable_v<DrawPacket>);
+
+// Where a pipeline reads its per-draw constants. Push constants by default, a slice of
+// uniform_buffer bound at set when the block exceeds maxPushConstantsSize.
+struct DrawConstantLayout
+{
+    VkShaderStageFlags stages = 0;
+    u32 offset = 0;
+    DynamicUniformBuffer *uniform_buffer = nullptr;
+    u32 set = 0;
+};
+
+struct RenderPipelineState
+{
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    DrawConstantLayout constants;
+};
+
+struct RenderMaterial
+{
+    std::vector<VkDescriptorSet> descriptor_sets; // bound from set 0
+};
+
+struct RenderGeometry
+{
+    std::vector<VkBuffer> vertex_buffers;
+    std::vector<VkDeviceSize> vertex_offsets;
+    VkBuffer index_buffer = VK_NULL_HANDLE;
+    VkDeviceSize index_offset = 0;
+    VkIndexType index_type = VK_INDEX_TYPE_UINT32;
+};
+
+// Indexed draws whose commands the GPU writes, see GpuCulling. Up to max_draw_count commands
+// from offset are drawn, as many as the u32 at count_offset says when there is a count buffer.
+struct RenderIndirectDraw
+{
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkBuffer count_buffer = VK_NULL_HANDLE;
+    VkDeviceSize count_offset = 0;
+    u32 max_draw_count = 0;
+    u32 stride = sizeof(VkDrawIndexedIndirectCommand);
+};
+
+// Packets pushed by one thread, no synchronization. Per-draw constants are copied into a
+// byte arena that keeps its capacity across frames.
+class DrawList
+{
+public:
+    void push(const DrawPacket &packet) { m_Packets.push_back(packet); }
+
+    void push(DrawPacket packet, const void *constants, u32 size)
+    {
+        const u8 *bytes = static_cast<const u8 *>(constants);
+        packet.constants_offset = static_cast<u32>(m_Constants.size());
+        packet.constants_size = size;
+        m_Constants.insert(m_Constants.end(), bytes, bytes + size);
+        m_Packets.push_back(packet);
+    }
+
+    template<typename T>
+    void push(const DrawPacket &packet, const T &constants)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Draw constants have to be trivially copyable");
+        push(packet, &constants, static_cast<u32>(sizeof(T)));
+    }
+
+    void clear()
+    {
+        m_Packets.clear();
+        m_Constants.clear();
+    }
+
+    const std::vector<DrawPacket> &get_packets() const { return m_Packets; }
+    const std::vector<u8> &get_constants() const { return m_Constants; }
+
+private:
+    std::vector<DrawPacket> m_Packets;
+    std::vector<u8> m_Constants;
+};
+
+// Collects the draws of a frame from any number of threads, sorts them by key and
+// translates them into Vulkan commands. State tables are filled before traversal starts,
+// each traversal thread then only writes its own DrawList.
+class RenderQueue
+{
+public:
+    explicit RenderQueue(u32 draw_list_count = 1);
+
+    // Clears packets and tables, call once per frame
+    void reset();
+
+    u32 add_pipeline(const RenderPipelineState &pipeline);
+    u32 add_material(const RenderMaterial &material);
+    u32 add_geometry(const RenderGeometry &geometry);
+    u32 add_indirect_draw(const RenderIndirectDraw &draw);
+
+    DrawList &get_draw_list(u32 index) { return m_DrawLists[index]; }
+    u32 get_draw_list_count() const { return static_cast<u32>(m_DrawLists.size()); }
+
+    // Merges every draw list and radix sorts the packets by key, stable for equal keys
+    void sort();
+
+    // Writes the draw of every sorted packet at its sorted index, false when the buffer is too small
+    bool pack_indirect(IndirectBuffer &indirect_buffer) const;
+
+    // Records the sorted packets [begin, end), the command buffer drops binds that repeat.
+    // Per-draw constants are pushed before each draw that has them.
+    // Ranges are independent, so ParallelCommandRecorder can split the queue across threads.
+    // With an indexed buffer filled by pack_indirect, runs of packets sharing all state become one indirect draw.
+    // Packets with an indirect draw always draw it, with or without an indirect buffer.
+    void translate(CommandBuffer &command_buffer, const VkViewport &viewport, const VkRect2D &scissor, u32 begin, u32 end,
+        const IndirectBuffer *indirect_buffer = nullptr) const;
+
+    u32 get_packet_count() const { return static_cast<u32>(m_SortItems.size()); }
+    const DrawPacket &get_packet(u32 index) const { return m_Packets[m_SortItems[index].index]; }
+
+private:
+    // False when the constants could not be stored and the draw has to be skipped
+    bool set_draw_constants(CommandBuffer &command_buffer, const RenderPipelineState &pipeline, const DrawPacket &packet) const;
+
+    std::vector<DrawList> m_DrawLists;
+    std::vector<DrawPacket> m_Packets; // merged, unsorted
+    std::vector<u8> m_Constants; // merged per-draw constants of every draw list
+    std::vector<DrawSortItem> m_SortItems; // in key order after sort()
+    std::vector<DrawSortItem> m_SortScratch;
+
+    std::vector<RenderPipelineState> m_Pipelines;
+    std::vector<RenderMaterial> m_Materials;
+    std::vector<RenderGeometry> m_Geometries;
+    std::vector<RenderIndirectDraw> m_IndirectDraws;
+};
+
+#endif
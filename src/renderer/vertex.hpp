@@ -3,15 +3,114 @@
 #ifndef VERTEX_HPP
 #define VERTEX_HPP
 
+#include "core/types.hpp"
+
 #include <vulkan/vulkan.h>
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <vector>
 
 #include <glm/glm.hpp>
 
-struct Vertex
+// Positions are unorm16 within the bounds of their mesh: position = offset + value * scale, with
+// value in [0, 1] as the vertex fetch delivers it. Laid out as two vec4 so it can be pushed as
+// it is, w is unused.
+struct VertexQuantization
+{
+    glm::vec4 offset = glm::vec4(0.0f);
+    glm::vec4 scale = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+};
+
+// VK_FORMAT_R16G16B16A16_UNORM, w is padding
+struct PackedPosition
+{
+    u16 x, y, z, w;
+};
+static_assert(sizeof(PackedPosition) == 8);
+
+// VK_FORMAT_R8G8B8A8_UNORM
+struct PackedColor
+{
+    u8 r, g, b, a;
+};
+static_assert(sizeof(PackedColor) == 4);
+
+// Vertex streams of every mesh, one tightly packed array each
+enum MeshStream : u32
 {
-    glm::vec3 position;
-    glm::vec3 color;
+    MESH_STREAM_POSITION = 0, // PackedPosition
+    MESH_STREAM_COLOR, // PackedColor
+    MESH_STREAM_COUNT
+};
+
+static const std::vector<u32> MESH_STREAM_STRIDES = {
+    sizeof(PackedPosition), // MESH_STREAM_POSITION
+    sizeof(PackedColor), // MESH_STREAM_COLOR
 };
 
-#endif
\ No newline at end of file
+// Meshes whose vertices 16-bit indices can address store those, indices are relative to the mesh
+static VkIndexType get_mesh_index_type(u32 vertex_count)
+{
+    return vertex_count <= 0x10000 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+}
+
+static u32 get_index_size(VkIndexType index_type)
+{
+    return index_type == VK_INDEX_TYPE_UINT16 ? sizeof(u16) : sizeof(u32);
+}
+
+// Degenerate axes keep a non-zero scale so decoding never divides by zero
+static VertexQuantization make_vertex_quantization(const glm::vec3 &min, const glm::vec3 &max)
+{
+    VertexQuantization quantization;
+    quantization.offset = glm::vec4(min, 0.0f);
+    quantization.scale = glm::vec4(glm::max(max - min, glm::vec3(1e-6f)), 0.0f);
+    return quantization;
+}
+
+static u16 quantize_unorm16(float value)
+{
+    return static_cast<u16>(std::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+
+static u8 quantize_unorm8(float value)
+{
+    return static_cast<u8>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+static PackedPosition encode_position(const glm::vec3 &position, const VertexQuantization &quantization)
+{
+    const glm::vec3 value = (position - glm::vec3(quantization.offset)) / glm::vec3(quantization.scale);
+    return { quantize_unorm16(value.x), quantize_unorm16(value.y), quantize_unorm16(value.z), 0 };
+}
+
+static glm::vec3 decode_position(const PackedPosition &position, const VertexQuantization &quantization)
+{
+    const glm::vec3 value = glm::vec3(position.x, position.y, position.z) / 65535.0f;
+    return glm::vec3(quantization.offset) + value * glm::vec3(quantization.scale);
+}
+
+// The decode as a matrix on the unorm values, lets instances that draw with an identity
+// quantization carry their mesh's decode in their transform
+static glm::mat4 get_dequantization_matrix(const VertexQuantization &quantization)
+{
+    glm::mat4 matrix(1.0f);
+    matrix[0][0] = quantization.scale.x;
+    matrix[1][1] = quantization.scale.y;
+    matrix[2][2] = quantization.scale.z;
+    matrix[3] = glm::vec4(glm::vec3(quantization.offset), 1.0f);
+    return matrix;
+}
+
+static PackedColor encode_color(const glm::vec3 &color)
+{
+    return { quantize_unorm8(color.r), quantize_unorm8(color.g), quantize_unorm8(color.b), 255 };
+}
+
+static glm::vec3 decode_color(const PackedColor &color)
+{
+    return glm::vec3(color.r, color.g, color.b) / 255.0f;
+}
+
+#endif
@@ -4,8 +4,12 @@
 #include "vulkan_wrapper.hpp"
 
 #include "vulkan_context.hpp"
+#include "graphics_pipeline.hpp"
 
-VulkanBuffer::VulkanBuffer(VkDeviceSize size, VkBufferUsageFlags usage)
+#include <algorithm>
+
+VulkanBuffer::VulkanBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memory_properties)
+    : m_MemoryProperties(memory_properties)
 {
     const VkDevice device = VulkanContext::get()->get_device();
    
@@ -54,6 +58,7 @@ void VulkanBuffer::bind_memory(VkDeviceSize offset)
 
 void VulkanBuffer::set_data(const void *data, VkDeviceSize size, VkDeviceSize offset)
 {
+    ASSERT(m_MemoryProperties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, "[Vulkan] set_data on a device local buffer, upload through a StagingBuffer");
     const VkDevice device = VulkanContext::get()->get_device();
     copy_data_to_buffer(device, m_Memory, data, size, offset);
 }
@@ -78,8 +83,7 @@ void VulkanBuffer::allocate_memory()
     VkMemoryAllocateInfo alloc_info = {};
     alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
     alloc_info.allocationSize = mem_requirements.size;
-    alloc_info.memoryTypeIndex = find_memory_type(physical_device, mem_requirements.memoryTypeBits,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    alloc_info.memoryTypeIndex = find_memory_type(physical_device, mem_requirements.memoryTypeBits, m_MemoryProperties);
 
     VkResult result = vkAllocateMemory(device, &alloc_info, VK_NULL_HANDLE, &m_Memory);
     VK_ERROR_CHECK(result, "[Vulkan] Failed to allocate vertex buffer memory");
@@ -102,12 +106,34 @@ Ref<VertexBuffer> VertexBuffer::create(void *data, VkDeviceSize size)
 
 
 // ====== INDEX BUFFER ======
+static VkIndexType get_narrowest_index_type(const std::vector<uint32_t> &indices)
+{
+    const uint32_t max_index = indices.empty() ? 0 : *std::max_element(indices.begin(), indices.end());
+    return max_index < 0x10000 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+}
+
 IndexBuffer::IndexBuffer(const std::vector<uint32_t> &indices)
-    : m_Count(static_cast<uint32_t>(indices.size()))
-    , VulkanBuffer((const void *)indices.data(), indices.size() * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
+    : IndexBuffer(indices, get_narrowest_index_type(indices))
 {
 }
 
+IndexBuffer::IndexBuffer(const std::vector<uint32_t> &indices, VkIndexType index_type)
+    : VulkanBuffer(indices.size() * get_index_size(index_type), VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
+    , m_Count(static_cast<uint32_t>(indices.size()))
+    , m_IndexType(index_type)
+{
+    bind_memory();
+    if (index_type == VK_INDEX_TYPE_UINT16)
+    {
+        const std::vector<u16> narrow_indices(indices.begin(), indices.end());
+        set_data(narrow_indices.data(), narrow_indices.size() * sizeof(u16));
+    }
+    else
+    {
+        set_data(indices.data(), indices.size() * sizeof(uint32_t));
+    }
+}
+
 IndexBuffer::~IndexBuffer()
 {
 }
@@ -117,6 +143,216 @@ Ref<IndexBuffer> IndexBuffer::create(const std::vector<uint32_t> &indices)
     return CreateRef<IndexBuffer>(indices);
 }
 
+// ====== STORAGE BUFFER ======
+StorageBuffer::StorageBuffer(VkDeviceSize size, VkBufferUsageFlags additional_usage)
+    : VulkanBuffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | additional_usage)
+{
+    bind_memory();
+}
+
+StorageBuffer::~StorageBuffer()
+{
+}
+
+Ref<StorageBuffer> StorageBuffer::create(VkDeviceSize size, VkBufferUsageFlags additional_usage)
+{
+    return CreateRef<StorageBuffer>(size, additional_usage);
+}
+
+// ====== STAGING BUFFER ======
+// Keeps every copy source 16 byte aligned for the memcpy into mapped memory
+static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+StagingBuffer::StagingBuffer(VkDeviceSize size)
+    : VulkanBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+{
+    bind_memory();
+
+    void *mapped_data;
+    VkResult result = vkMapMemory(VulkanContext::get()->get_device(), m_Memory, 0, m_BufferSize, 0, &mapped_data);
+    VK_ERROR_CHECK(result, "[Vulkan] Failed to map staging buffer");
+    m_Mapped = static_cast<u8 *>(mapped_data);
+}
+
+StagingBuffer::~StagingBuffer()
+{
+}
+
+Ref<StagingBuffer> StagingBuffer::create(VkDeviceSize size)
+{
+    return CreateRef<StagingBuffer>(size);
+}
+
+void *StagingBuffer::allocate(VkBuffer dst, VkDeviceSize dst_offset, VkDeviceSize size)
+{
+    const VkDeviceSize reserved = (size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+    const VkDeviceSize offset = m_Cursor.fetch_add(reserved, std::memory_order_relaxed);
+    if (offset + size > m_BufferSize)
+        return nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(m_CopyMutex);
+        m_Copies.push_back({ dst, { offset, dst_offset, size } });
+    }
+    return m_Mapped + offset;
+}
+
+void StagingBuffer::upload(VkBuffer dst, VkDeviceSize dst_offset, const void *data, VkDeviceSize size)
+{
+    const u8 *bytes = static_cast<const u8 *>(data);
+    while (size > 0)
+    {
+        const VkDeviceSize chunk = std::min(size, m_BufferSize);
+        void *mapped = allocate(dst, dst_offset, chunk);
+        if (!mapped)
+        {
+            flush();
+            continue;
+        }
+
+        std::memcpy(mapped, bytes, chunk);
+        bytes += chunk;
+        dst_offset += chunk;
+        size -= chunk;
+    }
+}
+
+void StagingBuffer::flush()
+{
+    std::lock_guard<std::mutex> lock(m_CopyMutex);
+    if (!m_Copies.empty())
+    {
+        VulkanContext::get()->immediate_submit([this](VkCommandBuffer command_buffer)
+        {
+            // Copies are grouped by destination, one command per buffer
+            std::sort(m_Copies.begin(), m_Copies.end(), [](const PendingCopy &a, const PendingCopy &b) { return a.dst < b.dst; });
+
+            std::vector<VkBufferCopy> regions;
+            for (size_t i = 0; i < m_Copies.size();)
+            {
+                regions.clear();
+                const VkBuffer dst = m_Copies[i].dst;
+                for (; i < m_Copies.size() && m_Copies[i].dst == dst; ++i)
+                    regions.push_back(m_Copies[i].region);
+                vkCmdCopyBuffer(command_buffer, m_Buffer, dst, static_cast<u32>(regions.size()), regions.data());
+            }
+
+            // Later submissions read the copied data as any kind of geometry or shader input
+            VkMemoryBarrier barrier = {};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT
+                | VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT;
+            vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                0, 1, &barrier, 0, nullptr, 0, nullptr);
+        });
+        m_Copies.clear();
+    }
+    m_Cursor.store(0, std::memory_order_relaxed);
+}
+
+void StagingBuffer::destroy()
+{
+    vkUnmapMemory(VulkanContext::get()->get_device(), m_Memory);
+    m_Mapped = nullptr;
+    VulkanBuffer::destroy();
+}
+
+// ====== INDIRECT BUFFER ======
+IndirectBuffer::IndirectBuffer(uint32_t max_draw_count, bool indexed)
+    : VulkanBuffer(COMMANDS_OFFSET + static_cast<VkDeviceSize>(max_draw_count)
+        * (indexed ? sizeof(VkDrawIndexedIndirectCommand) : sizeof(VkDrawIndirectCommand)),
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+    , m_MaxDrawCount(max_draw_count)
+    , m_Stride(indexed ? sizeof(VkDrawIndexedIndirectCommand) : sizeof(VkDrawIndirectCommand))
+    , m_Indexed(indexed)
+{
+    bind_memory();
+
+    void *mapped_data;
+    VkResult result = vkMapMemory(VulkanContext::get()->get_device(), m_Memory, 0, m_BufferSize, 0, &mapped_data);
+    VK_ERROR_CHECK(result, "[Vulkan] Failed to map indirect buffer");
+    m_Mapped = static_cast<u8 *>(mapped_data);
+    set_draw_count(0);
+}
+
+IndirectBuffer::~IndirectBuffer()
+{
+}
+
+Ref<IndirectBuffer> IndirectBuffer::create(uint32_t max_draw_count, bool indexed)
+{
+    return CreateRef<IndirectBuffer>(max_draw_count, indexed);
+}
+
+bool IndirectBuffer::set_draws(const std::vector<DrawArguments> &draws, uint32_t first_draw)
+{
+    if (first_draw > m_MaxDrawCount || draws.size() > m_MaxDrawCount - first_draw)
+        return false;
+
+    for (size_t i = 0; i < draws.size(); ++i)
+        set_draw(first_draw + static_cast<uint32_t>(i), draws[i]);
+    set_draw_count(first_draw + static_cast<uint32_t>(draws.size()));
+    return true;
+}
+
+void IndirectBuffer::set_draw(uint32_t draw_index, const DrawArguments &args)
+{
+    ASSERT(draw_index < m_MaxDrawCount, "[Vulkan] Indirect draw index out of range");
+    u8 *command = m_Mapped + get_command_offset(draw_index);
+    if (m_Indexed)
+    {
+        const VkDrawIndexedIndirectCommand indexed = { args.vertex_count, args.instance_count, args.first_vertex, args.vertex_offset, args.first_instance };
+        std::memcpy(command, &indexed, sizeof(indexed));
+    }
+    else
+    {
+        const VkDrawIndirectCommand direct = { args.vertex_count, args.instance_count, args.first_vertex, args.first_instance };
+        std::memcpy(command, &direct, sizeof(direct));
+    }
+}
+
+void IndirectBuffer::set_draw_count(uint32_t draw_count)
+{
+    std::memcpy(m_Mapped + COUNT_OFFSET, &draw_count, sizeof(draw_count));
+}
+
+void IndirectBuffer::destroy()
+{
+    vkUnmapMemory(VulkanContext::get()->get_device(), m_Memory);
+    m_Mapped = nullptr;
+    VulkanBuffer::destroy();
+}
+
+// ====== INSTANCE BUFFER ======
+InstanceBuffer::InstanceBuffer(uint32_t stride, uint32_t max_instance_count)
+    : VulkanBuffer(static_cast<VkDeviceSize>(stride) * max_instance_count,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+    , m_Stride(stride)
+    , m_MaxInstanceCount(max_instance_count)
+{
+    bind_memory();
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+}
+
+Ref<InstanceBuffer> InstanceBuffer::create(uint32_t stride, uint32_t max_instance_count)
+{
+    return CreateRef<InstanceBuffer>(stride, max_instance_count);
+}
+
+bool InstanceBuffer::set_instances(const void *data, uint32_t count, uint32_t first_instance)
+{
+    if (first_instance > m_MaxInstanceCount || count > m_MaxInstanceCount - first_instance)
+        return false;
+
+    if (count > 0)
+        set_data(data, static_cast<VkDeviceSize>(count) * m_Stride, static_cast<VkDeviceSize>(first_instance) * m_Stride);
+    return true;
+}
+
 UniformBuffer::UniformBuffer(VkDeviceSize size, uint32_t binding_location)
     : VulkanBuffer(size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT), m_BindingLocation(binding_location)
 {
@@ -179,3 +415,83 @@ void UniformBuffer::destroy()
         m_DescriptorSet = VK_NULL_HANDLE;
     }
 }
+
+// ====== DYNAMIC UNIFORM BUFFER ======
+DynamicUniformBuffer::DynamicUniformBuffer(VkDeviceSize size, uint32_t max_range)
+    : VulkanBuffer(size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+    , m_Alignment(std::max<VkDeviceSize>(1, VulkanContext::get()->get_device_limits().minUniformBufferOffsetAlignment))
+    , m_MaxRange(max_range)
+{
+    ASSERT(max_range <= size, "[Vulkan] Dynamic uniform range exceeds the buffer");
+    bind_memory();
+
+    void *mapped_data;
+    VkResult result = vkMapMemory(VulkanContext::get()->get_device(), m_Memory, 0, m_BufferSize, 0, &mapped_data);
+    VK_ERROR_CHECK(result, "[Vulkan] Failed to map dynamic uniform buffer");
+    m_Mapped = static_cast<u8 *>(mapped_data);
+}
+
+DynamicUniformBuffer::~DynamicUniformBuffer()
+{
+}
+
+Ref<DynamicUniformBuffer> DynamicUniformBuffer::create(VkDeviceSize size, uint32_t max_range)
+{
+    return CreateRef<DynamicUniformBuffer>(size, max_range);
+}
+
+uint32_t DynamicUniformBuffer::push(const void *data, uint32_t size)
+{
+    ASSERT(size <= m_MaxRange, "[Vulkan] Dynamic uniform data exceeds the descriptor range");
+
+    // Slices reserve the whole descriptor range, the shader may read all of it
+    const VkDeviceSize slice_size = (static_cast<VkDeviceSize>(m_MaxRange) + m_Alignment - 1) / m_Alignment * m_Alignment;
+    const VkDeviceSize offset = m_Cursor.fetch_add(slice_size, std::memory_order_relaxed);
+    if (offset + m_MaxRange > m_BufferSize)
+        return INVALID_OFFSET;
+
+    std::memcpy(m_Mapped + offset, data, size);
+    return static_cast<uint32_t>(offset);
+}
+
+void DynamicUniformBuffer::create_descriptor_set(VkDescriptorSetLayout layout, uint32_t binding)
+{
+    const VkDevice device = VulkanContext::get()->get_device();
+
+    VkDescriptorSetAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = VulkanContext::get()->get_descriptor_pool();
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &layout;
+
+    VkResult result = vkAllocateDescriptorSets(device, &alloc_info, &m_DescriptorSet);
+    VK_ERROR_CHECK(result, "[Vulkan] Failed to allocate descriptor set");
+
+    const VkDescriptorBufferInfo buffer_info = { m_Buffer, 0, m_MaxRange };
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = m_DescriptorSet;
+    write.dstBinding = binding;
+    write.dstArrayElement = 0;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    write.descriptorCount = 1;
+    write.pBufferInfo = &buffer_info;
+
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+void DynamicUniformBuffer::destroy()
+{
+    const VkDevice device = VulkanContext::get()->get_device();
+
+    if (m_DescriptorSet != VK_NULL_HANDLE)
+    {
+        vkFreeDescriptorSets(device, VulkanContext::get()->get_descriptor_pool(), 1, &m_DescriptorSet);
+        m_DescriptorSet = VK_NULL_HANDLE;
+    }
+
+    vkUnmapMemory(device, m_Memory);
+    m_Mapped = nullptr;
+    VulkanBuffer::destroy();
+}
@@ -3,7 +3,9 @@
 #ifndef VULKAN_BUFFER_HPP
 #define VULKAN_BUFFER_HPP
 
+#include <atomic>
 #include <cstring>
+#include <mutex>
 #include <vulkan/vulkan.h>
 #include "renderer/vertex.hpp"
 
@@ -35,7 +37,9 @@ static void copy_data_to_buffer(VkDevice device, VkDeviceMemory buffer_memory, c
 class VulkanBuffer
 {
 public:
-    VulkanBuffer(VkDeviceSize size, VkBufferUsageFlags usage);
+    // Device local buffers are filled with copies, see StagingBuffer
+    VulkanBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+        VkMemoryPropertyFlags memory_properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
     VulkanBuffer(const void *data, VkDeviceSize size, VkBufferUsageFlags usage);
     virtual ~VulkanBuffer() {};
 
@@ -44,6 +48,7 @@ public:
     virtual void set_data(const void *data, VkDeviceSize size, VkDeviceSize offset = 0);
     VkDeviceMemory get_buffer_memory() const { return m_Memory; }
     VkBuffer get_buffer() const { return m_Buffer; }
+    VkDeviceSize get_size() const { return m_BufferSize; }
 
     virtual void destroy();
 private:
@@ -51,6 +56,7 @@ private:
 
 protected:
     VkDeviceSize m_BufferSize = 0;
+    VkMemoryPropertyFlags m_MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
     VkBuffer m_Buffer;
     VkDeviceMemory m_Memory;
 };
@@ -63,16 +69,124 @@ public:
     static Ref<VertexBuffer> create(void *data, VkDeviceSize size);
 };
 
+// Stores 16-bit indices whenever the largest index fits, see get_mesh_index_type
 class IndexBuffer : public VulkanBuffer
 {
 public:
     IndexBuffer(const std::vector<uint32_t> &indices);
+    // index_type has to address every index
+    IndexBuffer(const std::vector<uint32_t> &indices, VkIndexType index_type);
     ~IndexBuffer() override;
     
     static Ref<IndexBuffer> create(const std::vector<uint32_t> &indices);
     uint32_t get_count() const { return m_Count; }
+    VkIndexType get_index_type() const { return m_IndexType; }
 private:
     uint32_t m_Count;
+    VkIndexType m_IndexType;
+};
+
+// Read/write buffer for compute shaders (and indirect arguments when requested)
+class StorageBuffer : public VulkanBuffer
+{
+public:
+    StorageBuffer(VkDeviceSize size, VkBufferUsageFlags additional_usage = 0);
+    ~StorageBuffer() override;
+
+    static Ref<StorageBuffer> create(VkDeviceSize size, VkBufferUsageFlags additional_usage = 0);
+};
+
+// Host visible source of copies into device local buffers. Space is handed out linearly by an
+// atomic cursor so loader threads can fill it concurrently, flush() then records every pending
+// copy into one immediate submission and makes the space reusable.
+class StagingBuffer : public VulkanBuffer
+{
+public:
+    explicit StagingBuffer(VkDeviceSize size);
+    ~StagingBuffer() override;
+
+    static Ref<StagingBuffer> create(VkDeviceSize size);
+
+    // Reserves size bytes that flush() copies to dst at dst_offset, nullptr when the space
+    // is used up. Writing the returned memory directly avoids an intermediate copy.
+    void *allocate(VkBuffer dst, VkDeviceSize dst_offset, VkDeviceSize size);
+
+    // Copies data through the staging space, flushing whenever it runs full
+    void upload(VkBuffer dst, VkDeviceSize dst_offset, const void *data, VkDeviceSize size);
+
+    // Submits the pending copies and waits for them. No allocate() may run concurrently.
+    void flush();
+
+    void destroy() override;
+private:
+    struct PendingCopy
+    {
+        VkBuffer dst;
+        VkBufferCopy region;
+    };
+
+    u8 *m_Mapped = nullptr;
+    std::atomic<VkDeviceSize> m_Cursor = 0;
+    std::mutex m_CopyMutex;
+    std::vector<PendingCopy> m_Copies;
+};
+
+struct DrawArguments;
+
+// Draw commands the GPU reads with the indirect draw calls, filled on the CPU with set_draws
+// or written by compute shaders. A u32 draw count sits in front of the commands, padded so
+// the commands start 16 byte aligned, for draw_indexed_indirect_count.
+class IndirectBuffer : public VulkanBuffer
+{
+public:
+    static constexpr VkDeviceSize COUNT_OFFSET = 0;
+    static constexpr VkDeviceSize COMMANDS_OFFSET = 16;
+
+    IndirectBuffer(uint32_t max_draw_count, bool indexed = true);
+    ~IndirectBuffer() override;
+
+    static Ref<IndirectBuffer> create(uint32_t max_draw_count, bool indexed = true);
+
+    // Packs draws into VkDrawIndexedIndirectCommand or VkDrawIndirectCommand starting at first_draw
+    // and stores first_draw + draws.size() as draw count. Returns false when they do not fit.
+    bool set_draws(const std::vector<DrawArguments> &draws, uint32_t first_draw = 0);
+
+    // Writes single commands straight into the mapped buffer, draw_index has to be below the max draw count
+    void set_draw(uint32_t draw_index, const DrawArguments &args);
+    void set_draw_count(uint32_t draw_count);
+
+    void destroy() override;
+
+    VkDeviceSize get_command_offset(uint32_t draw_index) const { return COMMANDS_OFFSET + static_cast<VkDeviceSize>(draw_index) * m_Stride; }
+    uint32_t get_max_draw_count() const { return m_MaxDrawCount; }
+    uint32_t get_stride() const { return m_Stride; }
+    bool is_indexed() const { return m_Indexed; }
+private:
+    u8 *m_Mapped = nullptr; // for the buffer's lifetime, rewritten every frame
+    uint32_t m_MaxDrawCount;
+    uint32_t m_Stride;
+    bool m_Indexed;
+};
+
+// Per-instance attributes, bound as a VK_VERTEX_INPUT_RATE_INSTANCE binding or read as a storage
+// buffer indexed with gl_InstanceIndex. Instances are packed at a fixed stride and an instanced
+// draw selects its range with first_instance.
+class InstanceBuffer : public VulkanBuffer
+{
+public:
+    InstanceBuffer(uint32_t stride, uint32_t max_instance_count);
+    ~InstanceBuffer() override;
+
+    static Ref<InstanceBuffer> create(uint32_t stride, uint32_t max_instance_count);
+
+    // Copies count instances of stride bytes each, false when they do not fit
+    bool set_instances(const void *data, uint32_t count, uint32_t first_instance = 0);
+
+    uint32_t get_stride() const { return m_Stride; }
+    uint32_t get_max_instance_count() const { return m_MaxInstanceCount; }
+private:
+    uint32_t m_Stride;
+    uint32_t m_MaxInstanceCount;
 };
 
 class UniformBuffer : public VulkanBuffer
@@ -92,4 +206,37 @@ private:
     uint32_t m_BindingLocation;
 };
 
+// Per-draw uniform data that does not fit in push constants. The buffer stays mapped and slices
+// are handed out by an atomic cursor, so recording threads can write concurrently. Shaders read
+// a slice through a VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC binding at the returned offset.
+class DynamicUniformBuffer : public VulkanBuffer
+{
+public:
+    static constexpr uint32_t INVALID_OFFSET = ~0u;
+
+    // max_range is the largest slice and the range of the descriptor
+    DynamicUniformBuffer(VkDeviceSize size, uint32_t max_range);
+    ~DynamicUniformBuffer() override;
+
+    static Ref<DynamicUniformBuffer> create(VkDeviceSize size, uint32_t max_range);
+
+    // Releases every slice, once per frame after VulkanContext::begin_frame
+    void reset() { m_Cursor.store(0, std::memory_order_relaxed); }
+
+    // Copies data into a new slice and returns its dynamic offset, INVALID_OFFSET when the buffer is full
+    uint32_t push(const void *data, uint32_t size);
+
+    void create_descriptor_set(VkDescriptorSetLayout layout, uint32_t binding = 0);
+    VkDescriptorSet get_descriptor_set() const { return m_DescriptorSet; }
+    uint32_t get_max_range() const { return m_MaxRange; }
+
+    void destroy() override;
+private:
+    u8 *m_Mapped = nullptr;
+    std::atomic<VkDeviceSize> m_Cursor = 0;
+    VkDeviceSize m_Alignment;
+    uint32_t m_MaxRange;
+    VkDescriptorSet m_DescriptorSet = VK_NULL_HANDLE;
+};
+
 #endif
\ No newline at end of file
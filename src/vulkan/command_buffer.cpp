@@ -4,8 +4,9 @@
 #include "vulkan_context.hpp"
 #include "vulkan_wrapper.hpp"
 
+#include <algorithm>
+
 CommandBuffer::CommandBuffer(uint32_t count)
-    : m_ActiveGraphicsPipeline(VK_NULL_HANDLE)
 {
     const auto device = VulkanContext::get()->get_device();
     const auto command_pool = VulkanContext::get()->get_command_pool();
@@ -19,35 +20,64 @@ CommandBuffer::CommandBuffer(uint32_t count)
     };
 
     m_Handles.resize(alloc_info.commandBufferCount);
+    m_CommandPools.assign(m_Handles.size(), command_pool);
 
     VkResult result = vkAllocateCommandBuffers(device, &alloc_info, m_Handles.data());
     VK_ERROR_CHECK(result, "[Vulkan] Failed to allocate command buffer");
 }
 
-void CommandBuffer::begin(VkCommandBufferUsageFlags flags)
+CommandBuffer::CommandBuffer(const std::vector<VkCommandPool> &frame_pools, VkCommandBufferLevel level)
+    : m_CommandPools(frame_pools), m_Level(level), m_ResetOnBegin(false)
+{
+    const auto device = VulkanContext::get()->get_device();
+
+    m_Handles.resize(m_CommandPools.size());
+    for (size_t i = 0; i < m_CommandPools.size(); ++i)
+    {
+        VkCommandBufferAllocateInfo alloc_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = m_CommandPools[i],
+            .level = level,
+            .commandBufferCount = 1
+        };
+
+        VkResult result = vkAllocateCommandBuffers(device, &alloc_info, &m_Handles[i]);
+        VK_ERROR_CHECK(result, "[Vulkan] Failed to allocate command buffer");
+    }
+}
+
+void CommandBuffer::begin(VkCommandBufferUsageFlags flags, const VkCommandBufferInheritanceInfo *inheritance)
 {
     VkCommandBuffer handle = get_active_handle();
 
-    VkResult reset_result = VulkanContext::get()->reset_command_buffer(handle);
-    VK_ERROR_CHECK(reset_result, "[Vulkan] Failed to reset command buffer");
+    if (m_ResetOnBegin)
+    {
+        VkResult reset_result = VulkanContext::get()->reset_command_buffer(handle);
+        VK_ERROR_CHECK(reset_result, "[Vulkan] Failed to reset command buffer");
+    }
+
+    ASSERT(m_Level == VK_COMMAND_BUFFER_LEVEL_PRIMARY || inheritance, "[Vulkan] Secondary command buffer needs inheritance info");
 
     VkCommandBufferBeginInfo begin_info = {
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
         .pNext = VK_NULL_HANDLE,
         .flags = flags,
-        .pInheritanceInfo = VK_NULL_HANDLE
+        .pInheritanceInfo = inheritance
     };
 
     VK_ERROR_CHECK(vkBeginCommandBuffer(handle, &begin_info), "Failed to begin command buffer");
 
-    m_ActiveGraphicsPipeline = VK_NULL_HANDLE;
+    // Nothing is bound at the start of a command buffer, not even in a secondary one
+    invalidate_bound_state();
+    m_Stats = {};
+    m_InsideRenderPass = false;
 }
 
 void CommandBuffer::end()
 {
-    if (m_ActiveGraphicsPipeline)
+    if (m_InsideRenderPass)
     {
-        vkCmdEndRenderPass(get_active_handle());
+        end_render_pass();
     }
 
     VK_ERROR_CHECK(vkEndCommandBuffer(get_active_handle()), "[Vulkan] Failed to end command buffer recording");
@@ -56,48 +86,232 @@ void CommandBuffer::end()
 void CommandBuffer::destroy()
 {
     const auto device = VulkanContext::get()->get_device();
-    const auto command_pool = VulkanContext::get()->get_command_pool();
-    vkFreeCommandBuffers(device, command_pool, static_cast<uint32_t>(m_Handles.size()), m_Handles.data());
+    for (size_t i = 0; i < m_Handles.size(); ++i)
+    {
+        vkFreeCommandBuffers(device, m_CommandPools[i], 1, &m_Handles[i]);
+    }
 
     m_Handles.clear();
+    m_CommandPools.clear();
 }
 
-void CommandBuffer::set_graphics_state(const GraphicsState &state)
+void CommandBuffer::begin_render_pass(const RenderPassState &state, VkSubpassContents contents)
 {
+    ASSERT(m_Level == VK_COMMAND_BUFFER_LEVEL_PRIMARY, "[Vulkan] Render passes begin in primary command buffers");
+    ASSERT(!m_InsideRenderPass, "[Vulkan] Render pass already begun");
+
     VkRenderPassBeginInfo render_pass_begin_info = {
         .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
         .pNext = VK_NULL_HANDLE,
         .renderPass = state.render_pass,
         .framebuffer = state.framebuffer,
-        .renderArea = state.scissor,
+        .renderArea = state.render_area,
         .clearValueCount = 1,
         .pClearValues = &state.clear_value,
     };
 
-    VkCommandBuffer active_handle = get_active_handle();
+    vkCmdBeginRenderPass(get_active_handle(), &render_pass_begin_info, contents);
+    m_InsideRenderPass = true;
+}
 
-    vkCmdBeginRenderPass(active_handle, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
-    vkCmdBindPipeline(active_handle, VK_PIPELINE_BIND_POINT_GRAPHICS, state.pipeline);
-    m_ActiveGraphicsPipeline = state.pipeline;
+void CommandBuffer::end_render_pass()
+{
+    vkCmdEndRenderPass(get_active_handle());
+    m_InsideRenderPass = false;
+}
 
-    vkCmdSetViewport(active_handle, 0, 1, &state.viewport);
-    vkCmdSetScissor(active_handle, 0, 1, &state.scissor);
+void CommandBuffer::execute_commands(const std::vector<VkCommandBuffer> &command_buffers)
+{
+    if (command_buffers.empty())
+        return;
 
-    VkDeviceSize offsets[] = { 0 };
-    vkCmdBindVertexBuffers(active_handle, 0, 1, state.vertex_buffers.data(), offsets);
+    vkCmdExecuteCommands(get_active_handle(), static_cast<uint32_t>(command_buffers.size()), command_buffers.data());
+
+    // Secondary buffers leave the bound state of the primary undefined
+    invalidate_bound_state();
+}
+
+void CommandBuffer::set_graphics_state(const GraphicsState &state)
+{
+    ASSERT(m_Level == VK_COMMAND_BUFFER_LEVEL_SECONDARY || m_InsideRenderPass, "[Vulkan] Draw state bound outside of a render pass");
+
+    bind_graphics_pipeline(state.pipeline);
+    set_viewport(state.viewport);
+    set_scissor(state.scissor);
+
+    if (!state.vertex_buffers.empty())
+    {
+        ASSERT(state.vertex_offsets.empty() || state.vertex_offsets.size() == state.vertex_buffers.size(),
+            "[Vulkan] Vertex offsets do not match vertex buffers");
+        bind_vertex_buffers(state.vertex_buffers, state.vertex_offsets);
+    }
 
     if (state.index_buffer.buffer)
     {
-        vkCmdBindIndexBuffer(active_handle, state.index_buffer.buffer, state.index_buffer.offset,
-            state.index_buffer.index_type);
+        bind_index_buffer(state.index_buffer.buffer, state.index_buffer.offset, state.index_buffer.index_type);
     }
 
     if (!state.descriptor_sets.empty())
     {
-        vkCmdBindDescriptorSets(active_handle, VK_PIPELINE_BIND_POINT_GRAPHICS, state.pipeline_layout,
-            0, static_cast<uint32_t>(state.descriptor_sets.size()), state.descriptor_sets.data(),
-            0, nullptr);
+        bind_descriptor_sets(state.pipeline_layout, state.descriptor_sets);
+    }
+}
+
+void CommandBuffer::bind_graphics_pipeline(VkPipeline pipeline)
+{
+    if (m_Bound.pipeline == pipeline)
+    {
+        ++m_Stats.skipped_binds;
+        return;
+    }
+
+    vkCmdBindPipeline(get_active_handle(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    m_Bound.pipeline = pipeline;
+    ++m_Stats.bind_calls;
+}
+
+void CommandBuffer::set_viewport(const VkViewport &viewport)
+{
+    const VkViewport &bound = m_Bound.viewport;
+    if (m_Bound.has_viewport && bound.x == viewport.x && bound.y == viewport.y && bound.width == viewport.width
+        && bound.height == viewport.height && bound.minDepth == viewport.minDepth && bound.maxDepth == viewport.maxDepth)
+    {
+        ++m_Stats.skipped_binds;
+        return;
+    }
+
+    vkCmdSetViewport(get_active_handle(), 0, 1, &viewport);
+    m_Bound.viewport = viewport;
+    m_Bound.has_viewport = true;
+    ++m_Stats.bind_calls;
+}
+
+void CommandBuffer::set_scissor(const VkRect2D &scissor)
+{
+    const VkRect2D &bound = m_Bound.scissor;
+    if (m_Bound.has_scissor && bound.offset.x == scissor.offset.x && bound.offset.y == scissor.offset.y
+        && bound.extent.width == scissor.extent.width && bound.extent.height == scissor.extent.height)
+    {
+        ++m_Stats.skipped_binds;
+        return;
+    }
+
+    vkCmdSetScissor(get_active_handle(), 0, 1, &scissor);
+    m_Bound.scissor = scissor;
+    m_Bound.has_scissor = true;
+    ++m_Stats.bind_calls;
+}
+
+void CommandBuffer::bind_vertex_buffers(const std::vector<VkBuffer> &buffers, const std::vector<VkDeviceSize> &offsets, uint32_t first_binding)
+{
+    const uint32_t count = static_cast<uint32_t>(buffers.size());
+    const uint32_t required = first_binding + count;
+    if (m_Bound.vertex_buffers.size() < required)
+    {
+        m_Bound.vertex_buffers.resize(required, VK_NULL_HANDLE);
+        m_Bound.vertex_offsets.resize(required, 0);
+    }
+
+    // Only rebind the span between the first and last binding that changed
+    uint32_t first_changed = count;
+    uint32_t last_changed = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const VkDeviceSize offset = i < offsets.size() ? offsets[i] : 0;
+        if (m_Bound.vertex_buffers[first_binding + i] != buffers[i] || m_Bound.vertex_offsets[first_binding + i] != offset)
+        {
+            first_changed = std::min(first_changed, i);
+            last_changed = i;
+        }
+    }
+
+    if (first_changed == count)
+    {
+        ++m_Stats.skipped_binds;
+        return;
+    }
+
+    for (uint32_t i = first_changed; i <= last_changed; ++i)
+    {
+        m_Bound.vertex_buffers[first_binding + i] = buffers[i];
+        m_Bound.vertex_offsets[first_binding + i] = i < offsets.size() ? offsets[i] : 0;
+    }
+
+    vkCmdBindVertexBuffers(get_active_handle(), first_binding + first_changed, last_changed - first_changed + 1,
+        &m_Bound.vertex_buffers[first_binding + first_changed], &m_Bound.vertex_offsets[first_binding + first_changed]);
+    ++m_Stats.bind_calls;
+}
+
+void CommandBuffer::bind_index_buffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType index_type)
+{
+    if (m_Bound.index_buffer == buffer && m_Bound.index_offset == offset && m_Bound.index_type == index_type)
+    {
+        ++m_Stats.skipped_binds;
+        return;
+    }
+
+    vkCmdBindIndexBuffer(get_active_handle(), buffer, offset, index_type);
+    m_Bound.index_buffer = buffer;
+    m_Bound.index_offset = offset;
+    m_Bound.index_type = index_type;
+    ++m_Stats.bind_calls;
+}
+
+void CommandBuffer::bind_descriptor_sets(VkPipelineLayout layout, const std::vector<VkDescriptorSet> &descriptor_sets, uint32_t first_set)
+{
+    // Sets stay bound across compatible layouts, only compare when the layout is the same
+    uint32_t first_changed = 0;
+    if (m_Bound.descriptor_layout == layout)
+    {
+        const uint32_t count = static_cast<uint32_t>(descriptor_sets.size());
+        while (first_changed < count && first_set + first_changed < m_Bound.descriptor_sets.size()
+            && m_Bound.descriptor_sets[first_set + first_changed] == descriptor_sets[first_changed])
+        {
+            ++first_changed;
+        }
+
+        if (first_changed == count)
+        {
+            ++m_Stats.skipped_binds;
+            return;
+        }
+    }
+    else
+    {
+        m_Bound.descriptor_sets.clear();
+    }
+
+    // Sets after the bound range are no longer known to be valid
+    m_Bound.descriptor_sets.resize(first_set, VK_NULL_HANDLE);
+    m_Bound.descriptor_sets.insert(m_Bound.descriptor_sets.end(), descriptor_sets.begin(), descriptor_sets.end());
+    m_Bound.descriptor_layout = layout;
+
+    vkCmdBindDescriptorSets(get_active_handle(), VK_PIPELINE_BIND_POINT_GRAPHICS, layout,
+        first_set + first_changed, static_cast<uint32_t>(descriptor_sets.size()) - first_changed, descriptor_sets.data() + first_changed,
+        0, nullptr);
+    ++m_Stats.bind_calls;
+}
+
+void CommandBuffer::bind_dynamic_descriptor_set(VkPipelineLayout layout, uint32_t set, VkDescriptorSet descriptor_set, uint32_t dynamic_offset)
+{
+    if (m_Bound.descriptor_layout != layout)
+    {
+        m_Bound.descriptor_sets.clear();
+        m_Bound.descriptor_layout = layout;
     }
+
+    // Never matches a set passed to bind_descriptor_sets, which then binds again
+    if (m_Bound.descriptor_sets.size() <= set)
+        m_Bound.descriptor_sets.resize(set + 1, VK_NULL_HANDLE);
+    m_Bound.descriptor_sets[set] = VK_NULL_HANDLE;
+
+    vkCmdBindDescriptorSets(get_active_handle(), VK_PIPELINE_BIND_POINT_GRAPHICS, layout, set, 1, &descriptor_set, 1, &dynamic_offset);
+    ++m_Stats.bind_calls;
+}
+
+void CommandBuffer::invalidate_bound_state()
+{
+    m_Bound = {};
 }
 
 void CommandBuffer::draw(const DrawArguments &args)
@@ -111,10 +325,95 @@ void CommandBuffer::draw_indexed(const DrawArguments &args)
         args.vertex_offset, args.first_instance);
 }
 
-void CommandBuffer::set_push_constants(VkShaderStageFlagBits shader_stage, VkPipelineLayout layout,
+void CommandBuffer::draw_indirect(VkBuffer buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride)
+{
+    VkCommandBuffer active_handle = get_active_handle();
+    if (draw_count <= 1 || VulkanContext::get()->is_multi_draw_indirect_supported())
+    {
+        vkCmdDrawIndirect(active_handle, buffer, offset, draw_count, stride);
+        return;
+    }
+
+    for (uint32_t i = 0; i < draw_count; ++i)
+        vkCmdDrawIndirect(active_handle, buffer, offset + static_cast<VkDeviceSize>(i) * stride, 1, stride);
+}
+
+void CommandBuffer::draw_indexed_indirect(VkBuffer buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride)
+{
+    VkCommandBuffer active_handle = get_active_handle();
+    if (draw_count <= 1 || VulkanContext::get()->is_multi_draw_indirect_supported())
+    {
+        vkCmdDrawIndexedIndirect(active_handle, buffer, offset, draw_count, stride);
+        return;
+    }
+
+    for (uint32_t i = 0; i < draw_count; ++i)
+        vkCmdDrawIndexedIndirect(active_handle, buffer, offset + static_cast<VkDeviceSize>(i) * stride, 1, stride);
+}
+
+void CommandBuffer::draw_indexed_indirect_count(VkBuffer buffer, VkDeviceSize offset, VkBuffer count_buffer, VkDeviceSize count_offset,
+    uint32_t max_draw_count, uint32_t stride)
+{
+    if (!VulkanContext::get()->is_draw_indirect_count_supported())
+    {
+        draw_indexed_indirect(buffer, offset, max_draw_count, stride);
+        return;
+    }
+
+    vkCmdDrawIndexedIndirectCount(get_active_handle(), buffer, offset, count_buffer, count_offset, max_draw_count, stride);
+}
+
+void CommandBuffer::set_push_constants(VkShaderStageFlags stages, VkPipelineLayout layout,
     const void *data, uint32_t size, uint32_t offset)
 {
-    vkCmdPushConstants(get_active_handle(), layout, shader_stage, 0, size, data);
+    vkCmdPushConstants(get_active_handle(), layout, stages, offset, size, data);
+}
+
+void CommandBuffer::bind_compute_pipeline(const ComputePipeline &pipeline)
+{
+    VkCommandBuffer active_handle = get_active_handle();
+    vkCmdBindPipeline(active_handle, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.get_handle());
+
+    const auto &descriptor_sets = pipeline.get_descriptor_sets();
+    if (!descriptor_sets.empty())
+    {
+        vkCmdBindDescriptorSets(active_handle, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.get_layout(),
+            0, static_cast<uint32_t>(descriptor_sets.size()), descriptor_sets.data(),
+            0, nullptr);
+    }
+}
+
+void CommandBuffer::dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
+{
+    vkCmdDispatch(get_active_handle(), group_count_x, group_count_y, group_count_z);
+}
+
+void CommandBuffer::dispatch_indirect(VkBuffer buffer, VkDeviceSize offset)
+{
+    vkCmdDispatchIndirect(get_active_handle(), buffer, offset);
+}
+
+void CommandBuffer::fill_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t data)
+{
+    vkCmdFillBuffer(get_active_handle(), buffer, offset, size, data);
+}
+
+void CommandBuffer::buffer_barrier(VkBuffer buffer, VkPipelineStageFlags src_stage, VkAccessFlags src_access,
+    VkPipelineStageFlags dst_stage, VkAccessFlags dst_access, VkDeviceSize offset, VkDeviceSize size)
+{
+    VkBufferMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .pNext = VK_NULL_HANDLE,
+        .srcAccessMask = src_access,
+        .dstAccessMask = dst_access,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = buffer,
+        .offset = offset,
+        .size = size
+    };
+
+    vkCmdPipelineBarrier(get_active_handle(), src_stage, dst_stage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
 }
 
 Ref<CommandBuffer> CommandBuffer::create(uint32_t count)
@@ -4,33 +4,114 @@
 #define VULKAN_COMMAND_BUFFER_HPP
 
 #include "graphics_pipeline.hpp"
+#include "compute_pipeline.hpp"
 #include <vulkan/vulkan.h>
 #include <vector>
 
+// Binds issued and skipped because the state was already bound, since begin()
+struct CommandBufferStats
+{
+    uint32_t bind_calls = 0;
+    uint32_t skipped_binds = 0;
+
+    CommandBufferStats &operator+=(const CommandBufferStats &other)
+    {
+        bind_calls += other.bind_calls;
+        skipped_binds += other.skipped_binds;
+        return *this;
+    }
+};
+
+// Shadows the bound graphics state and drops binds that would not change it
 class CommandBuffer
 {
 public:
     CommandBuffer(uint32_t count = 0);
+    // One handle per frame, handle i is allocated from frame_pools[i].
+    // The owner resets the pools, so begin() does not reset the handle.
+    CommandBuffer(const std::vector<VkCommandPool> &frame_pools, VkCommandBufferLevel level);
     ~CommandBuffer();
     
-    void begin(VkCommandBufferUsageFlags flags);
+    // Secondary buffers recorded inside a render pass need the inheritance info
+    void begin(VkCommandBufferUsageFlags flags, const VkCommandBufferInheritanceInfo *inheritance = nullptr);
     void end();
 
     void destroy();
 
+    void begin_render_pass(const RenderPassState &state, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+    void end_render_pass();
+    // Only valid in a render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+    void execute_commands(const std::vector<VkCommandBuffer> &command_buffers);
+
+    // Binds the draw state, a primary buffer has to be inside a render pass
     void set_graphics_state(const GraphicsState &state);
+    void bind_graphics_pipeline(VkPipeline pipeline);
+    void set_viewport(const VkViewport &viewport);
+    void set_scissor(const VkRect2D &scissor);
+    void bind_vertex_buffers(const std::vector<VkBuffer> &buffers, const std::vector<VkDeviceSize> &offsets = {}, uint32_t first_binding = 0);
+    void bind_index_buffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType index_type);
+    void bind_descriptor_sets(VkPipelineLayout layout, const std::vector<VkDescriptorSet> &descriptor_sets, uint32_t first_set = 0);
+    // A set with one dynamic uniform buffer, the offset changes per draw so this always binds
+    void bind_dynamic_descriptor_set(VkPipelineLayout layout, uint32_t set, VkDescriptorSet descriptor_set, uint32_t dynamic_offset);
+
     void draw(const DrawArguments &args);
     void draw_indexed(const DrawArguments &args);
-    void set_push_constants(VkShaderStageFlagBits shader_stage, VkPipelineLayout layout, const void *data, uint32_t size, uint32_t offset = 0);
+
+    // Draw arguments read from GPU buffers. Without multiDrawIndirect every draw is its own call.
+    void draw_indirect(VkBuffer buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride = sizeof(VkDrawIndirectCommand));
+    void draw_indexed_indirect(VkBuffer buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride = sizeof(VkDrawIndexedIndirectCommand));
+    // Draw count read from count_buffer, clamped to max_draw_count. Without drawIndirectCount all
+    // max_draw_count commands are issued, so writers have to zero the instance count of unused ones.
+    void draw_indexed_indirect_count(VkBuffer buffer, VkDeviceSize offset, VkBuffer count_buffer, VkDeviceSize count_offset,
+        uint32_t max_draw_count, uint32_t stride = sizeof(VkDrawIndexedIndirectCommand));
+    // stages has to include every stage whose push constant range overlaps [offset, offset + size)
+    void set_push_constants(VkShaderStageFlags stages, VkPipelineLayout layout, const void *data, uint32_t size, uint32_t offset = 0);
+
+    // Compute, must be recorded outside of a render pass
+    void bind_compute_pipeline(const ComputePipeline &pipeline);
+    void dispatch(uint32_t group_count_x, uint32_t group_count_y = 1, uint32_t group_count_z = 1);
+    void dispatch_indirect(VkBuffer buffer, VkDeviceSize offset = 0);
+
+    // Transfer, outside of a render pass. size and offset are multiples of 4
+    void fill_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t data);
+
+    void buffer_barrier(VkBuffer buffer, VkPipelineStageFlags src_stage, VkAccessFlags src_access,
+        VkPipelineStageFlags dst_stage, VkAccessFlags dst_access, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
 
     static Ref<CommandBuffer> create(uint32_t count = 0);
 
     const std::vector<VkCommandBuffer> &get_handles() const { return m_Handles; }
     VkCommandBuffer get_handle(uint32_t index) const { return m_Handles[index]; }
     VkCommandBuffer get_active_handle();
+    VkCommandBufferLevel get_level() const { return m_Level; }
+    const CommandBufferStats &get_stats() const { return m_Stats; }
 private:
+    // Forgets the shadowed state, the next binds are issued unconditionally
+    void invalidate_bound_state();
+
+    struct BoundState
+    {
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkViewport viewport = {};
+        VkRect2D scissor = {};
+        bool has_viewport = false;
+        bool has_scissor = false;
+        std::vector<VkBuffer> vertex_buffers;
+        std::vector<VkDeviceSize> vertex_offsets;
+        VkBuffer index_buffer = VK_NULL_HANDLE;
+        VkDeviceSize index_offset = 0;
+        VkIndexType index_type = VK_INDEX_TYPE_UINT32;
+        VkPipelineLayout descriptor_layout = VK_NULL_HANDLE;
+        std::vector<VkDescriptorSet> descriptor_sets;
+    };
+
     std::vector<VkCommandBuffer> m_Handles;
-    VkPipeline m_ActiveGraphicsPipeline;
+    std::vector<VkCommandPool> m_CommandPools; // pool of each handle
+    VkCommandBufferLevel m_Level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    bool m_ResetOnBegin = true;
+    bool m_InsideRenderPass = false;
+    BoundState m_Bound;
+    CommandBufferStats m_Stats;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,177 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "compute_pipeline.hpp"
+#include "vulkan_context.hpp"
+#include "vulkan_wrapper.hpp"
+
+#include <algorithm>
+
+ComputePipeline::~ComputePipeline()
+{
+    ASSERT(m_Handle == VK_NULL_HANDLE, "Forgeting to call destroy()");
+}
+
+ComputePipeline &ComputePipeline::set_shader(const Ref<Shader> &shader)
+{
+    ASSERT(shader->get_stage_flag() == VK_SHADER_STAGE_COMPUTE_BIT, "[Vulkan] Compute pipeline requires a compute shader");
+    m_Shader = shader;
+    return *this;
+}
+
+ComputePipeline &ComputePipeline::set_specialization_constants(const SpecializationConstants &constants)
+{
+    m_Specialization = constants;
+    return *this;
+}
+
+void ComputePipeline::build()
+{
+    const VkDevice device = VulkanContext::get()->get_device();
+
+    // Descriptor set layouts, indexed by set number. Missing set numbers get an empty
+    // layout so all sets can be bound with a single call
+    const auto &set_bindings = m_Shader->get_descriptor_set_layout_bindings();
+    u32 set_count = 0;
+    for (const auto &[set, bindings] : set_bindings)
+        set_count = std::max(set_count, set + 1);
+
+    m_SetLayouts.resize(set_count, VK_NULL_HANDLE);
+    for (u32 set = 0; set < set_count; ++set)
+    {
+        std::vector<VkDescriptorSetLayoutBinding> bindings;
+        if (auto it = set_bindings.find(set); it != set_bindings.end())
+            bindings = it->second;
+
+        VkDescriptorSetLayoutCreateInfo set_info = {};
+        set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        set_info.bindingCount = static_cast<u32>(bindings.size());
+        set_info.pBindings = bindings.empty() ? nullptr : bindings.data();
+
+        VkResult result = vkCreateDescriptorSetLayout(device, &set_info, VK_NULL_HANDLE, &m_SetLayouts[set]);
+        VK_ERROR_CHECK(result, "[Vulkan] Failed to create compute descriptor set layout");
+    }
+
+    if (!m_SetLayouts.empty())
+    {
+        VkDescriptorSetAllocateInfo alloc_info = {};
+        alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        alloc_info.descriptorPool = VulkanContext::get()->get_descriptor_pool();
+        alloc_info.descriptorSetCount = static_cast<u32>(m_SetLayouts.size());
+        alloc_info.pSetLayouts = m_SetLayouts.data();
+
+        m_DescriptorSets.resize(m_SetLayouts.size());
+        VkResult result = vkAllocateDescriptorSets(device, &alloc_info, m_DescriptorSets.data());
+        VK_ERROR_CHECK(result, "[Vulkan] Failed to allocate compute descriptor sets");
+    }
+
+    const auto &push_ranges = m_Shader->get_push_constant_ranges();
+    VkPipelineLayoutCreateInfo layout_create_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = static_cast<u32>(m_SetLayouts.size()),
+        .pSetLayouts = m_SetLayouts.empty() ? nullptr : m_SetLayouts.data(),
+        .pushConstantRangeCount = static_cast<u32>(push_ranges.size()),
+        .pPushConstantRanges = push_ranges.empty() ? nullptr : push_ranges.data(),
+    };
+
+    VkResult result = vkCreatePipelineLayout(device, &layout_create_info, VK_NULL_HANDLE, &m_Layout);
+    VK_ERROR_CHECK(result, "[Vulkan] Failed to create compute pipeline layout");
+
+    VkPipelineShaderStageCreateInfo stage = m_Shader->get_stage();
+    stage.pSpecializationInfo = m_Specialization.get_info();
+
+    VkComputePipelineCreateInfo pipeline_create_info = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = stage,
+        .layout = m_Layout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1
+    };
+
+    result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_create_info, VK_NULL_HANDLE, &m_Handle);
+    VK_ERROR_CHECK(result, "[Vulkan] Failed to create compute pipeline");
+}
+
+void ComputePipeline::destroy()
+{
+    const VkDevice device = VulkanContext::get()->get_device();
+
+    if (!m_DescriptorSets.empty())
+    {
+        vkFreeDescriptorSets(device, VulkanContext::get()->get_descriptor_pool(),
+            static_cast<u32>(m_DescriptorSets.size()), m_DescriptorSets.data());
+        m_DescriptorSets.clear();
+    }
+
+    for (auto layout : m_SetLayouts)
+        vkDestroyDescriptorSetLayout(device, layout, VK_NULL_HANDLE);
+    m_SetLayouts.clear();
+
+    if (m_Handle != VK_NULL_HANDLE)
+    {
+        vkDestroyPipeline(device, m_Handle, VK_NULL_HANDLE);
+        m_Handle = VK_NULL_HANDLE;
+    }
+
+    if (m_Layout != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineLayout(device, m_Layout, VK_NULL_HANDLE);
+        m_Layout = VK_NULL_HANDLE;
+    }
+
+    m_Shader.reset();
+}
+
+void ComputePipeline::bind_storage_buffer(u32 set, u32 binding, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    const VkDescriptorBufferInfo buffer_info = { buffer, offset, range };
+    write_descriptor(set, binding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &buffer_info, nullptr);
+}
+
+void ComputePipeline::bind_uniform_buffer(u32 set, u32 binding, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    const VkDescriptorBufferInfo buffer_info = { buffer, offset, range };
+    write_descriptor(set, binding, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, &buffer_info, nullptr);
+}
+
+void ComputePipeline::bind_storage_image(u32 set, u32 binding, VkImageView image_view, VkImageLayout layout)
+{
+    const VkDescriptorImageInfo image_info = { VK_NULL_HANDLE, image_view, layout };
+    write_descriptor(set, binding, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, nullptr, &image_info);
+}
+
+void ComputePipeline::bind_sampled_image(u32 set, u32 binding, VkImageView image_view, VkSampler sampler, VkImageLayout layout)
+{
+    const VkDescriptorImageInfo image_info = { sampler, image_view, layout };
+    write_descriptor(set, binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, nullptr, &image_info);
+}
+
+void ComputePipeline::write_descriptor(u32 set, u32 binding, VkDescriptorType type, const VkDescriptorBufferInfo *buffer_info,
+    const VkDescriptorImageInfo *image_info)
+{
+    ASSERT(set < m_DescriptorSets.size(), "[Vulkan] Compute descriptor set index out of range");
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = m_DescriptorSets[set];
+    write.dstBinding = binding;
+    write.dstArrayElement = 0;
+    write.descriptorType = type;
+    write.descriptorCount = 1;
+    write.pBufferInfo = buffer_info;
+    write.pImageInfo = image_info;
+
+    vkUpdateDescriptorSets(VulkanContext::get()->get_device(), 1, &write, 0, nullptr);
+}
+
+u32 ComputePipeline::get_group_count(u32 item_count, u32 axis) const
+{
+    const u32 local_size = m_Shader->get_local_size()[axis];
+    return (item_count + local_size - 1) / local_size;
+}
+
+Ref<ComputePipeline> ComputePipeline::create(const Ref<Shader> &shader)
+{
+    Ref<ComputePipeline> pipeline = CreateRef<ComputePipeline>();
+    pipeline->set_shader(shader).build();
+    return pipeline;
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#ifndef VULKAN_COMPUTE_PIPELINE_HPP
+#define VULKAN_COMPUTE_PIPELINE_HPP
+
+#include "shader.hpp"
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+class ComputePipeline
+{
+public:
+    ComputePipeline() = default;
+    ~ComputePipeline();
+
+    ComputePipeline &set_shader(const Ref<Shader> &shader);
+    ComputePipeline &set_specialization_constants(const SpecializationConstants &constants);
+
+    // Creates descriptor set layouts, pipeline layout, descriptor sets and the pipeline
+    // from the compute shader reflection
+    void build();
+    void destroy();
+
+    // Descriptor writes into the pipeline owned descriptor sets
+    void bind_storage_buffer(u32 set, u32 binding, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+    void bind_uniform_buffer(u32 set, u32 binding, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+    void bind_storage_image(u32 set, u32 binding, VkImageView image_view, VkImageLayout layout = VK_IMAGE_LAYOUT_GENERAL);
+    void bind_sampled_image(u32 set, u32 binding, VkImageView image_view, VkSampler sampler,
+        VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    // Number of workgroups needed to cover item_count invocations along an axis
+    u32 get_group_count(u32 item_count, u32 axis = 0) const;
+
+    VkPipeline get_handle() const { return m_Handle; }
+    VkPipelineLayout get_layout() const { return m_Layout; }
+    const std::vector<VkDescriptorSet> &get_descriptor_sets() const { return m_DescriptorSets; }
+    const Ref<Shader> &get_shader() const { return m_Shader; }
+
+    static Ref<ComputePipeline> create(const Ref<Shader> &shader);
+
+private:
+    void write_descriptor(u32 set, u32 binding, VkDescriptorType type, const VkDescriptorBufferInfo *buffer_info,
+        const VkDescriptorImageInfo *image_info);
+
+    VkPipeline m_Handle = VK_NULL_HANDLE;
+    VkPipelineLayout m_Layout = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSetLayout> m_SetLayouts;
+    std::vector<VkDescriptorSet> m_DescriptorSets;
+
+    Ref<Shader> m_Shader;
+    SpecializationConstants m_Specialization;
+};
+
+#endif //VULKAN_COMPUTE_PIPELINE_HPP
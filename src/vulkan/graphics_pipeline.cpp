@@ -1,12 +1,111 @@
 // Copyright (c) 2025 Evangelion Manuhutu
 
 #include "graphics_pipeline.hpp"
+#include "pipeline_library.hpp"
 #include "vulkan_wrapper.hpp"
 
+#include "core/thread_pool.hpp"
+
 #include <algorithm>
+#include <chrono>
 
 #include "vulkan_context.hpp"
 
+// Viewport and scissor are always dynamic
+static constexpr VkDynamicState s_DynamicStates[] =
+{
+    VK_DYNAMIC_STATE_VIEWPORT,
+    VK_DYNAMIC_STATE_SCISSOR
+};
+
+// Fixed function state shared by the monolithic and the library build paths
+struct PipelineStates
+{
+    VkPipelineRasterizationStateCreateInfo rasterization;
+    VkPipelineMultisampleStateCreateInfo multisample;
+    VkPipelineDepthStencilStateCreateInfo depth_stencil;
+    VkPipelineColorBlendAttachmentState color_blend_attachment;
+    VkPipelineColorBlendStateCreateInfo color_blend;
+    VkPipelineViewportStateCreateInfo viewport;
+    VkPipelineDynamicStateCreateInfo dynamic;
+    VkPipelineInputAssemblyStateCreateInfo input_assembly;
+    VkPipelineVertexInputStateCreateInfo vertex_input;
+};
+
+static void fill_pipeline_states(const GraphicsPipelineInfo &info, PipelineStates &states)
+{
+    states.rasterization = {};
+    states.rasterization.sType                   = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    states.rasterization.depthClampEnable        = VK_FALSE;
+    states.rasterization.rasterizerDiscardEnable = VK_FALSE;
+    states.rasterization.polygonMode             = info.polygon_mode;
+    states.rasterization.lineWidth               = info.line_width;
+    states.rasterization.cullMode                = info.cull_mode;
+    states.rasterization.frontFace               = info.front_face;
+    states.rasterization.depthBiasEnable         = VK_FALSE;
+
+    states.multisample = {};
+    states.multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    states.multisample.sampleShadingEnable  = VK_FALSE;
+    states.multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    // Ignored by render passes without a depth attachment
+    states.depth_stencil = {};
+    states.depth_stencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    states.depth_stencil.depthTestEnable = info.depth_test;
+    states.depth_stencil.depthWriteEnable = info.depth_write;
+    states.depth_stencil.depthCompareOp = info.depth_compare_op;
+    states.depth_stencil.depthBoundsTestEnable = VK_FALSE;
+    states.depth_stencil.stencilTestEnable = info.stencil_test;
+    states.depth_stencil.minDepthBounds = 0.0f;
+    states.depth_stencil.maxDepthBounds = 1.0f;
+
+    states.color_blend_attachment = {};
+    states.color_blend_attachment.colorWriteMask = info.color_write_mask;
+    states.color_blend_attachment.blendEnable    = info.blending;
+
+    states.color_blend = {};
+    states.color_blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    states.color_blend.logicOpEnable = VK_FALSE;
+    states.color_blend.logicOp = VK_LOGIC_OP_COPY;
+    states.color_blend.attachmentCount = 1;
+    states.color_blend.pAttachments = &states.color_blend_attachment;
+    states.color_blend.blendConstants[0] = 0.0f;
+    states.color_blend.blendConstants[1] = 0.0f;
+    states.color_blend.blendConstants[2] = 0.0f;
+    states.color_blend.blendConstants[3] = 0.0f;
+
+    // Viewport state with dynamic viewport and scissor (no static values needed)
+    states.viewport = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1,
+        .pViewports = nullptr,  // Will be set dynamically
+        .scissorCount = 1,
+        .pScissors = nullptr    // Will be set dynamically
+    };
+
+    states.dynamic = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = static_cast<uint32_t>(std::size(s_DynamicStates)),
+        .pDynamicStates = s_DynamicStates
+    };
+
+    states.input_assembly = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .topology = info.topology,
+        .primitiveRestartEnable = VK_FALSE,
+    };
+
+    // Build vertex input state from stored data
+    states.vertex_input = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+        .vertexBindingDescriptionCount = static_cast<uint32_t>(info.binding_descriptions.size()),
+        .pVertexBindingDescriptions = info.binding_descriptions.data(),
+        .vertexAttributeDescriptionCount = static_cast<uint32_t>(info.attribute_descriptions.size()),
+        .pVertexAttributeDescriptions = info.attribute_descriptions.data()
+    };
+}
+
 GraphicsPipeline::GraphicsPipeline()
     : m_Handle(VK_NULL_HANDLE), m_Layout(VK_NULL_HANDLE)
 {
@@ -15,7 +114,12 @@ GraphicsPipeline::GraphicsPipeline()
 void GraphicsPipeline::destroy()
 {
     auto device = VulkanContext::get()->get_device();
-    
+
+    if (m_OptimizedHandle.valid())
+    {
+        vkDestroyPipeline(device, m_OptimizedHandle.get(), VK_NULL_HANDLE);
+    }
+
     if (m_Handle != VK_NULL_HANDLE)
     {
         vkDestroyPipeline(device, m_Handle, VK_NULL_HANDLE);
@@ -42,98 +146,259 @@ GraphicsPipeline &GraphicsPipeline::add_shader(const Ref<Shader> &shader)
     return *this;
 }
 
-void GraphicsPipeline::build(const GraphicsPipelineInfo& info)
+GraphicsPipeline &GraphicsPipeline::set_specialization_constants(VkShaderStageFlagBits stage, const SpecializationConstants &constants)
 {
-    auto device = VulkanContext::get()->get_device();
+    m_Specializations[stage] = constants;
+    return *this;
+}
 
-    // Store the pipeline layout
-    m_Layout = info.layout;
+void GraphicsPipeline::replace_shader(const Ref<Shader> &old_shader, const Ref<Shader> &new_shader)
+{
+    for (auto &shader : m_Shaders)
+    {
+        if (shader == old_shader)
+            shader = new_shader;
+    }
+}
 
-    VkPipelineRasterizationStateCreateInfo rasterization_info = {};
-    rasterization_info.sType                   = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterization_info.depthClampEnable        = VK_FALSE;
-    rasterization_info.rasterizerDiscardEnable = VK_FALSE;
-    rasterization_info.polygonMode             = info.polygon_mode;
-    rasterization_info.lineWidth               = info.line_width;
-    rasterization_info.cullMode                = info.cull_mode;
-    rasterization_info.frontFace               = info.front_face;
-    rasterization_info.depthBiasEnable         = VK_FALSE;
-
-    VkPipelineMultisampleStateCreateInfo multisample_info = {};
-    multisample_info.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisample_info.sampleShadingEnable  = VK_FALSE;
-    multisample_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-    VkPipelineColorBlendAttachmentState color_blend_attachment = {};
-    color_blend_attachment.colorWriteMask = info.color_write_mask;
-    color_blend_attachment.blendEnable    = info.blending;
-
-    VkPipelineColorBlendStateCreateInfo color_blend_info = {};
-    color_blend_info.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    color_blend_info.logicOpEnable = VK_FALSE;
-    color_blend_info.logicOp = VK_LOGIC_OP_COPY;
-    color_blend_info.attachmentCount = 1;
-    color_blend_info.pAttachments = &color_blend_attachment;
-    color_blend_info.blendConstants[0] = 0.0f;
-    color_blend_info.blendConstants[1] = 0.0f;
-    color_blend_info.blendConstants[2] = 0.0f;
-    color_blend_info.blendConstants[3] = 0.0f;
+void GraphicsPipeline::rebuild()
+{
+    ASSERT(m_Layout != VK_NULL_HANDLE, "[Vulkan] rebuild() called before build()");
+    const GraphicsPipelineInfo info = m_Info;
+    build(info);
+}
 
-    // Viewport state with dynamic viewport and scissor (no static values needed)
-    VkPipelineViewportStateCreateInfo viewport_create_info = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-        .viewportCount = 1,
-        .pViewports = nullptr,  // Will be set dynamically
-        .scissorCount = 1,
-        .pScissors = nullptr    // Will be set dynamically
-    };
+VkPipeline GraphicsPipeline::get_handle()
+{
+    // Swap in the link time optimized pipeline once the background link finished
+    if (m_OptimizedHandle.valid() && m_OptimizedHandle.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        const VkPipeline fast_linked = m_Handle;
+        m_Handle = m_OptimizedHandle.get();
+
+        VulkanContext::get()->defer_destroy([fast_linked]()
+        {
+            vkDestroyPipeline(VulkanContext::get()->get_device(), fast_linked, VK_NULL_HANDLE);
+        });
+    }
+
+    return m_Handle;
+}
 
-    // Dynamic states
-    VkDynamicState dynamic_states[] =
+u64 GraphicsPipeline::compute_stages_key(bool fragment) const
+{
+    u64 key = HASH_FNV_OFFSET_BASIS;
+    for (const auto &shader : m_Shaders)
     {
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_SCISSOR
-    };
+        if ((shader->get_stage_flag() == VK_SHADER_STAGE_FRAGMENT_BIT) != fragment)
+            continue;
 
-    VkPipelineDynamicStateCreateInfo dynamic_state_create_info = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
-        .dynamicStateCount = static_cast<uint32_t>(std::size(dynamic_states)),
-        .pDynamicStates = dynamic_states
-    };
+        // Content rather than the module handle, handles get recycled after hot reload
+        hash_combine(key, shader->get_spirv_hash());
+
+        const auto it = m_AcceptedSpecializations.find(shader->get_stage_flag());
+        hash_combine(key, it != m_AcceptedSpecializations.end() ? it->second.get_hash() : 0ull);
+    }
+    return key;
+}
+
+u64 GraphicsPipeline::compute_layout_key(const GraphicsPipelineInfo &info)
+{
+    u64 key = HASH_FNV_OFFSET_BASIS;
+    if (info.set_layout_bindings.empty() && info.push_constant_ranges.empty())
+    {
+        hash_combine(key, info.layout);
+        return key;
+    }
+
+    // Immutable samplers are not part of the key, layouts using them must stay alive with their parts
+    for (const auto &bindings : info.set_layout_bindings)
+    {
+        hash_combine(key, bindings.size());
+        for (const auto &binding : bindings)
+        {
+            hash_combine(key, binding.binding);
+            hash_combine(key, binding.descriptorType);
+            hash_combine(key, binding.descriptorCount);
+            hash_combine(key, binding.stageFlags);
+        }
+    }
+    for (const auto &range : info.push_constant_ranges)
+    {
+        hash_combine(key, range.stageFlags);
+        hash_combine(key, range.offset);
+        hash_combine(key, range.size);
+    }
+    return key;
+}
 
+u64 GraphicsPipeline::compute_render_pass_key(const GraphicsPipelineInfo &info)
+{
+    u64 key = HASH_FNV_OFFSET_BASIS;
+    if (info.attachment_formats.empty())
+    {
+        hash_combine(key, info.render_pass);
+        return key;
+    }
+
+    for (const VkFormat format : info.attachment_formats)
+        hash_combine(key, format);
+    return key;
+}
+
+u64 GraphicsPipeline::compute_part_key(PipelineLibraryPart part, const GraphicsPipelineInfo &info) const
+{
+    u64 key = HASH_FNV_OFFSET_BASIS;
+    hash_combine(key, part);
+
+    switch (part)
+    {
+    case PipelineLibraryPart::VertexInput:
+    {
+        for (const auto &binding : info.binding_descriptions)
+        {
+            hash_combine(key, binding.binding);
+            hash_combine(key, binding.stride);
+            hash_combine(key, binding.inputRate);
+        }
+        for (const auto &attr : info.attribute_descriptions)
+        {
+            hash_combine(key, attr.location);
+            hash_combine(key, attr.binding);
+            hash_combine(key, attr.format);
+            hash_combine(key, attr.offset);
+        }
+        hash_combine(key, info.topology);
+        break;
+    }
+    case PipelineLibraryPart::PreRasterization:
+    {
+        hash_combine(key, compute_stages_key(false));
+        hash_combine(key, compute_layout_key(info));
+        hash_combine(key, compute_render_pass_key(info));
+        hash_combine(key, info.polygon_mode);
+        hash_combine(key, info.cull_mode);
+        hash_combine(key, info.front_face);
+        hash_combine(key, info.line_width);
+        hash_combine(key, info.depth_bias);
+        break;
+    }
+    case PipelineLibraryPart::FragmentShader:
+    {
+        hash_combine(key, compute_stages_key(true));
+        hash_combine(key, compute_layout_key(info));
+        hash_combine(key, compute_render_pass_key(info));
+        hash_combine(key, info.depth_test);
+        hash_combine(key, info.depth_write);
+        hash_combine(key, info.depth_compare_op);
+        hash_combine(key, info.stencil_test);
+        break;
+    }
+    case PipelineLibraryPart::FragmentOutput:
+    {
+        hash_combine(key, compute_render_pass_key(info));
+        hash_combine(key, info.color_write_mask);
+        hash_combine(key, info.src_color_blend_factor);
+        hash_combine(key, info.dst_color_blend_factor);
+        hash_combine(key, info.color_blend_op);
+        hash_combine(key, info.src_alpha_blend_factor);
+        hash_combine(key, info.dst_alpha_blend_factor);
+        hash_combine(key, info.alpha_blend_op);
+        hash_combine(key, info.blending);
+        break;
+    }
+    default:
+        break;
+    }
+    return key;
+}
+
+void GraphicsPipeline::build(const GraphicsPipelineInfo& info)
+{
+    auto device = VulkanContext::get()->get_device();
+
+    // Rebuilding: the old pipeline may still be in flight
+    if (m_Handle != VK_NULL_HANDLE || m_OptimizedHandle.valid())
+    {
+        const VkPipeline old_handle = m_Handle;
+        std::shared_future<VkPipeline> old_optimized = m_OptimizedHandle.share();
+        m_Handle = VK_NULL_HANDLE;
+
+        VulkanContext::get()->defer_destroy([old_handle, old_optimized]()
+        {
+            const VkDevice device = VulkanContext::get()->get_device();
+            if (old_handle != VK_NULL_HANDLE)
+                vkDestroyPipeline(device, old_handle, VK_NULL_HANDLE);
+            if (old_optimized.valid())
+                vkDestroyPipeline(device, old_optimized.get(), VK_NULL_HANDLE);
+        });
+    }
+
+    // Store the pipeline layout
+    m_Layout = info.layout;
+    m_Info = info;
+
+    PipelineStates states;
+    fill_pipeline_states(info, states);
+
+    // Map entries whose size differs from the shader's declaration are invalid usage, they are
+    // dropped so the shader keeps its default. Only the accepted ones reach the pipeline and its part keys.
+    m_AcceptedSpecializations.clear();
     std::vector<VkPipelineShaderStageCreateInfo> shader_stages {};
     for (auto& shader : m_Shaders)
     {
-        shader_stages.push_back(shader->get_stage());
-    }
+        VkPipelineShaderStageCreateInfo stage = shader->get_stage();
 
-    VkPipelineInputAssemblyStateCreateInfo input_assembly_info = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-        .topology = info.topology,
-        .primitiveRestartEnable = VK_FALSE,
-    };
+        auto it = m_Specializations.find(stage.stage);
+        if (it != m_Specializations.end() && !it->second.empty())
+        {
+            SpecializationConstants accepted;
+            for (const auto &entry : it->second.get_entries())
+            {
+                const ShaderSpecializationConstant *declared = shader->find_specialization_constant(entry.constantID);
+                if (!declared)
+                {
+                    Logger::get_instance().push_message(LoggingLevel::Warning, "[Vulkan] Specialization constant {} is not declared by the shader", entry.constantID);
+                }
+                else if (declared->size != entry.size)
+                {
+                    Logger::get_instance().push_message(LoggingLevel::Error, "[Vulkan] Specialization constant {} '{}' expects {} bytes, got {}, keeping the default",
+                        entry.constantID, declared->name, declared->size, static_cast<u32>(entry.size));
+                    continue;
+                }
+                accepted.set_raw(entry.constantID, it->second.get_value(entry), static_cast<u32>(entry.size));
+            }
 
-    // Build vertex input state from stored data
-    VkPipelineVertexInputStateCreateInfo vertex_input_state = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-        .vertexBindingDescriptionCount = 1,
-        .pVertexBindingDescriptions = &info.binding_description,
-        .vertexAttributeDescriptionCount = static_cast<uint32_t>(info.attribute_descriptions.size()),
-        .pVertexAttributeDescriptions = info.attribute_descriptions.data()
-    };
+            if (!accepted.empty())
+            {
+                // Nodes of the map never move, the info stays valid while the pipeline is created
+                SpecializationConstants &stored = m_AcceptedSpecializations[stage.stage] = accepted;
+                stage.pSpecializationInfo = stored.get_info();
+            }
+        }
+
+        shader_stages.push_back(stage);
+    }
+
+    if (PipelineLibrary *library = VulkanContext::get()->get_pipeline_library())
+    {
+        build_from_library(library, info, states, shader_stages);
+        return;
+    }
 
     // Graphics pipeline creation info
     VkGraphicsPipelineCreateInfo pipeline_create_info = {
         .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
         .stageCount = static_cast<uint32_t>(shader_stages.size()),
         .pStages = shader_stages.data(),
-        .pVertexInputState = &vertex_input_state,
-        .pInputAssemblyState = &input_assembly_info,
-        .pViewportState = &viewport_create_info,
-        .pRasterizationState = &rasterization_info,
-        .pMultisampleState = &multisample_info,
-        .pColorBlendState = &color_blend_info,
-        .pDynamicState = &dynamic_state_create_info,
+        .pVertexInputState = &states.vertex_input,
+        .pInputAssemblyState = &states.input_assembly,
+        .pViewportState = &states.viewport,
+        .pRasterizationState = &states.rasterization,
+        .pMultisampleState = &states.multisample,
+        .pDepthStencilState = &states.depth_stencil,
+        .pColorBlendState = &states.color_blend,
+        .pDynamicState = &states.dynamic,
         .layout = info.layout,
         .renderPass = info.render_pass,
         .subpass = 0,
@@ -145,3 +410,81 @@ void GraphicsPipeline::build(const GraphicsPipelineInfo& info)
     VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipeline_create_info, VK_NULL_HANDLE, &m_Handle);
     VK_ERROR_CHECK(result,"[Vulkan] Failed to recreate graphics pipeline");
 }
+
+void GraphicsPipeline::build_from_library(PipelineLibrary *library, const GraphicsPipelineInfo &info, const PipelineStates &states,
+    const std::vector<VkPipelineShaderStageCreateInfo> &shader_stages)
+{
+    std::vector<VkPipelineShaderStageCreateInfo> pre_raster_stages;
+    std::vector<VkPipelineShaderStageCreateInfo> fragment_stages;
+    for (const auto &stage : shader_stages)
+    {
+        if (stage.stage == VK_SHADER_STAGE_FRAGMENT_BIT)
+            fragment_stages.push_back(stage);
+        else
+            pre_raster_stages.push_back(stage);
+    }
+
+    PipelineLibraryParts parts {};
+
+    VkGraphicsPipelineCreateInfo vertex_input_info = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pVertexInputState = &states.vertex_input,
+        .pInputAssemblyState = &states.input_assembly,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1
+    };
+    parts[0] = library->get_or_create_part(PipelineLibraryPart::VertexInput,
+        compute_part_key(PipelineLibraryPart::VertexInput, info), vertex_input_info);
+
+    VkGraphicsPipelineCreateInfo pre_raster_info = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .stageCount = static_cast<uint32_t>(pre_raster_stages.size()),
+        .pStages = pre_raster_stages.data(),
+        .pViewportState = &states.viewport,
+        .pRasterizationState = &states.rasterization,
+        .pDynamicState = &states.dynamic,
+        .layout = info.layout,
+        .renderPass = info.render_pass,
+        .subpass = 0,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1
+    };
+    parts[1] = library->get_or_create_part(PipelineLibraryPart::PreRasterization,
+        compute_part_key(PipelineLibraryPart::PreRasterization, info), pre_raster_info);
+
+    VkGraphicsPipelineCreateInfo fragment_shader_info = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .stageCount = static_cast<uint32_t>(fragment_stages.size()),
+        .pStages = fragment_stages.data(),
+        .pMultisampleState = &states.multisample,
+        .pDepthStencilState = &states.depth_stencil,
+        .layout = info.layout,
+        .renderPass = info.render_pass,
+        .subpass = 0,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1
+    };
+    parts[2] = library->get_or_create_part(PipelineLibraryPart::FragmentShader,
+        compute_part_key(PipelineLibraryPart::FragmentShader, info), fragment_shader_info);
+
+    VkGraphicsPipelineCreateInfo fragment_output_info = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pMultisampleState = &states.multisample,
+        .pColorBlendState = &states.color_blend,
+        .renderPass = info.render_pass,
+        .subpass = 0,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1
+    };
+    parts[3] = library->get_or_create_part(PipelineLibraryPart::FragmentOutput,
+        compute_part_key(PipelineLibraryPart::FragmentOutput, info), fragment_output_info);
+
+    // Fast link now so the pipeline is usable immediately, optimize on the engine's thread pool
+    m_Handle = PipelineLibrary::link(parts, info.layout, false);
+
+    const VkPipelineLayout layout = info.layout;
+    m_OptimizedHandle = ThreadPool::get_instance().submit([parts, layout]()
+    {
+        return PipelineLibrary::link(parts, layout, true);
+    });
+}
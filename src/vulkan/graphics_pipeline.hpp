@@ -4,20 +4,29 @@
 #define VULKAN_GRAPHICS_PIPELINE_HPP
 
 #include "shader.hpp"
+#include "pipeline_library.hpp"
 
 #include <vulkan/vulkan.h>
 #include <vector>
 #include <stdexcept>
+#include <unordered_map>
+#include <future>
 
 struct GraphicsPipelineInfo
 {
     // Store actual data, not pointers
-    VkVertexInputBindingDescription binding_description;
+    std::vector<VkVertexInputBindingDescription> binding_descriptions; // one per vertex or instance stream
     std::vector<VkVertexInputAttributeDescription> attribute_descriptions;
     VkPipelineLayout layout;
     VkExtent2D extent;
     VkRenderPass render_pass;
 
+    // What layout and render_pass were created from. Library parts are shared by content since
+    // handles get recycled once destroyed, parts of pipelines that leave these empty are keyed by handle.
+    std::vector<std::vector<VkDescriptorSetLayoutBinding>> set_layout_bindings; // in the order of the layout's sets
+    std::vector<VkPushConstantRange> push_constant_ranges;
+    std::vector<VkFormat> attachment_formats;
+
     VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     VkPolygonMode polygon_mode = VK_POLYGON_MODE_FILL;
     VkCullModeFlags cull_mode = VK_CULL_MODE_NONE;
@@ -38,6 +47,8 @@ struct GraphicsPipelineInfo
     bool stencil_test = false;
 };
 
+struct PipelineStates;
+
 class GraphicsPipeline
 {
 public:
@@ -45,17 +56,38 @@ public:
     ~GraphicsPipeline();
 
     GraphicsPipeline &add_shader(const Ref<Shader> &shader);
+    GraphicsPipeline &set_specialization_constants(VkShaderStageFlagBits stage, const SpecializationConstants &constants);
     void build(const GraphicsPipelineInfo &info);
 
+    // Swaps a shader module and rebuilds with the last build info. The previous
+    // pipeline is destroyed once the GPU is done with it.
+    void replace_shader(const Ref<Shader> &old_shader, const Ref<Shader> &new_shader);
+    void rebuild();
+    const std::vector<Ref<Shader>> &get_shaders() const { return m_Shaders; }
+
     void destroy();
 
-    VkPipeline get_handle() const { return m_Handle; }
+    // With graphics pipeline libraries this starts as a fast-linked pipeline
+    // and is replaced by the link time optimized one when it is ready
+    VkPipeline get_handle();
     VkPipelineLayout get_layout() const { return m_Layout; }
 
 private:
+    u64 compute_part_key(PipelineLibraryPart part, const GraphicsPipelineInfo &info) const;
+    u64 compute_stages_key(bool fragment) const;
+    static u64 compute_layout_key(const GraphicsPipelineInfo &info);
+    static u64 compute_render_pass_key(const GraphicsPipelineInfo &info);
+
+    void build_from_library(PipelineLibrary *library, const GraphicsPipelineInfo &info, const PipelineStates &states,
+        const std::vector<VkPipelineShaderStageCreateInfo> &shader_stages);
+
     VkPipeline m_Handle;
+    std::future<VkPipeline> m_OptimizedHandle;
     VkPipelineLayout m_Layout;
+    GraphicsPipelineInfo m_Info {};
     std::vector<Ref<Shader>> m_Shaders;
+    std::unordered_map<VkShaderStageFlagBits, SpecializationConstants> m_Specializations;
+    std::unordered_map<VkShaderStageFlagBits, SpecializationConstants> m_AcceptedSpecializations; // by the last build
 };
 
 struct DrawArguments
@@ -67,15 +99,20 @@ struct DrawArguments
     int32_t vertex_offset = 0;
 };
 
+struct RenderPassState
+{
+    VkRenderPass render_pass = VK_NULL_HANDLE;
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    VkRect2D render_area;
+    VkClearValue clear_value;
+};
+
 struct GraphicsState
 {
     VkPipeline pipeline = VK_NULL_HANDLE;
     VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
-    VkFramebuffer framebuffer = VK_NULL_HANDLE;
-    VkRenderPass render_pass = VK_NULL_HANDLE;
     VkViewport viewport;
     VkRect2D scissor;
-    VkClearValue clear_value;
 
     struct
     {
@@ -85,7 +122,8 @@ struct GraphicsState
     } index_buffer;
 
     std::vector<VkDescriptorSet> descriptor_sets;
-    std::vector<VkBuffer> vertex_buffers;
+    std::vector<VkBuffer> vertex_buffers; // vertex_buffers[i] feeds binding i
+    std::vector<VkDeviceSize> vertex_offsets; // per buffer, empty binds every buffer from 0
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,141 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "parallel_command_recorder.hpp"
+#include "vulkan_context.hpp"
+#include "vulkan_wrapper.hpp"
+
+#include "core/thread_pool.hpp"
+
+#include <algorithm>
+#include <future>
+
+ParallelCommandRecorder::ParallelCommandRecorder(ThreadPool *thread_pool)
+    : m_ThreadPool(thread_pool ? thread_pool : &ThreadPool::get_instance())
+{
+    const auto device = VulkanContext::get()->get_device();
+    const u32 queue_family = VulkanContext::get()->get_queue_family();
+    const u32 image_count = VulkanContext::get()->get_swap_chain()->get_image_count();
+
+    m_Slots.resize(std::max(1u, m_ThreadPool->get_thread_count()));
+    for (Slot &slot : m_Slots)
+    {
+        slot.frame_pools.resize(image_count);
+        slot.used.assign(image_count, 0);
+        for (VkCommandPool &pool : slot.frame_pools)
+        {
+            // Buffers are re-recorded every frame and only ever reset together with their pool
+            VkCommandPoolCreateInfo pool_create_info = {};
+            pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            pool_create_info.queueFamilyIndex = queue_family;
+
+            VK_ERROR_CHECK(vkCreateCommandPool(device, &pool_create_info, VK_NULL_HANDLE, &pool),
+                "[Vulkan] Failed to create thread command pool");
+        }
+    }
+
+    Logger::get_instance().push_message(LoggingLevel::Info, "[Vulkan] Parallel command recorder with {} slots", m_Slots.size());
+}
+
+ParallelCommandRecorder::~ParallelCommandRecorder()
+{
+    ASSERT(m_Slots.empty(), "Forget to call destroy()");
+}
+
+void ParallelCommandRecorder::begin_frame()
+{
+    // begin_frame waited for the previous submission of this frame, nothing in these pools is pending
+    const auto device = VulkanContext::get()->get_device();
+    const u32 frame = VulkanContext::get()->get_current_image_index();
+    for (Slot &slot : m_Slots)
+    {
+        VkResult result = vkResetCommandPool(device, slot.frame_pools[frame], 0);
+        VK_ERROR_CHECK(result, "[Vulkan] Failed to reset thread command pool");
+        slot.used[frame] = 0;
+    }
+    m_FrameStats = {};
+}
+
+CommandBuffer &ParallelCommandRecorder::acquire(Slot &slot, u32 frame)
+{
+    const u32 index = slot.used[frame]++;
+    if (index == slot.command_buffers.size())
+    {
+        slot.command_buffers.push_back(CreateScope<CommandBuffer>(slot.frame_pools, VK_COMMAND_BUFFER_LEVEL_SECONDARY));
+    }
+    return *slot.command_buffers[index];
+}
+
+void ParallelCommandRecorder::record(CommandBuffer &primary, const RenderPassState &pass, u32 count, const RecordFunc &func, u32 min_chunk_size)
+{
+    if (count == 0)
+        return;
+
+    const u32 frame = VulkanContext::get()->get_current_image_index();
+    const u32 chunk_count = std::max(1u, std::min(get_slot_count(), count / std::max(1u, min_chunk_size)));
+    const u32 chunk_size = (count + chunk_count - 1) / chunk_count;
+
+    // Handed out on this thread, so workers never touch the slot bookkeeping
+    std::vector<CommandBuffer *> chunks;
+    std::vector<VkCommandBuffer> handles;
+    for (u32 begin = 0; begin < count; begin += chunk_size)
+    {
+        CommandBuffer &command_buffer = acquire(m_Slots[chunks.size()], frame);
+        chunks.push_back(&command_buffer);
+        handles.push_back(command_buffer.get_active_handle());
+    }
+
+    const VkCommandBufferInheritanceInfo inheritance = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .pNext = VK_NULL_HANDLE,
+        .renderPass = pass.render_pass,
+        .subpass = 0,
+        .framebuffer = pass.framebuffer,
+    };
+
+    auto record_chunk = [&](u32 chunk)
+    {
+        const u32 begin = chunk * chunk_size;
+        const u32 end = std::min(count, begin + chunk_size);
+        CommandBuffer &command_buffer = *chunks[chunk];
+        command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &inheritance);
+        func(command_buffer, begin, end);
+        command_buffer.end();
+    };
+
+    if (chunks.size() == 1)
+    {
+        record_chunk(0);
+    }
+    else
+    {
+        std::vector<std::future<void>> futures;
+        futures.reserve(chunks.size());
+        for (u32 chunk = 0; chunk < chunks.size(); ++chunk)
+            futures.push_back(m_ThreadPool->submit([&record_chunk, chunk]() { record_chunk(chunk); }));
+
+        // Wait for every chunk before rethrowing, record_chunk is captured by reference
+        for (auto &future : futures)
+            future.wait();
+        for (auto &future : futures)
+            future.get();
+    }
+
+    for (const CommandBuffer *command_buffer : chunks)
+        m_FrameStats += command_buffer->get_stats();
+
+    primary.execute_commands(handles);
+}
+
+void ParallelCommandRecorder::destroy()
+{
+    const auto device = VulkanContext::get()->get_device();
+    for (Slot &slot : m_Slots)
+    {
+        for (auto &command_buffer : slot.command_buffers)
+            command_buffer->destroy();
+        for (VkCommandPool pool : slot.frame_pools)
+            vkDestroyCommandPool(device, pool, VK_NULL_HANDLE);
+    }
+    m_Slots.clear();
+}
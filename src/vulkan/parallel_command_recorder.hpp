@@ -0,0 +1,56 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#ifndef VULKAN_PARALLEL_COMMAND_RECORDER_HPP
+#define VULKAN_PARALLEL_COMMAND_RECORDER_HPP
+
+#include "command_buffer.hpp"
+
+#include "core/types.hpp"
+
+#include <functional>
+
+class ThreadPool;
+
+// Splits the draws of a render pass across worker threads. Each worker records its
+// contiguous range into a secondary command buffer, the primary executes them in order,
+// so the result is the same as recording everything on one thread.
+// Command pools are externally synchronized, every slot owns one pool per frame and only
+// one task uses a slot at a time. Pools are reset as a whole in begin_frame().
+class ParallelCommandRecorder
+{
+public:
+    using RecordFunc = std::function<void(CommandBuffer &command_buffer, u32 begin, u32 end)>;
+
+    explicit ParallelCommandRecorder(ThreadPool *thread_pool = nullptr);
+    ~ParallelCommandRecorder();
+
+    // Call after VulkanContext::begin_frame, before recording the frame
+    void begin_frame();
+
+    // Records func over [0, count) into secondary buffers and executes them into primary.
+    // primary has to be inside pass, begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+    // A single chunk is recorded on the calling thread.
+    void record(CommandBuffer &primary, const RenderPassState &pass, u32 count, const RecordFunc &func, u32 min_chunk_size = 1);
+
+    void destroy();
+
+    u32 get_slot_count() const { return static_cast<u32>(m_Slots.size()); }
+    // Bind statistics of every secondary buffer recorded since begin_frame()
+    const CommandBufferStats &get_frame_stats() const { return m_FrameStats; }
+
+private:
+    struct Slot
+    {
+        std::vector<VkCommandPool> frame_pools;
+        std::vector<Scope<CommandBuffer>> command_buffers; // reused every frame
+        std::vector<u32> used; // command buffers handed out in each frame
+    };
+
+    CommandBuffer &acquire(Slot &slot, u32 frame);
+
+    ThreadPool *m_ThreadPool;
+    std::vector<Slot> m_Slots;
+    CommandBufferStats m_FrameStats;
+};
+
+#endif //VULKAN_PARALLEL_COMMAND_RECORDER_HPP
@@ -5,6 +5,7 @@
 #include "core/assert.hpp"
 
 #include <cstdio>
+#include <cstring>
 #include <vulkan/vulkan.h>
 
 VulkanPhysicalDevice::VulkanPhysicalDevice(VkInstance instance, VkSurfaceKHR surface)
@@ -78,6 +79,12 @@ VulkanPhysicalDevice::VulkanPhysicalDevice(VkInstance instance, VkSurfaceKHR sur
         // get memory properties and features
         vkGetPhysicalDeviceMemoryProperties(physical_device, &current_device.memory_properties);
         vkGetPhysicalDeviceFeatures(current_device.device, &current_device.features);
+
+        // get device extensions
+        u32 extension_count = 0;
+        vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, nullptr);
+        current_device.extensions.resize(extension_count);
+        vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, current_device.extensions.data());
     }
 }
 
@@ -116,6 +123,17 @@ PhysicalDevice VulkanPhysicalDevice::get_selected_device() const
     return m_Devices[m_DeviceIndex];
 }
 
+bool VulkanPhysicalDevice::is_extension_supported(const char *extension_name) const
+{
+    ASSERT(m_DeviceIndex >= 0, "[Vulkan] A physical device has not been selected");
+    for (const auto &extension : m_Devices[m_DeviceIndex].extensions)
+    {
+        if (std::strcmp(extension.extensionName, extension_name) == 0)
+            return true;
+    }
+    return false;
+}
+
 VkSurfaceFormats VulkanPhysicalDevice::get_surface_format(VkPhysicalDevice physical_device, VkSurfaceKHR surface)
 {
     u32 format_count = 0;
@@ -18,6 +18,7 @@ struct PhysicalDevice
     VkSurfaceCapabilitiesKHR surface_capabilities;
     VkPhysicalDeviceMemoryProperties memory_properties;
     VkPhysicalDeviceFeatures features;
+    std::vector<VkExtensionProperties> extensions;
 };
 
 using VkSurfaceFormats = std::vector<VkSurfaceFormatKHR>;
@@ -31,6 +32,7 @@ public:
     u32 select_device(VkQueueFlags required_queue_flags, bool support_present);
 
     PhysicalDevice get_selected_device() const;
+    bool is_extension_supported(const char *extension_name) const;
 
     static VkSurfaceCapabilitiesKHR get_surface_capabilities(VkPhysicalDevice physical_device, VkSurfaceKHR surface);
     static VkSurfaceFormats get_surface_format(VkPhysicalDevice physical_device, VkSurfaceKHR surface);
@@ -0,0 +1,99 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "pipeline_library.hpp"
+#include "vulkan_context.hpp"
+#include "vulkan_wrapper.hpp"
+
+static VkGraphicsPipelineLibraryFlagsEXT get_library_flags(const PipelineLibraryPart part)
+{
+    switch (part)
+    {
+    case PipelineLibraryPart::VertexInput: return VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+    case PipelineLibraryPart::PreRasterization: return VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+    case PipelineLibraryPart::FragmentShader: return VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+    case PipelineLibraryPart::FragmentOutput: return VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+    default: return 0;
+    }
+}
+
+void PipelineLibrary::destroy()
+{
+    const VkDevice device = VulkanContext::get()->get_device();
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (auto &parts : m_Parts)
+    {
+        for (auto &[key, pipeline] : parts)
+        {
+            vkDestroyPipeline(device, pipeline, VK_NULL_HANDLE);
+        }
+        parts.clear();
+    }
+}
+
+VkPipeline PipelineLibrary::get_or_create_part(PipelineLibraryPart part, u64 key, VkGraphicsPipelineCreateInfo create_info)
+{
+    auto &parts = m_Parts[static_cast<size_t>(part)];
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = parts.find(key);
+        if (it != parts.end())
+            return it->second;
+    }
+
+    VkGraphicsPipelineLibraryCreateInfoEXT library_info = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+        .pNext = create_info.pNext,
+        .flags = get_library_flags(part),
+    };
+
+    create_info.pNext = &library_info;
+    create_info.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+
+    const VkDevice device = VulkanContext::get()->get_device();
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &create_info, VK_NULL_HANDLE, &pipeline);
+    VK_ERROR_CHECK(result, "[Vulkan] Failed to create graphics pipeline library part");
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto [it, inserted] = parts.emplace(key, pipeline);
+    if (!inserted)
+    {
+        // Another thread created the same part meanwhile
+        vkDestroyPipeline(device, pipeline, VK_NULL_HANDLE);
+    }
+    return it->second;
+}
+
+VkPipeline PipelineLibrary::link(const PipelineLibraryParts &parts, VkPipelineLayout layout, bool optimize)
+{
+    VkPipelineLibraryCreateInfoKHR library_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+        .libraryCount = static_cast<u32>(parts.size()),
+        .pLibraries = parts.data(),
+    };
+
+    VkGraphicsPipelineCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = &library_info,
+        .flags = optimize ? static_cast<VkPipelineCreateFlags>(VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT) : 0u,
+        .layout = layout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1
+    };
+
+    const VkDevice device = VulkanContext::get()->get_device();
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &create_info, VK_NULL_HANDLE, &pipeline);
+    VK_ERROR_CHECK(result, "[Vulkan] Failed to link graphics pipeline library");
+    return pipeline;
+}
+
+size_t PipelineLibrary::get_part_count() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    size_t count = 0;
+    for (const auto &parts : m_Parts)
+        count += parts.size();
+    return count;
+}
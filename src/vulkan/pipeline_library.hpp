@@ -0,0 +1,50 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#ifndef VULKAN_PIPELINE_LIBRARY_HPP
+#define VULKAN_PIPELINE_LIBRARY_HPP
+
+#include "core/types.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+// VK_EXT_graphics_pipeline_library parts, in the order they are linked
+enum class PipelineLibraryPart : u32
+{
+    VertexInput = 0,
+    PreRasterization,
+    FragmentShader,
+    FragmentOutput,
+    Count
+};
+
+using PipelineLibraryParts = std::array<VkPipeline, static_cast<size_t>(PipelineLibraryPart::Count)>;
+
+// Caches the individually compiled parts of graphics pipelines so that
+// new state combinations only need a (fast) link instead of a full compile.
+class PipelineLibrary
+{
+public:
+    PipelineLibrary() = default;
+
+    void destroy();
+
+    // Returns the cached part for the key, or creates it with the given create info.
+    // The create info must describe only the state belonging to the part.
+    VkPipeline get_or_create_part(PipelineLibraryPart part, u64 key, VkGraphicsPipelineCreateInfo create_info);
+
+    // Links previously created parts into an executable pipeline
+    static VkPipeline link(const PipelineLibraryParts &parts, VkPipelineLayout layout, bool optimize);
+
+    size_t get_part_count() const;
+
+private:
+    mutable std::mutex m_Mutex;
+    std::array<std::unordered_map<u64, VkPipeline>, static_cast<size_t>(PipelineLibraryPart::Count)> m_Parts;
+};
+
+#endif //VULKAN_PIPELINE_LIBRARY_HPP
@@ -4,279 +4,195 @@
 #include "core/logger.hpp"
 
 #include "shader.hpp"
+#include "shader_archive.hpp"
 #include "vulkan_context.hpp"
 
 #include "vulkan_wrapper.hpp"
 
-#include <fstream>
+#include "core/thread_pool.hpp"
 
-static const char *get_cached_directory()
-{
-    return "res/cache/shaders";
-}
+#ifdef SHADER_RUNTIME_COMPILER
+    #include "shader_compiler.hpp"
+#endif
 
-static void create_cached_directory_if_needed()
+#include <algorithm>
+#include <cstring>
+#include <format>
+
+SpecializationConstants &SpecializationConstants::set_raw(u32 constant_id, const void *data, u32 size)
 {
-    const std::string cached_directory = get_cached_directory();
-    if (!std::filesystem::exists(cached_directory))
+    for (auto &entry : m_Entries)
     {
-        std::filesystem::create_directories(cached_directory);
+        if (entry.constantID == constant_id)
+        {
+            ASSERT(entry.size == size, "[Shader] Specialization constant size mismatch");
+            std::memcpy(m_Data.data() + entry.offset, data, size);
+            return *this;
+        }
     }
+
+    VkSpecializationMapEntry entry = {};
+    entry.constantID = constant_id;
+    entry.offset = static_cast<u32>(m_Data.size());
+    entry.size = size;
+    m_Entries.push_back(entry);
+
+    m_Data.resize(m_Data.size() + size);
+    std::memcpy(m_Data.data() + entry.offset, data, size);
+    return *this;
 }
 
-static shaderc_shader_kind vulkan_shader_to_shaderc_kind(const VkShaderStageFlagBits stage)
+const VkSpecializationInfo *SpecializationConstants::get_info()
 {
-    switch (stage)
-    {
-    case VK_SHADER_STAGE_VERTEX_BIT: return shaderc_glsl_vertex_shader;
-    case VK_SHADER_STAGE_FRAGMENT_BIT: return shaderc_glsl_fragment_shader;
-    case VK_SHADER_STAGE_GEOMETRY_BIT: return shaderc_glsl_geometry_shader;
-    case VK_SHADER_STAGE_COMPUTE_BIT: return shaderc_glsl_compute_shader;
-    default: return static_cast<shaderc_shader_kind>(0);
-    }
+    if (m_Entries.empty())
+        return VK_NULL_HANDLE;
+
+    m_Info.mapEntryCount = static_cast<u32>(m_Entries.size());
+    m_Info.pMapEntries = m_Entries.data();
+    m_Info.dataSize = m_Data.size();
+    m_Info.pData = m_Data.data();
+    return &m_Info;
 }
 
-static std::string vulkan_shader_stage_str(const VkShaderStageFlagBits stage)
+u64 SpecializationConstants::get_hash() const
 {
-    switch (stage)
+    // Order independent of insertion so equal sets produce equal keys
+    std::vector<VkSpecializationMapEntry> sorted = m_Entries;
+    std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) { return a.constantID < b.constantID; });
+
+    u64 hash = HASH_FNV_OFFSET_BASIS;
+    for (const auto &entry : sorted)
     {
-    case VK_SHADER_STAGE_VERTEX_BIT: return "Vertex";
-    case VK_SHADER_STAGE_FRAGMENT_BIT: return "Fragment";
-    case VK_SHADER_STAGE_COMPUTE_BIT: return "Compute";
-    case VK_SHADER_STAGE_GEOMETRY_BIT: return "Geometry";
-    case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT: return "Tessellation";
-    default: return "Invalid";
+        hash_combine(hash, entry.constantID);
+        hash = hash_bytes(m_Data.data() + entry.offset, entry.size, hash);
     }
+    return hash;
+}
+
+static VkPipelineShaderStageCreateInfo make_stage_create_info(VkShaderStageFlagBits stage)
+{
+    VkPipelineShaderStageCreateInfo stage_create_info = {};
+    stage_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stage_create_info.stage = stage;
+    stage_create_info.module = VK_NULL_HANDLE;
+    stage_create_info.pName = "main";
+    stage_create_info.pSpecializationInfo = VK_NULL_HANDLE;
+    stage_create_info.pNext = VK_NULL_HANDLE;
+    return stage_create_info;
 }
 
-static std::string vulkan_shader_stage_extension(const VkShaderStageFlagBits stage)
+Shader::Shader(const std::filesystem::path& filepath, VkShaderStageFlagBits stage, const std::vector<ShaderMacro> &macros)
+    : m_Filepath(filepath), m_Macros(macros)
 {
-    switch (stage)
+    m_StageCreateInfo = make_stage_create_info(stage);
+
+#ifdef SHADER_RUNTIME_COMPILER
+    ShaderCompileResult compiled = ShaderCompiler::compile(filepath, stage, m_Macros);
+    m_Dependencies = std::move(compiled.dependencies);
+    if (compiled.code.empty())
     {
-    case VK_SHADER_STAGE_VERTEX_BIT: return ".vert.spv";
-    case VK_SHADER_STAGE_FRAGMENT_BIT: return ".frag.spv";
-    case VK_SHADER_STAGE_COMPUTE_BIT: return ".comp.spv";
-    case VK_SHADER_STAGE_GEOMETRY_BIT: return ".geom.spv";
-    case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT: return ".tes.spv";
-    default: return "Invalid";
+        // Leave the shader invalid, hot reload keeps using the previous version
+        Logger::get_instance().push_message(LoggingLevel::Error, "[Shader] No SPIR-V for {}", filepath.string());
+        return;
     }
+
+    m_SpirvHash = compiled.spirv_hash;
+    m_Reflection = std::move(compiled.reflection);
+    create_module(compiled.code.data(), compiled.code.size() * sizeof(u32));
+#else
+    Logger::get_instance().push_message(LoggingLevel::Error, "[Shader] {} is not in a shader archive and the runtime compiler is disabled",
+        filepath.string());
+#endif
 }
 
-Shader::Shader(const std::filesystem::path& filepath, VkShaderStageFlagBits stage)
+Shader::Shader(const ShaderArchive &archive, const ShaderArchiveEntry &entry)
 {
-    if (!std::filesystem::exists(filepath))
+    m_StageCreateInfo = make_stage_create_info(static_cast<VkShaderStageFlagBits>(entry.stage));
+
+    ShaderArchiveMetadata metadata;
+    if (!archive.read_metadata(entry, metadata))
     {
-        ASSERT(false, "[Shader] Shader is not exists");
+        Logger::get_instance().push_message(LoggingLevel::Error, "[Shader] Corrupt archive entry {}", std::format("{:016x}", entry.key));
+        return;
     }
 
-    create_cached_directory_if_needed();
-    const std::string shader_source = read_file(filepath);
+    m_Filepath = std::move(metadata.filepath);
+    m_Macros = std::move(metadata.macros);
+    m_Dependencies = std::move(metadata.dependencies);
+    m_Reflection = std::move(metadata.reflection);
+    m_SpirvHash = entry.spirv_hash;
 
-    std::vector<uint32_t> byte_code = compile_or_get_vulkan_binaries(shader_source, filepath.string().c_str(), stage);
-
-    // Reflect to gather info for pipeline creation
-    reflect(stage, byte_code);
+    // The module is created straight from the mapping, the SPIR-V is never copied
+    create_module(archive.get_spirv(entry), entry.spirv_size);
+}
 
+void Shader::create_module(const u32 *code, size_t size)
+{
     const VkDevice device = VulkanContext::get()->get_device();
     VkShaderModuleCreateInfo create_info = {};
     create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    create_info.codeSize = byte_code.size() * sizeof(u32);
-    create_info.pCode = byte_code.data();
+    create_info.codeSize = size;
+    create_info.pCode = code;
 
     VK_ERROR_CHECK(vkCreateShaderModule(device, &create_info, VK_NULL_HANDLE, &m_Module), "[Shader] Could not create shader module");
-
-    m_StageCreateInfo = {};
-    m_StageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    m_StageCreateInfo.stage = stage;
     m_StageCreateInfo.module = m_Module;
-    m_StageCreateInfo.pName = "main";
-    m_StageCreateInfo.pSpecializationInfo = VK_NULL_HANDLE;
-    m_StageCreateInfo.pNext = VK_NULL_HANDLE;
 }
 
-Shader::~Shader()
+std::vector<Ref<Shader>> Shader::create_batch(const std::vector<ShaderDesc> &descs, ThreadPool *thread_pool, const ShaderArchive *archive)
 {
-    const VkDevice device = VulkanContext::get()->get_device();
-    vkDestroyShaderModule(device, m_Module, VK_NULL_HANDLE);
+    ThreadPool &pool = thread_pool ? *thread_pool : ThreadPool::get_instance();
 
-    m_Module = VK_NULL_HANDLE;
-}
-
-std::string Shader::read_file(const std::filesystem::path& file_path)
-{
-    std::string result;
-    std::ifstream shader_in(file_path.string(), std::ios::binary);
-    if (shader_in.is_open())
+    std::vector<Ref<Shader>> shaders(descs.size());
+    std::vector<std::future<Ref<Shader>>> futures(descs.size());
+    for (size_t i = 0; i < descs.size(); ++i)
     {
-        shader_in.seekg(0, std::ios::end);
-        if (size_t size = shader_in.tellg(); size != -1)
-        {
-            result.resize(size);
-            shader_in.seekg(0, std::ios::beg);
-            shader_in.read(&result[0], size);
-        }
-        else
+        const ShaderDesc &desc = descs[i];
+
+        // Cooked shaders only need their module created, that is not worth a task
+        const ShaderArchiveEntry *entry = archive ? archive->find(desc.filepath, desc.stage, desc.macros) : nullptr;
+        if (entry)
         {
-            Logger::get_instance().push_message(LoggingLevel::Error, "[Shader] Could not read from file. {}", file_path.string());
+            shaders[i] = CreateRef<Shader>(*archive, *entry);
+            continue;
         }
 
-        shader_in.close();
+        futures[i] = pool.submit([desc]()
+        {
+            return CreateRef<Shader>(desc.filepath, desc.stage, desc.macros);
+        });
     }
-    else
+
+    for (size_t i = 0; i < descs.size(); ++i)
     {
-        Logger::get_instance().push_message(LoggingLevel::Error, "[Shader] Could not open file. {}", file_path.string());
+        if (futures[i].valid())
+            shaders[i] = futures[i].get();
     }
-    return result;
+    return shaders;
 }
 
-std::vector<u32> Shader::compile_or_get_vulkan_binaries(const std::string& shader_source, const std::string& file_path, VkShaderStageFlagBits stage)
+Shader::~Shader()
 {
-    std::vector<u32> code;
-    shaderc::CompileOptions options;
-
-    std::filesystem::path cached_directory = get_cached_directory();
-
-    options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_3);
-    options.SetOptimizationLevel(shaderc_optimization_level_performance);
-
-    std::filesystem::path shader_file_path = cached_directory / file_path;
-    std::filesystem::path cached_path = cached_directory / (shader_file_path.stem().string() + vulkan_shader_stage_extension(stage));
-    std::ifstream shader_file(cached_path, std::ios::binary);
-    if (shader_file.is_open())
+    if (m_Module != VK_NULL_HANDLE)
     {
-        shader_file.seekg(0, std::ios::end);
-        auto size = shader_file.tellg();
-        shader_file.seekg(0, std::ios::beg);
-        auto &data = code;
-        data.resize(size / sizeof(u32));
-        shader_file.read(reinterpret_cast<char*>(data.data()), size);
-
-        shader_file.close();
+        const VkDevice device = VulkanContext::get()->get_device();
+        vkDestroyShaderModule(device, m_Module, VK_NULL_HANDLE);
     }
-    else
-    {
-        shaderc::Compiler compiler;
-        shaderc::SpvCompilationResult module = compiler.CompileGlslToSpv(shader_source, vulkan_shader_to_shaderc_kind(stage), file_path.c_str());
-        bool success = module.GetCompilationStatus() == shaderc_compilation_status_success;
-        std::string error_message = module.GetErrorMessage();
-        ASSERT(success, std::format("[Shader] Compilation failed {}", error_message));
-
-        code = std::vector<u32>(module.cbegin(), module.cend());
 
-        std::ofstream out_file(cached_path, std::ios::binary);
-        if (out_file.is_open())
-        {
-            auto &data = code;
-            out_file.write(reinterpret_cast<char *>(data.data()), data.size() * sizeof(u32));
-            out_file.flush();
-            out_file.close();
-        }
-    }
-    
-    return code;
+    m_Module = VK_NULL_HANDLE;
 }
 
-void Shader::reflect(const VkShaderStageFlagBits shader_stage, const std::vector<u32>& code)
+const ShaderSpecializationConstant *Shader::find_specialization_constant(u32 constant_id) const
 {
-    spirv_cross::Compiler compiler(code);
-    spirv_cross::ShaderResources resources = compiler.get_shader_resources();
-
-    Logger::get_instance().push_message(LoggingLevel::Info, "[Shader] Shader reflect - {}", vulkan_shader_stage_str(shader_stage));
-    Logger::get_instance().push_message(LoggingLevel::Info, "[Shader]    {} Uniform buffers", resources.uniform_buffers.size());
-    Logger::get_instance().push_message(LoggingLevel::Info, "[Shader]    {} Resources", resources.sampled_images.size());
-
-    // Descriptor sets: Uniform buffers
-    for (const auto& uniform_buffer : resources.uniform_buffers)
-    {
-        const auto &buffer_type = compiler.get_type(uniform_buffer.base_type_id);
-        (void)buffer_type; // size can be used by user later
-        u32 binding = compiler.get_decoration(uniform_buffer.id, spv::DecorationBinding);
-        u32 set     = compiler.get_decoration(uniform_buffer.id, spv::DecorationDescriptorSet);
-        VkDescriptorSetLayoutBinding b {};
-        b.binding = binding;
-        b.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        b.descriptorCount = 1;
-        b.stageFlags = shader_stage;
-        b.pImmutableSamplers = nullptr;
-        m_SetBindings[set].push_back(b);
-    }
-
-    // Descriptor sets: Sampled images / combined image samplers
-    for (const auto& si : resources.sampled_images)
+    for (const auto &constant : m_Reflection.specialization_constants)
     {
-        u32 binding = compiler.get_decoration(si.id, spv::DecorationBinding);
-        u32 set     = compiler.get_decoration(si.id, spv::DecorationDescriptorSet);
-        VkDescriptorSetLayoutBinding b {};
-        b.binding = binding;
-        b.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        b.descriptorCount = 1;
-        b.stageFlags = shader_stage;
-        b.pImmutableSamplers = nullptr;
-        m_SetBindings[set].push_back(b);
+        if (constant.constant_id == constant_id)
+            return &constant;
     }
+    return nullptr;
+}
 
-    // Descriptor sets: Storage buffers
-    for (const auto& sb : resources.storage_buffers)
-    {
-        u32 binding = compiler.get_decoration(sb.id, spv::DecorationBinding);
-        u32 set     = compiler.get_decoration(sb.id, spv::DecorationDescriptorSet);
-        VkDescriptorSetLayoutBinding b {};
-        b.binding = binding;
-        b.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        b.descriptorCount = 1;
-        b.stageFlags = shader_stage;
-        b.pImmutableSamplers = nullptr;
-        m_SetBindings[set].push_back(b);
-    }
-
-    // Push constants
-    for (const auto& pc : resources.push_constant_buffers)
-    {
-        const auto &pc_type = compiler.get_type(pc.base_type_id);
-        u32 size = compiler.get_declared_struct_size(pc_type);
-        VkPushConstantRange range {};
-        range.stageFlags = shader_stage;
-        range.offset = 0;
-        range.size = size;
-        m_PushConstantRanges.push_back(range);
-    }
-
-    // Vertex inputs (only for vertex stage)
-    if (shader_stage == VK_SHADER_STAGE_VERTEX_BIT)
-    {
-        m_VertexAttributes.clear();
-        m_VertexStride = 0;
-        // Sort inputs by location to compute offsets consistently
-        struct InAttr { u32 loc; spirv_cross::ID id; };
-        std::vector<InAttr> inputs;
-        inputs.reserve(resources.stage_inputs.size());
-        for (const auto& in : resources.stage_inputs)
-        {
-            u32 loc = compiler.get_decoration(in.id, spv::DecorationLocation);
-            inputs.push_back({loc, in.id});
-        }
-        std::sort(inputs.begin(), inputs.end(), [](const InAttr& a, const InAttr& b){ return a.loc < b.loc; });
-
-        u32 offset = 0;
-        for (const auto& it : inputs)
-        {
-            const auto &type = compiler.get_type(compiler.get_type_from_variable(it.id).self);
-            VkFormat fmt = map_spirv_type_to_vk_format(type);
-            if (fmt == VK_FORMAT_UNDEFINED)
-                continue; // skip unsupported types
-            VkVertexInputAttributeDescription attr {};
-            attr.location = it.loc;
-            attr.binding = 0;
-            attr.format = fmt;
-            attr.offset = offset;
-
-            // size in bytes for simple float/int/uint vectors
-            u32 comp_size = 4; // 32-bit
-            u32 elem_count = std::max(1u, type.vecsize);
-            u32 attr_size = comp_size * elem_count;
-            offset += attr_size;
-            m_VertexAttributes.push_back(attr);
-        }
-        m_VertexStride = offset;
-    }
+bool Shader::depends_on(const std::filesystem::path &path) const
+{
+    const std::filesystem::path normalized = path.lexically_normal();
+    return std::find(m_Dependencies.begin(), m_Dependencies.end(), normalized) != m_Dependencies.end();
 }
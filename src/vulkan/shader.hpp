@@ -4,90 +4,144 @@
 #define VULKAN_SHADER_HPP
 
 #include "core/types.hpp"
+#include "core/hash.hpp"
+
+#include "shader_reflection.hpp"
 
 #include <filesystem>
 #include <vector>
 #include <string>
 #include <unordered_map>
-
-#include <spirv_cross/spirv_cross.hpp>
-#include <spirv_cross/spirv_glsl.hpp>
-#include <shaderc/shaderc.hpp>
+#include <type_traits>
+#include <array>
+#include <algorithm>
 
 #include <vulkan/vulkan.h>
 
-static VkFormat map_spirv_type_to_vk_format(const spirv_cross::SPIRType& type)
+// Values for `layout(constant_id = N) const` declarations, supplied per pipeline
+class SpecializationConstants
 {
-    using spirv_cross::SPIRType;
-    if (type.basetype == SPIRType::Float && type.columns == 1)
-    {
-        switch (type.vecsize)
-        {
-        case 1: return VK_FORMAT_R32_SFLOAT;
-        case 2: return VK_FORMAT_R32G32_SFLOAT;
-        case 3: return VK_FORMAT_R32G32B32_SFLOAT;
-        case 4: return VK_FORMAT_R32G32B32A32_SFLOAT;
-        default: break;
-        }
-    }
-    if (type.basetype == SPIRType::Int && type.columns == 1)
+public:
+    template<typename T>
+    SpecializationConstants &set(u32 constant_id, const T &value)
     {
-        switch (type.vecsize)
+        static_assert(std::is_arithmetic_v<T>, "Specialization constants must be scalar");
+        if constexpr (std::is_same_v<T, bool>)
         {
-        case 1: return VK_FORMAT_R32_SINT;
-        case 2: return VK_FORMAT_R32G32_SINT;
-        case 3: return VK_FORMAT_R32G32B32_SINT;
-        case 4: return VK_FORMAT_R32G32B32A32_SINT;
-        default: break;
+            const VkBool32 b = value ? VK_TRUE : VK_FALSE;
+            return set_raw(constant_id, &b, sizeof(VkBool32));
         }
-    }
-    if (type.basetype == spirv_cross::SPIRType::UInt && type.columns == 1)
-    {
-        switch (type.vecsize)
+        else
         {
-        case 1: return VK_FORMAT_R32_UINT;
-        case 2: return VK_FORMAT_R32G32_UINT;
-        case 3: return VK_FORMAT_R32G32B32_UINT;
-        case 4: return VK_FORMAT_R32G32B32A32_UINT;
-        default: break;
+            return set_raw(constant_id, &value, sizeof(T));
         }
     }
-    return VK_FORMAT_UNDEFINED;
-}
 
+    SpecializationConstants &set_raw(u32 constant_id, const void *data, u32 size);
+
+    const VkSpecializationInfo *get_info();
+    const std::vector<VkSpecializationMapEntry> &get_entries() const { return m_Entries; }
+    const void *get_value(const VkSpecializationMapEntry &entry) const { return m_Data.data() + entry.offset; }
+    bool empty() const { return m_Entries.empty(); }
+    u64 get_hash() const;
+
+private:
+    std::vector<VkSpecializationMapEntry> m_Entries;
+    std::vector<u8> m_Data;
+    VkSpecializationInfo m_Info = {};
+};
+
+struct ShaderDesc
+{
+    std::filesystem::path filepath;
+    VkShaderStageFlagBits stage;
+    std::vector<ShaderMacro> macros;
+};
+
+class ThreadPool;
+class ShaderArchive;
+struct ShaderArchiveEntry;
 
 class Shader {
 public:
-    Shader(const std::filesystem::path& filepath, VkShaderStageFlagBits stage);
+    // Compiles the source, or loads it from the cache (requires SHADER_RUNTIME_COMPILER)
+    Shader(const std::filesystem::path& filepath, VkShaderStageFlagBits stage, const std::vector<ShaderMacro> &macros = {});
+    // Creates the module directly from a cooked archive, no compiler or reflection involved
+    Shader(const ShaderArchive &archive, const ShaderArchiveEntry &entry);
     ~Shader();
 
+    // Compiles (or loads from cache), reflects and creates the modules of all shaders concurrently.
+    // Shaders found in the archive are taken from it instead. Returns once every module exists, in the same order as descs.
+    static std::vector<Ref<Shader>> create_batch(const std::vector<ShaderDesc> &descs, ThreadPool *thread_pool = nullptr, const ShaderArchive *archive = nullptr);
+
     const VkPipelineShaderStageCreateInfo &get_stage() { return m_StageCreateInfo; }
     VkShaderModule get_module() const { return m_Module; }
+    bool is_valid() const { return m_Module != VK_NULL_HANDLE; }
+    u64 get_spirv_hash() const { return m_SpirvHash; }
+    const std::filesystem::path &get_filepath() const { return m_Filepath; }
+    const std::vector<ShaderMacro> &get_macros() const { return m_Macros; }
+
+    // Headers this shader includes, directly or through other headers
+    const std::vector<std::filesystem::path> &get_dependencies() const { return m_Dependencies; }
+    bool depends_on(const std::filesystem::path &path) const;
 
     // Reflection getters
+    const ShaderReflection &get_reflection() const { return m_Reflection; }
+
     // Vertex input (only meaningful for vertex stage)
-    const std::vector<VkVertexInputAttributeDescription>& get_vertex_attributes() const { return m_VertexAttributes; }
-    u32 get_vertex_stride() const { return m_VertexStride; }
+    const std::vector<VkVertexInputAttributeDescription>& get_vertex_attributes() const { return m_Reflection.vertex_attributes; }
+    const std::vector<VkVertexInputBindingDescription>& get_vertex_bindings() const { return m_Reflection.vertex_bindings; }
+    u32 get_vertex_stride() const { return m_Reflection.vertex_stride; }
 
     // Descriptor set layout bindings grouped by set index
-    const std::unordered_map<u32, std::vector<VkDescriptorSetLayoutBinding>>& get_descriptor_set_layout_bindings() const { return m_SetBindings; }
+    const std::unordered_map<u32, std::vector<VkDescriptorSetLayoutBinding>>& get_descriptor_set_layout_bindings() const { return m_Reflection.set_bindings; }
 
     // Push constant ranges gathered from this shader
-    const std::vector<VkPushConstantRange>& get_push_constant_ranges() const { return m_PushConstantRanges; }
+    const std::vector<VkPushConstantRange>& get_push_constant_ranges() const { return m_Reflection.push_constant_ranges; }
+
+    // Specialization constants declared with layout(constant_id = N)
+    const std::vector<ShaderSpecializationConstant>& get_specialization_constants() const { return m_Reflection.specialization_constants; }
+    const ShaderSpecializationConstant *find_specialization_constant(u32 constant_id) const;
+    VkShaderStageFlagBits get_stage_flag() const { return m_StageCreateInfo.stage; }
+
+    // Workgroup size declared with layout(local_size_x = ...) (only meaningful for compute stage)
+    const std::array<u32, 3> &get_local_size() const { return m_Reflection.local_size; }
 
 private:
-    [[nodiscard]] static std::string read_file(const std::filesystem::path& file_path) ;
-    static std::vector<u32> compile_or_get_vulkan_binaries(const std::string &shader_source, const std::string &file_path, VkShaderStageFlagBits stage) ;
-    void reflect(VkShaderStageFlagBits shader_stage, const std::vector<u32> &code);
+    void create_module(const u32 *code, size_t size);
 
-    // Reflection data
-    std::vector<VkVertexInputAttributeDescription> m_VertexAttributes;
-    u32 m_VertexStride = 0;
-    std::unordered_map<u32, std::vector<VkDescriptorSetLayoutBinding>> m_SetBindings;
-    std::vector<VkPushConstantRange> m_PushConstantRanges;
+    ShaderReflection m_Reflection;
 
-    VkShaderModule m_Module;
+    std::filesystem::path m_Filepath;
+    std::vector<std::filesystem::path> m_Dependencies;
+    std::vector<ShaderMacro> m_Macros;
+    VkShaderModule m_Module = VK_NULL_HANDLE;
+    u64 m_SpirvHash = 0;
     VkPipelineShaderStageCreateInfo m_StageCreateInfo;
 };
 
+// One range over the push constants of every stage, visible to all of them. Pushes then always
+// pass the same stage flags, which covers each stage reading the pushed bytes.
+// Size is zero when no shader declares push constants.
+static VkPushConstantRange merge_push_constant_ranges(const std::vector<Ref<Shader>> &shaders)
+{
+    VkPushConstantRange merged = { 0, ~0u, 0 };
+    u32 end = 0;
+    for (const Ref<Shader> &shader : shaders)
+    {
+        for (const VkPushConstantRange &range : shader->get_push_constant_ranges())
+        {
+            merged.stageFlags |= range.stageFlags;
+            merged.offset = std::min(merged.offset, range.offset);
+            end = std::max(end, range.offset + range.size);
+        }
+    }
+
+    if (merged.stageFlags == 0)
+        return {};
+
+    merged.size = end - merged.offset;
+    return merged;
+}
+
 #endif //VULKAN_SHADER_H
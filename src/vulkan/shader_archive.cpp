@@ -0,0 +1,232 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "shader_archive.hpp"
+
+#include "core/binary_io.hpp"
+#include "core/logger.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+static void write_metadata(BinaryWriter &writer, const ShaderArchiveMetadata &metadata)
+{
+    writer.write_string(metadata.filepath.lexically_normal().generic_string());
+
+    writer.write(static_cast<u32>(metadata.macros.size()));
+    for (const ShaderMacro &macro : metadata.macros)
+    {
+        writer.write_string(macro.name);
+        writer.write_string(macro.value);
+    }
+
+    writer.write(static_cast<u32>(metadata.dependencies.size()));
+    for (const auto &dependency : metadata.dependencies)
+        writer.write_string(dependency.generic_string());
+
+    metadata.reflection.serialize(writer);
+}
+
+bool ShaderArchive::open(const std::filesystem::path &path)
+{
+    close();
+
+    if (!m_File.open(path))
+        return false;
+
+    const u8 *data = m_File.get_data();
+    const size_t size = m_File.get_size();
+
+    BinaryReader reader(data, size);
+    const ShaderArchiveHeader header = reader.read<ShaderArchiveHeader>();
+    const bool header_valid = reader.is_valid()
+        && header.magic == SHADER_ARCHIVE_MAGIC
+        && header.version == SHADER_ARCHIVE_VERSION
+        && header.file_size == size
+        && header.index_offset % alignof(ShaderArchiveEntry) == 0
+        && header.index_offset <= size
+        && header.entry_count <= (size - header.index_offset) / sizeof(ShaderArchiveEntry);
+
+    if (!header_valid)
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[ShaderArchive] Invalid archive {}", path.string());
+        m_File.close();
+        return false;
+    }
+
+    // Entries are read in place, validate every range once instead of on each lookup
+    const ShaderArchiveEntry *entries = reinterpret_cast<const ShaderArchiveEntry *>(data + header.index_offset);
+    for (u32 i = 0; i < header.entry_count; ++i)
+    {
+        const ShaderArchiveEntry &entry = entries[i];
+        const bool entry_valid = entry.spirv_offset % sizeof(u32) == 0
+            && entry.spirv_size % sizeof(u32) == 0
+            && entry.spirv_offset <= size && entry.spirv_size <= size - entry.spirv_offset
+            && entry.metadata_offset <= size && entry.metadata_size <= size - entry.metadata_offset
+            && (i == 0 || entries[i - 1].key < entry.key);
+
+        if (!entry_valid)
+        {
+            Logger::get_instance().push_message(LoggingLevel::Error, "[ShaderArchive] Corrupt entry {} in {}", i, path.string());
+            m_File.close();
+            return false;
+        }
+    }
+
+    m_Path = path;
+    m_Entries = entries;
+    m_EntryCount = header.entry_count;
+
+    Logger::get_instance().push_message(LoggingLevel::Info, "[ShaderArchive] Mapped {} ({} shaders, {} bytes)", path.string(), m_EntryCount, size);
+    return true;
+}
+
+void ShaderArchive::close()
+{
+    m_File.close();
+    m_Entries = nullptr;
+    m_EntryCount = 0;
+    m_Path.clear();
+}
+
+const ShaderArchiveEntry *ShaderArchive::find(u64 key) const
+{
+    if (!m_Entries)
+        return nullptr;
+
+    const ShaderArchiveEntry *end = m_Entries + m_EntryCount;
+    const ShaderArchiveEntry *it = std::lower_bound(m_Entries, end, key, [](const ShaderArchiveEntry &entry, u64 k) { return entry.key < k; });
+    return it != end && it->key == key ? it : nullptr;
+}
+
+const ShaderArchiveEntry *ShaderArchive::find(const std::filesystem::path &filepath, VkShaderStageFlagBits stage, const std::vector<ShaderMacro> &macros) const
+{
+    return find(get_shader_archive_key(filepath, stage, macros));
+}
+
+const u32 *ShaderArchive::get_spirv(const ShaderArchiveEntry &entry) const
+{
+    return reinterpret_cast<const u32 *>(m_File.get_data() + entry.spirv_offset);
+}
+
+bool ShaderArchive::read_metadata(const ShaderArchiveEntry &entry, ShaderArchiveMetadata &metadata) const
+{
+    BinaryReader reader(m_File.get_data() + entry.metadata_offset, entry.metadata_size);
+
+    metadata.filepath = reader.read_string();
+
+    const u32 macro_count = reader.read<u32>();
+    metadata.macros.clear();
+    for (u32 i = 0; i < macro_count && reader.is_valid(); ++i)
+    {
+        ShaderMacro macro;
+        macro.name = reader.read_string();
+        macro.value = reader.read_string();
+        metadata.macros.push_back(std::move(macro));
+    }
+
+    const u32 dependency_count = reader.read<u32>();
+    metadata.dependencies.clear();
+    for (u32 i = 0; i < dependency_count && reader.is_valid(); ++i)
+        metadata.dependencies.emplace_back(reader.read_string());
+
+    return metadata.reflection.deserialize(reader) && reader.is_at_end();
+}
+
+void ShaderArchiveWriter::add(const ShaderArchiveMetadata &metadata, VkShaderStageFlagBits stage, const std::vector<u32> &code)
+{
+    PendingEntry entry;
+    entry.key = get_shader_archive_key(metadata.filepath, stage, metadata.macros);
+    entry.stage = static_cast<u32>(stage);
+    entry.spirv_hash = hash_bytes(code.data(), code.size() * sizeof(u32));
+    entry.code = code;
+
+    BinaryWriter writer;
+    write_metadata(writer, metadata);
+    entry.metadata = std::move(writer.get_buffer());
+
+    m_Entries.push_back(std::move(entry));
+}
+
+bool ShaderArchiveWriter::write(const std::filesystem::path &path) const
+{
+    std::vector<const PendingEntry *> sorted;
+    sorted.reserve(m_Entries.size());
+    for (const PendingEntry &entry : m_Entries)
+        sorted.push_back(&entry);
+    std::sort(sorted.begin(), sorted.end(), [](const PendingEntry *a, const PendingEntry *b) { return a->key < b->key; });
+
+    for (size_t i = 1; i < sorted.size(); ++i)
+    {
+        if (sorted[i - 1]->key == sorted[i]->key)
+        {
+            Logger::get_instance().push_message(LoggingLevel::Error, "[ShaderArchive] Duplicate shader in archive");
+            return false;
+        }
+    }
+
+    std::vector<ShaderArchiveEntry> index(sorted.size());
+
+    // Blobs go after the index, fill the index while laying them out
+    BinaryWriter blobs;
+    const u64 index_offset = sizeof(ShaderArchiveHeader);
+    const u64 blob_offset = index_offset + index.size() * sizeof(ShaderArchiveEntry);
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        const PendingEntry &pending = *sorted[i];
+        ShaderArchiveEntry &entry = index[i];
+
+        // Align the absolute file offset, the index size only guarantees a multiple of 8
+        while ((blob_offset + blobs.get_size()) % SHADER_ARCHIVE_ALIGNMENT != 0)
+            blobs.write<u8>(0);
+
+        entry = {};
+        entry.key = pending.key;
+        entry.stage = pending.stage;
+        entry.spirv_hash = pending.spirv_hash;
+        entry.spirv_offset = blob_offset + blobs.get_size();
+        entry.spirv_size = pending.code.size() * sizeof(u32);
+        blobs.write_bytes(pending.code.data(), entry.spirv_size);
+
+        entry.metadata_offset = blob_offset + blobs.get_size();
+        entry.metadata_size = pending.metadata.size();
+        blobs.write_bytes(pending.metadata.data(), pending.metadata.size());
+    }
+
+    ShaderArchiveHeader header = {};
+    header.magic = SHADER_ARCHIVE_MAGIC;
+    header.version = SHADER_ARCHIVE_VERSION;
+    header.entry_count = static_cast<u32>(index.size());
+    header.index_offset = index_offset;
+    header.file_size = blob_offset + blobs.get_size();
+
+    std::filesystem::path temp_path = path;
+    temp_path += ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            Logger::get_instance().push_message(LoggingLevel::Error, "[ShaderArchive] Could not write {}", temp_path.string());
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(ShaderArchiveEntry)));
+        file.write(reinterpret_cast<const char *>(blobs.get_buffer().data()), static_cast<std::streamsize>(blobs.get_size()));
+        if (!file)
+        {
+            Logger::get_instance().push_message(LoggingLevel::Error, "[ShaderArchive] Could not write {}", temp_path.string());
+            return false;
+        }
+    }
+
+    // The running engine may have the old archive mapped, replace it rather than overwrite it in place
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec)
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[ShaderArchive] Could not replace {}: {}", path.string(), ec.message());
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
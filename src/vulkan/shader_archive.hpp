@@ -0,0 +1,115 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#ifndef VULKAN_SHADER_ARCHIVE_HPP
+#define VULKAN_SHADER_ARCHIVE_HPP
+
+#include "shader_reflection.hpp"
+
+#include "core/mapped_file.hpp"
+
+#include <filesystem>
+
+// Cooked shaders packed into one file:
+//   ShaderArchiveHeader
+//   ShaderArchiveEntry[entry_count], sorted by key
+//   per entry: SPIR-V (aligned to SHADER_ARCHIVE_ALIGNMENT), then its metadata
+// The file is mapped and read in place, SPIR-V goes to vkCreateShaderModule without a copy.
+static constexpr u32 SHADER_ARCHIVE_MAGIC = 0x43524153; // 'SARC'
+static constexpr u32 SHADER_ARCHIVE_VERSION = 2;
+static constexpr u32 SHADER_ARCHIVE_ALIGNMENT = 16;
+
+struct ShaderArchiveHeader
+{
+    u32 magic;
+    u32 version;
+    u32 entry_count;
+    u32 reserved;
+    u64 index_offset;
+    u64 file_size;
+};
+
+struct ShaderArchiveEntry
+{
+    u64 key; // get_shader_archive_key of the source
+    u64 spirv_hash;
+    u64 spirv_offset;
+    u64 spirv_size; // bytes
+    u64 metadata_offset;
+    u64 metadata_size;
+    u32 stage; // VkShaderStageFlagBits
+    u32 reserved;
+};
+
+// Everything about an entry except the SPIR-V itself
+struct ShaderArchiveMetadata
+{
+    std::filesystem::path filepath;
+    std::vector<ShaderMacro> macros;
+    std::vector<std::filesystem::path> dependencies;
+    ShaderReflection reflection;
+};
+
+// Shaders are looked up by the path they would be compiled from, so cooked and
+// runtime-compiled shaders are interchangeable
+static u64 get_shader_archive_key(const std::filesystem::path &filepath, VkShaderStageFlagBits stage, const std::vector<ShaderMacro> &macros)
+{
+    u64 key = hash_string(filepath.lexically_normal().generic_string());
+    hash_combine(key, stage);
+    hash_combine(key, hash_shader_macros(macros));
+    return key;
+}
+
+class ShaderArchive
+{
+public:
+    ShaderArchive() = default;
+
+    ShaderArchive(const ShaderArchive &) = delete;
+    ShaderArchive &operator=(const ShaderArchive &) = delete;
+
+    // Maps the archive and validates the header and index, false when missing or malformed
+    bool open(const std::filesystem::path &path);
+    void close();
+    bool is_open() const { return m_Entries != nullptr; }
+
+    const ShaderArchiveEntry *find(u64 key) const;
+    const ShaderArchiveEntry *find(const std::filesystem::path &filepath, VkShaderStageFlagBits stage, const std::vector<ShaderMacro> &macros) const;
+
+    // Points into the mapping, valid while the archive is open
+    const u32 *get_spirv(const ShaderArchiveEntry &entry) const;
+    bool read_metadata(const ShaderArchiveEntry &entry, ShaderArchiveMetadata &metadata) const;
+
+    u32 get_entry_count() const { return m_EntryCount; }
+    const ShaderArchiveEntry *get_entries() const { return m_Entries; }
+    const std::filesystem::path &get_path() const { return m_Path; }
+
+private:
+    MappedFile m_File;
+    std::filesystem::path m_Path;
+    const ShaderArchiveEntry *m_Entries = nullptr;
+    u32 m_EntryCount = 0;
+};
+
+// Builds an archive in memory, used by the offline ShaderCooker
+class ShaderArchiveWriter
+{
+public:
+    void add(const ShaderArchiveMetadata &metadata, VkShaderStageFlagBits stage, const std::vector<u32> &code);
+    bool write(const std::filesystem::path &path) const;
+
+    size_t get_entry_count() const { return m_Entries.size(); }
+
+private:
+    struct PendingEntry
+    {
+        u64 key;
+        u32 stage;
+        u64 spirv_hash;
+        std::vector<u32> code;
+        std::vector<u8> metadata;
+    };
+
+    std::vector<PendingEntry> m_Entries;
+};
+
+#endif //VULKAN_SHADER_ARCHIVE_HPP
@@ -0,0 +1,737 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "shader_compiler.hpp"
+
+#include "core/logger.hpp"
+#include "core/binary_io.hpp"
+
+#include <spirv_cross/spirv_cross.hpp>
+#include <spirv_cross/spirv_glsl.hpp>
+#include <shaderc/shaderc.hpp>
+
+#include <fstream>
+#include <format>
+#include <thread>
+#include <algorithm>
+#include <iterator>
+
+// Format of one column, matrix inputs take one location per column
+static VkFormat map_spirv_type_to_vk_format(const spirv_cross::SPIRType& type)
+{
+    using spirv_cross::SPIRType;
+    if (type.basetype == SPIRType::Float)
+    {
+        switch (type.vecsize)
+        {
+        case 1: return VK_FORMAT_R32_SFLOAT;
+        case 2: return VK_FORMAT_R32G32_SFLOAT;
+        case 3: return VK_FORMAT_R32G32B32_SFLOAT;
+        case 4: return VK_FORMAT_R32G32B32A32_SFLOAT;
+        default: break;
+        }
+    }
+    if (type.basetype == SPIRType::Int)
+    {
+        switch (type.vecsize)
+        {
+        case 1: return VK_FORMAT_R32_SINT;
+        case 2: return VK_FORMAT_R32G32_SINT;
+        case 3: return VK_FORMAT_R32G32B32_SINT;
+        case 4: return VK_FORMAT_R32G32B32A32_SINT;
+        default: break;
+        }
+    }
+    if (type.basetype == spirv_cross::SPIRType::UInt)
+    {
+        switch (type.vecsize)
+        {
+        case 1: return VK_FORMAT_R32_UINT;
+        case 2: return VK_FORMAT_R32G32_UINT;
+        case 3: return VK_FORMAT_R32G32B32_UINT;
+        case 4: return VK_FORMAT_R32G32B32A32_UINT;
+        default: break;
+        }
+    }
+    return VK_FORMAT_UNDEFINED;
+}
+
+static std::filesystem::path &get_cached_directory()
+{
+    static std::filesystem::path cached_directory = "res/cache/shaders";
+    return cached_directory;
+}
+
+static void create_cached_directory_if_needed()
+{
+    const std::filesystem::path &cached_directory = get_cached_directory();
+    if (!std::filesystem::exists(cached_directory))
+    {
+        std::filesystem::create_directories(cached_directory);
+    }
+}
+
+// Root for #include <...>, quoted includes are resolved relative to the including file first
+static const char *get_shader_root_directory()
+{
+    return "res/shaders";
+}
+
+// Resolves #include directives and records every file it opened, so the
+// cache key and hot reload can follow headers
+class ShaderIncluder final : public shaderc::CompileOptions::IncluderInterface
+{
+public:
+    struct Dependency
+    {
+        std::filesystem::path path;
+        u64 hash;
+    };
+
+    explicit ShaderIncluder(std::vector<Dependency> &dependencies)
+        : m_Dependencies(dependencies)
+    {
+    }
+
+    shaderc_include_result *GetInclude(const char *requested_source, shaderc_include_type type,
+        const char *requesting_source, size_t include_depth) override
+    {
+        (void)include_depth;
+
+        auto *include = new IncludeData();
+        const std::filesystem::path resolved = resolve(requested_source, type, requesting_source);
+        if (resolved.empty())
+        {
+            include->content = std::format("Could not find include '{}' from '{}'", requested_source, requesting_source);
+        }
+        else
+        {
+            include->name = resolved.generic_string();
+            include->content = read_source(resolved);
+            record(resolved, include->content);
+        }
+
+        // An empty source name tells shaderc the include failed and content holds the error
+        include->result.source_name = include->name.c_str();
+        include->result.source_name_length = include->name.size();
+        include->result.content = include->content.c_str();
+        include->result.content_length = include->content.size();
+        include->result.user_data = include;
+        return &include->result;
+    }
+
+    void ReleaseInclude(shaderc_include_result *data) override
+    {
+        delete static_cast<IncludeData *>(data->user_data);
+    }
+
+private:
+    struct IncludeData
+    {
+        shaderc_include_result result = {};
+        std::string name;
+        std::string content;
+    };
+
+    static std::filesystem::path resolve(const char *requested_source, shaderc_include_type type, const char *requesting_source)
+    {
+        std::error_code ec;
+        if (type == shaderc_include_type_relative)
+        {
+            const std::filesystem::path relative = std::filesystem::path(requesting_source).parent_path() / requested_source;
+            if (std::filesystem::is_regular_file(relative, ec))
+                return relative.lexically_normal();
+        }
+
+        const std::filesystem::path rooted = std::filesystem::path(get_shader_root_directory()) / requested_source;
+        if (std::filesystem::is_regular_file(rooted, ec))
+            return rooted.lexically_normal();
+
+        return {};
+    }
+
+    static std::string read_source(const std::filesystem::path &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    void record(const std::filesystem::path &path, const std::string &content)
+    {
+        for (const Dependency &dependency : m_Dependencies)
+        {
+            if (dependency.path == path)
+                return;
+        }
+        m_Dependencies.push_back({ path, hash_string(content) });
+    }
+
+    std::vector<Dependency> &m_Dependencies;
+};
+
+static shaderc_shader_kind vulkan_shader_to_shaderc_kind(const VkShaderStageFlagBits stage)
+{
+    switch (stage)
+    {
+    case VK_SHADER_STAGE_VERTEX_BIT: return shaderc_glsl_vertex_shader;
+    case VK_SHADER_STAGE_FRAGMENT_BIT: return shaderc_glsl_fragment_shader;
+    case VK_SHADER_STAGE_GEOMETRY_BIT: return shaderc_glsl_geometry_shader;
+    case VK_SHADER_STAGE_COMPUTE_BIT: return shaderc_glsl_compute_shader;
+    default: return static_cast<shaderc_shader_kind>(0);
+    }
+}
+
+static std::string vulkan_shader_stage_extension(const VkShaderStageFlagBits stage)
+{
+    switch (stage)
+    {
+    case VK_SHADER_STAGE_VERTEX_BIT: return ".vert.spv";
+    case VK_SHADER_STAGE_FRAGMENT_BIT: return ".frag.spv";
+    case VK_SHADER_STAGE_COMPUTE_BIT: return ".comp.spv";
+    case VK_SHADER_STAGE_GEOMETRY_BIT: return ".geom.spv";
+    case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT: return ".tes.spv";
+    default: return "Invalid";
+    }
+}
+
+// Bump when the cache entry layout changes
+static constexpr u32 SHADER_CACHE_VERSION = 1;
+// The oldest device version the context creates a device for, with subgroup operations
+static constexpr shaderc_env_version SHADER_TARGET_ENV_VERSION = shaderc_env_version_vulkan_1_1;
+static constexpr shaderc_optimization_level SHADER_OPTIMIZATION_LEVEL = shaderc_optimization_level_performance;
+
+static u64 get_source_cache_key(const std::string &preprocessed_source, const VkShaderStageFlagBits stage,
+    const std::vector<ShaderIncluder::Dependency> &dependencies)
+{
+    u32 spv_version = 0;
+    u32 spv_revision = 0;
+    shaderc_get_spv_version(&spv_version, &spv_revision);
+
+    u64 key = hash_string(preprocessed_source);
+    hash_combine(key, stage);
+    hash_combine(key, SHADER_CACHE_VERSION);
+    hash_combine(key, shaderc_target_env_vulkan);
+    hash_combine(key, SHADER_TARGET_ENV_VERSION);
+    hash_combine(key, SHADER_OPTIMIZATION_LEVEL);
+    hash_combine(key, spv_version);
+    hash_combine(key, spv_revision);
+
+    // Include graph, in include order
+    for (const auto &dependency : dependencies)
+    {
+        key = hash_string(dependency.path.generic_string(), key);
+        hash_combine(key, dependency.hash);
+    }
+    return key;
+}
+
+static std::vector<u32> read_spirv_file(const std::filesystem::path &path)
+{
+    std::vector<u32> code;
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return code;
+
+    file.seekg(0, std::ios::end);
+    const std::streamoff size = file.tellg();
+    if (size <= 0 || size % sizeof(u32) != 0)
+        return code;
+
+    file.seekg(0, std::ios::beg);
+    code.resize(static_cast<size_t>(size) / sizeof(u32));
+    if (!file.read(reinterpret_cast<char *>(code.data()), size))
+        code.clear();
+    return code;
+}
+
+// Writes to a temporary file and renames it, so readers never observe a partial entry
+static void write_file_atomic(const std::filesystem::path &path, const void *data, size_t size)
+{
+    std::filesystem::path temp_path = path;
+    temp_path += std::format(".{}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+    {
+        std::ofstream out_file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out_file.is_open())
+        {
+            Logger::get_instance().push_message(LoggingLevel::Warning, "[Shader] Could not write cache file {}", temp_path.string());
+            return;
+        }
+        out_file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec)
+    {
+        Logger::get_instance().push_message(LoggingLevel::Warning, "[Shader] Could not commit cache file {}: {}", path.string(), ec.message());
+        std::filesystem::remove(temp_path, ec);
+    }
+}
+
+static void write_spirv_file_atomic(const std::filesystem::path &path, const std::vector<u32> &code)
+{
+    write_file_atomic(path, code.data(), code.size() * sizeof(u32));
+}
+
+// Removes older entries that were compiled from the same source file.
+// Sidecars of the current entry share its file name and are kept.
+static void evict_stale_cache_entries(const std::filesystem::path &directory, const std::string &prefix, const std::filesystem::path &current)
+{
+    const std::string current_name = current.filename().string();
+
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, ec))
+    {
+        const std::filesystem::path &path = entry.path();
+        const std::string name = path.filename().string();
+        if (name.starts_with(current_name) || !name.starts_with(prefix))
+            continue;
+
+        if (path.extension() == ".tmp")
+            continue;
+
+        std::filesystem::remove(path, ec);
+    }
+}
+
+static constexpr u32 SHADER_REFLECTION_MAGIC = 0x4C465253; // 'SRFL'
+static constexpr u32 SHADER_REFLECTION_VERSION = 4;
+
+static std::filesystem::path get_reflection_path(const std::filesystem::path &cached_path)
+{
+    std::filesystem::path path = cached_path;
+    path += ".refl";
+    return path;
+}
+
+static bool load_reflection_file(const std::filesystem::path &path, u64 spirv_hash, ShaderReflection &reflection)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    const std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    BinaryReader reader(data.data(), data.size());
+
+    const u32 magic = reader.read<u32>();
+    const u32 version = reader.read<u32>();
+    const u64 stored_hash = reader.read<u64>();
+    if (!reader.is_valid() || magic != SHADER_REFLECTION_MAGIC || version != SHADER_REFLECTION_VERSION || stored_hash != spirv_hash)
+        return false;
+
+    if (!reflection.deserialize(reader) || !reader.is_at_end())
+    {
+        Logger::get_instance().push_message(LoggingLevel::Warning, "[Shader] Corrupt reflection cache {}", path.string());
+        return false;
+    }
+    return true;
+}
+
+static void save_reflection_file(const std::filesystem::path &path, u64 spirv_hash, const ShaderReflection &reflection)
+{
+    BinaryWriter writer;
+    writer.write(SHADER_REFLECTION_MAGIC);
+    writer.write(SHADER_REFLECTION_VERSION);
+    writer.write(spirv_hash);
+    reflection.serialize(writer);
+
+    write_file_atomic(path, writer.get_buffer().data(), writer.get_size());
+}
+
+ShaderCompileResult ShaderCompiler::compile(const std::filesystem::path &filepath, VkShaderStageFlagBits stage, const std::vector<ShaderMacro> &macros)
+{
+    // An empty result leaves the caller on its previous module, a missing file during hot reload included
+    if (!std::filesystem::exists(filepath))
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[Shader] Shader {} does not exist", filepath.string());
+        return {};
+    }
+
+    create_cached_directory_if_needed();
+    const std::string shader_source = read_file(filepath);
+
+    ShaderCompileResult result = compile_or_get_vulkan_binaries(shader_source, filepath.string(), stage, macros);
+    if (result.code.empty())
+        return result;
+
+    result.spirv_hash = hash_bytes(result.code.data(), result.code.size() * sizeof(u32));
+
+    // Warm starts read the reflection from the sidecar instead of running SPIRV-Cross
+    const std::filesystem::path reflection_path = get_reflection_path(result.cached_path);
+    if (!load_reflection_file(reflection_path, result.spirv_hash, result.reflection))
+    {
+        result.reflection = reflect(stage, result.code, result.vertex_overrides);
+        save_reflection_file(reflection_path, result.spirv_hash, result.reflection);
+    }
+    return result;
+}
+
+void ShaderCompiler::set_cache_directory(const std::filesystem::path &directory)
+{
+    get_cached_directory() = directory;
+}
+
+void ShaderCompiler::store_cache_entry(const ShaderCompileResult &result)
+{
+    if (result.code.empty() || result.cached_path.empty())
+        return;
+
+    const u64 spirv_hash = hash_bytes(result.code.data(), result.code.size() * sizeof(u32));
+    write_spirv_file_atomic(result.cached_path, result.code);
+    save_reflection_file(get_reflection_path(result.cached_path), spirv_hash, result.reflection);
+}
+
+// Opcodes that only carry names, source text and line info, see the SPIR-V specification section 3.49.2
+static constexpr u32 SPIRV_MAGIC = 0x07230203;
+static constexpr u32 SPIRV_HEADER_WORDS = 5;
+static constexpr u32 SPIRV_OP_SOURCE_CONTINUED = 2;
+static constexpr u32 SPIRV_OP_SOURCE = 3;
+static constexpr u32 SPIRV_OP_SOURCE_EXTENSION = 4;
+static constexpr u32 SPIRV_OP_NAME = 5;
+static constexpr u32 SPIRV_OP_MEMBER_NAME = 6;
+static constexpr u32 SPIRV_OP_STRING = 7;
+static constexpr u32 SPIRV_OP_LINE = 8;
+static constexpr u32 SPIRV_OP_NO_LINE = 317;
+static constexpr u32 SPIRV_OP_MODULE_PROCESSED = 330;
+
+static bool is_spirv_debug_instruction(u32 opcode)
+{
+    switch (opcode)
+    {
+    case SPIRV_OP_SOURCE_CONTINUED:
+    case SPIRV_OP_SOURCE:
+    case SPIRV_OP_SOURCE_EXTENSION:
+    case SPIRV_OP_NAME:
+    case SPIRV_OP_MEMBER_NAME:
+    case SPIRV_OP_STRING:
+    case SPIRV_OP_LINE:
+    case SPIRV_OP_NO_LINE:
+    case SPIRV_OP_MODULE_PROCESSED:
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::vector<u32> ShaderCompiler::strip_debug_info(const std::vector<u32> &code)
+{
+    if (code.size() < SPIRV_HEADER_WORDS || code[0] != SPIRV_MAGIC)
+        return code;
+
+    std::vector<u32> stripped(code.begin(), code.begin() + SPIRV_HEADER_WORDS);
+    stripped.reserve(code.size());
+
+    size_t offset = SPIRV_HEADER_WORDS;
+    while (offset < code.size())
+    {
+        const u32 word_count = code[offset] >> 16;
+        const u32 opcode = code[offset] & 0xFFFF;
+        if (word_count == 0 || offset + word_count > code.size())
+        {
+            Logger::get_instance().push_message(LoggingLevel::Warning, "[Shader] Malformed SPIR-V, debug info kept");
+            return code;
+        }
+
+        if (!is_spirv_debug_instruction(opcode))
+            stripped.insert(stripped.end(), code.begin() + offset, code.begin() + offset + word_count);
+        offset += word_count;
+    }
+    return stripped;
+}
+
+bool ShaderCompiler::get_stage_from_extension(const std::filesystem::path &filepath, VkShaderStageFlagBits &stage)
+{
+    const std::string extension = filepath.extension().string();
+    if (extension == ".vert") stage = VK_SHADER_STAGE_VERTEX_BIT;
+    else if (extension == ".frag") stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    else if (extension == ".geom") stage = VK_SHADER_STAGE_GEOMETRY_BIT;
+    else if (extension == ".comp") stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    else return false;
+    return true;
+}
+
+std::string ShaderCompiler::get_stage_name(const VkShaderStageFlagBits stage)
+{
+    switch (stage)
+    {
+    case VK_SHADER_STAGE_VERTEX_BIT: return "Vertex";
+    case VK_SHADER_STAGE_FRAGMENT_BIT: return "Fragment";
+    case VK_SHADER_STAGE_COMPUTE_BIT: return "Compute";
+    case VK_SHADER_STAGE_GEOMETRY_BIT: return "Geometry";
+    case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT: return "Tessellation";
+    default: return "Invalid";
+    }
+}
+
+std::string ShaderCompiler::read_file(const std::filesystem::path& file_path)
+{
+    std::string result;
+    std::ifstream shader_in(file_path.string(), std::ios::binary);
+    if (shader_in.is_open())
+    {
+        shader_in.seekg(0, std::ios::end);
+        if (size_t size = shader_in.tellg(); size != -1)
+        {
+            result.resize(size);
+            shader_in.seekg(0, std::ios::beg);
+            shader_in.read(&result[0], size);
+        }
+        else
+        {
+            Logger::get_instance().push_message(LoggingLevel::Error, "[Shader] Could not read from file. {}", file_path.string());
+        }
+
+        shader_in.close();
+    }
+    else
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[Shader] Could not open file. {}", file_path.string());
+    }
+    return result;
+}
+
+ShaderCompileResult ShaderCompiler::compile_or_get_vulkan_binaries(const std::string& shader_source, const std::string& file_path, VkShaderStageFlagBits stage,
+    const std::vector<ShaderMacro> &macros)
+{
+    ShaderCompileResult result;
+
+    // shaderc::Compiler is not thread safe, one per thread for batch compilation
+    thread_local shaderc::Compiler compiler;
+    shaderc::CompileOptions options;
+
+    std::filesystem::path cached_directory = get_cached_directory();
+
+    options.SetTargetEnvironment(shaderc_target_env_vulkan, SHADER_TARGET_ENV_VERSION);
+    options.SetOptimizationLevel(SHADER_OPTIMIZATION_LEVEL);
+
+    for (const ShaderMacro &macro : macros)
+    {
+        if (macro.value.empty())
+            options.AddMacroDefinition(macro.name);
+        else
+            options.AddMacroDefinition(macro.name, macro.value);
+    }
+
+    std::vector<ShaderIncluder::Dependency> dependencies;
+    options.SetIncluder(std::make_unique<ShaderIncluder>(dependencies));
+
+    // Key the cache on what is actually compiled, not on the file name.
+    // Includes are expanded here, so the compile below never touches the includer again.
+    const shaderc_shader_kind kind = vulkan_shader_to_shaderc_kind(stage);
+    shaderc::PreprocessedSourceCompilationResult preprocessed = compiler.PreprocessGlsl(shader_source, kind, file_path.c_str(), options);
+
+    for (const auto &dependency : dependencies)
+        result.dependencies.push_back(dependency.path);
+
+    if (preprocessed.GetCompilationStatus() != shaderc_compilation_status_success)
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[Shader] Preprocessing failed {}", preprocessed.GetErrorMessage());
+        return result;
+    }
+
+    const std::string preprocessed_source(preprocessed.cbegin(), preprocessed.cend());
+    if (stage == VK_SHADER_STAGE_VERTEX_BIT)
+        result.vertex_overrides = parse_vertex_input_annotations(preprocessed_source);
+    const u64 source_key = get_source_cache_key(preprocessed_source, stage, dependencies);
+
+    // Variants of one file get their own prefix so evicting one never removes another
+    u64 path_key = hash_string(std::filesystem::path(file_path).lexically_normal().generic_string());
+    hash_combine(path_key, hash_shader_macros(macros));
+    const std::string cache_prefix = std::format("{:016x}-", path_key);
+
+    result.cached_path = cached_directory / std::format("{}{:016x}{}", cache_prefix, source_key, vulkan_shader_stage_extension(stage));
+
+    result.code = read_spirv_file(result.cached_path);
+    if (!result.code.empty())
+    {
+        return result;
+    }
+
+    shaderc::SpvCompilationResult module = compiler.CompileGlslToSpv(preprocessed_source, kind, file_path.c_str(), options);
+    bool success = module.GetCompilationStatus() == shaderc_compilation_status_success;
+    std::string error_message = module.GetErrorMessage();
+    if (!success)
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[Shader] Compilation failed {}", error_message);
+        return result;
+    }
+
+    result.code = std::vector<u32>(module.cbegin(), module.cend());
+
+    write_spirv_file_atomic(result.cached_path, result.code);
+    evict_stale_cache_entries(cached_directory, cache_prefix, result.cached_path);
+
+    return result;
+}
+
+ShaderReflection ShaderCompiler::reflect(const VkShaderStageFlagBits shader_stage, const std::vector<u32>& code,
+    const std::vector<VertexInputOverride> &vertex_overrides)
+{
+    ShaderReflection reflection;
+    spirv_cross::Compiler compiler(code);
+    spirv_cross::ShaderResources resources = compiler.get_shader_resources();
+
+    Logger::get_instance().push_message(LoggingLevel::Info, "[Shader] Shader reflect - {}", get_stage_name(shader_stage));
+    Logger::get_instance().push_message(LoggingLevel::Info, "[Shader]    {} Uniform buffers", resources.uniform_buffers.size());
+    Logger::get_instance().push_message(LoggingLevel::Info, "[Shader]    {} Resources", resources.sampled_images.size());
+
+    // Descriptor sets: Uniform buffers
+    for (const auto& uniform_buffer : resources.uniform_buffers)
+    {
+        const auto &buffer_type = compiler.get_type(uniform_buffer.base_type_id);
+        (void)buffer_type; // size can be used by user later
+        u32 binding = compiler.get_decoration(uniform_buffer.id, spv::DecorationBinding);
+        u32 set     = compiler.get_decoration(uniform_buffer.id, spv::DecorationDescriptorSet);
+        VkDescriptorSetLayoutBinding b {};
+        b.binding = binding;
+        b.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        b.descriptorCount = 1;
+        b.stageFlags = shader_stage;
+        b.pImmutableSamplers = nullptr;
+        reflection.set_bindings[set].push_back(b);
+    }
+
+    // Descriptor sets: Sampled images / combined image samplers
+    for (const auto& si : resources.sampled_images)
+    {
+        u32 binding = compiler.get_decoration(si.id, spv::DecorationBinding);
+        u32 set     = compiler.get_decoration(si.id, spv::DecorationDescriptorSet);
+        VkDescriptorSetLayoutBinding b {};
+        b.binding = binding;
+        b.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        b.descriptorCount = 1;
+        b.stageFlags = shader_stage;
+        b.pImmutableSamplers = nullptr;
+        reflection.set_bindings[set].push_back(b);
+    }
+
+    // Descriptor sets: Storage buffers
+    for (const auto& sb : resources.storage_buffers)
+    {
+        u32 binding = compiler.get_decoration(sb.id, spv::DecorationBinding);
+        u32 set     = compiler.get_decoration(sb.id, spv::DecorationDescriptorSet);
+        VkDescriptorSetLayoutBinding b {};
+        b.binding = binding;
+        b.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        b.descriptorCount = 1;
+        b.stageFlags = shader_stage;
+        b.pImmutableSamplers = nullptr;
+        reflection.set_bindings[set].push_back(b);
+    }
+
+    // Descriptor sets: Storage images
+    for (const auto& si : resources.storage_images)
+    {
+        u32 binding = compiler.get_decoration(si.id, spv::DecorationBinding);
+        u32 set     = compiler.get_decoration(si.id, spv::DecorationDescriptorSet);
+        VkDescriptorSetLayoutBinding b {};
+        b.binding = binding;
+        b.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        b.descriptorCount = 1;
+        b.stageFlags = shader_stage;
+        b.pImmutableSamplers = nullptr;
+        reflection.set_bindings[set].push_back(b);
+    }
+
+    // Push constants
+    for (const auto& pc : resources.push_constant_buffers)
+    {
+        const auto &pc_type = compiler.get_type(pc.base_type_id);
+        u32 size = compiler.get_declared_struct_size(pc_type);
+
+        // Blocks shared between stages place their members with layout(offset = N),
+        // the range starts at the first member
+        u32 offset = size;
+        for (u32 member = 0; member < static_cast<u32>(pc_type.member_types.size()); ++member)
+            offset = std::min(offset, compiler.type_struct_member_offset(pc_type, member));
+
+        VkPushConstantRange range {};
+        range.stageFlags = shader_stage;
+        range.offset = offset == size ? 0 : offset;
+        range.size = size - range.offset;
+        reflection.push_constant_ranges.push_back(range);
+    }
+
+    // Specialization constants
+    reflection.specialization_constants.clear();
+    for (const auto& sc : compiler.get_specialization_constants())
+    {
+        const auto &constant = compiler.get_constant(sc.id);
+        const auto &type = compiler.get_type(constant.constant_type);
+
+        ShaderSpecializationConstant spec {};
+        spec.constant_id = sc.constant_id;
+        spec.size = type.basetype == spirv_cross::SPIRType::Boolean ? sizeof(VkBool32) : type.width / 8;
+        spec.name = compiler.get_name(sc.id);
+        reflection.specialization_constants.push_back(spec);
+
+        Logger::get_instance().push_message(LoggingLevel::Info, "[Shader]    Specialization constant {} '{}' ({} bytes)",
+            spec.constant_id, spec.name, spec.size);
+    }
+
+    // Workgroup size (only for compute stage)
+    if (shader_stage == VK_SHADER_STAGE_COMPUTE_BIT)
+    {
+        for (u32 i = 0; i < 3; ++i)
+        {
+            reflection.local_size[i] = std::max(1u, compiler.get_execution_mode_argument(spv::ExecutionModeLocalSize, i));
+        }
+        Logger::get_instance().push_message(LoggingLevel::Info, "[Shader]    Local size {}x{}x{}", reflection.local_size[0], reflection.local_size[1], reflection.local_size[2]);
+    }
+
+    // Vertex inputs (only for vertex stage)
+    if (shader_stage == VK_SHADER_STAGE_VERTEX_BIT)
+    {
+        reflection.vertex_attributes.clear();
+        reflection.vertex_bindings.clear();
+        reflection.vertex_stride = 0;
+        // Sort inputs by location to compute offsets consistently
+        struct InAttr { u32 loc; spirv_cross::ID id; };
+        std::vector<InAttr> inputs;
+        inputs.reserve(resources.stage_inputs.size());
+        for (const auto& in : resources.stage_inputs)
+        {
+            u32 loc = compiler.get_decoration(in.id, spv::DecorationLocation);
+            inputs.push_back({loc, in.id});
+        }
+        std::sort(inputs.begin(), inputs.end(), [](const InAttr& a, const InAttr& b){ return a.loc < b.loc; });
+
+        std::vector<VertexInputOverride> overrides = vertex_overrides;
+        for (const auto& it : inputs)
+        {
+            const auto &type = compiler.get_type(compiler.get_type_from_variable(it.id).self);
+            VkFormat fmt = map_spirv_type_to_vk_format(type);
+            if (fmt == VK_FORMAT_UNDEFINED)
+                continue; // skip unsupported types
+
+            const u32 columns = std::max(1u, type.columns);
+            for (u32 column = 0; column < columns; ++column)
+            {
+                VkVertexInputAttributeDescription attr {};
+                attr.location = it.loc + column;
+                attr.binding = 0;
+                attr.format = fmt;
+                reflection.vertex_attributes.push_back(attr);
+            }
+
+            // An annotation on a matrix applies to all of its columns, so an instance transform
+            // needs a single vertex_binding pragma
+            auto base = std::find_if(vertex_overrides.begin(), vertex_overrides.end(),
+                [&](const VertexInputOverride &o) { return o.location == it.loc; });
+            for (u32 column = 1; base != vertex_overrides.end() && column < columns; ++column)
+            {
+                const u32 location = it.loc + column;
+                if (std::none_of(vertex_overrides.begin(), vertex_overrides.end(), [&](const VertexInputOverride &o) { return o.location == location; }))
+                {
+                    VertexInputOverride column_override = *base;
+                    column_override.location = location;
+                    overrides.push_back(column_override);
+                }
+            }
+        }
+
+        // Lays out the bindings, offsets and strides, with the declared storage formats applied
+        reflection.apply_vertex_input_overrides(overrides);
+    }
+    return reflection;
+}
@@ -0,0 +1,54 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#ifndef VULKAN_SHADER_COMPILER_HPP
+#define VULKAN_SHADER_COMPILER_HPP
+
+#include "shader_reflection.hpp"
+
+#include <filesystem>
+
+// SPIR-V plus what produced it
+struct ShaderCompileResult
+{
+    std::vector<u32> code;
+    u64 spirv_hash = 0;
+    ShaderReflection reflection;
+    std::filesystem::path cached_path; // cache entry, sidecars are stored next to it
+    std::vector<std::filesystem::path> dependencies; // every file pulled in through #include, normalized
+    std::vector<VertexInputOverride> vertex_overrides; // #pragma vertex_* annotations of the source
+};
+
+// GLSL to SPIR-V through shaderc, reflection through SPIRV-Cross and the on-disk cache.
+// Needs no device, so the offline ShaderCooker links it without the rest of the engine.
+// Thread safe, each thread keeps its own shaderc compiler.
+class ShaderCompiler
+{
+public:
+    // Loads SPIR-V and reflection from the cache, compiling and reflecting only what is missing.
+    // code is empty when the source could not be compiled.
+    static ShaderCompileResult compile(const std::filesystem::path &filepath, VkShaderStageFlagBits stage, const std::vector<ShaderMacro> &macros = {});
+
+    static ShaderReflection reflect(VkShaderStageFlagBits stage, const std::vector<u32> &code, const std::vector<VertexInputOverride> &vertex_overrides = {});
+
+    // Removes names, source text and line info. Reflection has to run before, it reads the names.
+    static std::vector<u32> strip_debug_info(const std::vector<u32> &code);
+
+    // Overwrites the cache entry of result with its code and reflection, used to store post-processed SPIR-V
+    static void store_cache_entry(const ShaderCompileResult &result);
+
+    // Defaults to res/cache/shaders, change before compiling anything
+    static void set_cache_directory(const std::filesystem::path &directory);
+
+    // Maps .vert/.frag/.geom/.comp to their stage, false for anything else
+    static bool get_stage_from_extension(const std::filesystem::path &filepath, VkShaderStageFlagBits &stage);
+
+    static std::string get_stage_name(VkShaderStageFlagBits stage);
+
+    [[nodiscard]] static std::string read_file(const std::filesystem::path &file_path);
+
+private:
+    static ShaderCompileResult compile_or_get_vulkan_binaries(const std::string &shader_source, const std::string &file_path, VkShaderStageFlagBits stage,
+        const std::vector<ShaderMacro> &macros);
+};
+
+#endif //VULKAN_SHADER_COMPILER_HPP
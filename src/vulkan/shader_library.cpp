@@ -0,0 +1,225 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "shader_library.hpp"
+#include "graphics_pipeline.hpp"
+#include "shader_archive.hpp"
+
+#include "core/file_watcher.hpp"
+#include "core/logger.hpp"
+#include "core/thread_pool.hpp"
+
+#include <chrono>
+#include <format>
+#include <unordered_set>
+
+static bool same_descriptor_layout(const Shader &a, const Shader &b)
+{
+    const auto &sets_a = a.get_descriptor_set_layout_bindings();
+    const auto &sets_b = b.get_descriptor_set_layout_bindings();
+    if (sets_a.size() != sets_b.size())
+        return false;
+
+    for (const auto &[set, bindings] : sets_a)
+    {
+        auto it = sets_b.find(set);
+        if (it == sets_b.end() || it->second.size() != bindings.size())
+            return false;
+
+        for (size_t i = 0; i < bindings.size(); ++i)
+        {
+            if (bindings[i].binding != it->second[i].binding || bindings[i].descriptorType != it->second[i].descriptorType)
+                return false;
+        }
+    }
+    return true;
+}
+
+ShaderLibrary::~ShaderLibrary()
+{
+    destroy();
+}
+
+std::string ShaderLibrary::get_key(const std::filesystem::path &filepath, VkShaderStageFlagBits stage, const std::vector<ShaderMacro> &macros)
+{
+    return std::format("{}:{}:{:016x}", filepath.lexically_normal().generic_string(), static_cast<u32>(stage), hash_shader_macros(macros));
+}
+
+Ref<Shader> ShaderLibrary::load(const std::filesystem::path &filepath, VkShaderStageFlagBits stage, const std::vector<ShaderMacro> &macros)
+{
+    return load_batch({ { filepath, stage, macros } }).front();
+}
+
+std::vector<Ref<Shader>> ShaderLibrary::load_batch(const std::vector<ShaderDesc> &descs)
+{
+    std::vector<Ref<Shader>> result(descs.size());
+    std::vector<ShaderDesc> missing;
+    std::vector<size_t> missing_indices;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (size_t i = 0; i < descs.size(); ++i)
+        {
+            auto it = m_Shaders.find(get_key(descs[i].filepath, descs[i].stage, descs[i].macros));
+            if (it != m_Shaders.end())
+            {
+                result[i] = it->second.shader;
+            }
+            else
+            {
+                missing.push_back(descs[i]);
+                missing_indices.push_back(i);
+            }
+        }
+    }
+
+    if (missing.empty())
+        return result;
+
+    std::vector<Ref<Shader>> shaders = Shader::create_batch(missing, nullptr, m_Archive.get());
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (size_t i = 0; i < shaders.size(); ++i)
+    {
+        m_Shaders[get_key(missing[i].filepath, missing[i].stage, missing[i].macros)].shader = shaders[i];
+        result[missing_indices[i]] = shaders[i];
+    }
+    return result;
+}
+
+void ShaderLibrary::add_dependent(const Ref<GraphicsPipeline> &pipeline)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (const auto &shader : pipeline->get_shaders())
+    {
+        auto it = m_Shaders.find(get_key(shader->get_filepath(), shader->get_stage_flag(), shader->get_macros()));
+        if (it != m_Shaders.end())
+            it->second.dependents.push_back(pipeline);
+    }
+}
+
+bool ShaderLibrary::mount_archive(const std::filesystem::path &path)
+{
+    Scope<ShaderArchive> archive = CreateScope<ShaderArchive>();
+    if (!archive->open(path))
+        return false;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Archive = std::move(archive);
+    return true;
+}
+
+void ShaderLibrary::enable_hot_reload(const std::filesystem::path &directory)
+{
+    m_Watcher = CreateScope<FileWatcher>(directory, [this](const std::filesystem::path &path)
+    {
+        on_file_changed(path);
+    });
+}
+
+void ShaderLibrary::on_file_changed(const std::filesystem::path &path)
+{
+    const std::filesystem::path changed = path.lexically_normal();
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (const auto &[key, entry] : m_Shaders)
+    {
+        // Editing a header recompiles exactly the shaders that include it
+        if (entry.shader->get_filepath().lexically_normal() != changed && !entry.shader->depends_on(changed))
+            continue;
+
+        Logger::get_instance().push_message(LoggingLevel::Info, "[Shader] Reloading {} ({} changed)",
+            entry.shader->get_filepath().generic_string(), changed.generic_string());
+
+        const std::filesystem::path filepath = entry.shader->get_filepath();
+        const VkShaderStageFlagBits stage = entry.shader->get_stage_flag();
+        const std::vector<ShaderMacro> macros = entry.shader->get_macros();
+        m_PendingReloads.push_back({ key, ThreadPool::get_instance().submit([filepath, stage, macros]()
+        {
+            return CreateRef<Shader>(filepath, stage, macros);
+        }) });
+    }
+}
+
+void ShaderLibrary::update()
+{
+    std::vector<std::pair<std::string, Ref<Shader>>> reloaded;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (auto it = m_PendingReloads.begin(); it != m_PendingReloads.end(); )
+        {
+            if (it->shader.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                ++it;
+                continue;
+            }
+
+            reloaded.emplace_back(it->key, it->shader.get());
+            it = m_PendingReloads.erase(it);
+        }
+    }
+
+    if (reloaded.empty())
+        return;
+
+    std::vector<Ref<GraphicsPipeline>> pipelines;
+    std::unordered_set<GraphicsPipeline *> visited;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (auto &[key, new_shader] : reloaded)
+    {
+        auto entry_it = m_Shaders.find(key);
+        if (entry_it == m_Shaders.end())
+            continue;
+
+        Entry &entry = entry_it->second;
+        if (!new_shader->is_valid())
+        {
+            Logger::get_instance().push_message(LoggingLevel::Error, "[Shader] Reload failed, keeping previous {}",
+                entry.shader->get_filepath().string());
+            continue;
+        }
+
+        if (!same_descriptor_layout(*entry.shader, *new_shader))
+        {
+            Logger::get_instance().push_message(LoggingLevel::Warning, "[Shader] Descriptor layout of {} changed, pipelines keep their old layout",
+                entry.shader->get_filepath().string());
+        }
+
+        const Ref<Shader> old_shader = entry.shader;
+        entry.shader = new_shader;
+
+        std::erase_if(entry.dependents, [](const auto &dependent) { return dependent.expired(); });
+        for (const auto &dependent : entry.dependents)
+        {
+            Ref<GraphicsPipeline> pipeline = dependent.lock();
+            pipeline->replace_shader(old_shader, new_shader);
+            if (visited.insert(pipeline.get()).second)
+                pipelines.push_back(pipeline);
+        }
+    }
+
+    // Each pipeline is rebuilt once, even when several of its shaders changed
+    for (const auto &pipeline : pipelines)
+    {
+        pipeline->rebuild();
+    }
+
+    Logger::get_instance().push_message(LoggingLevel::Info, "[Shader] Hot reload: {} shader(s), {} pipeline(s) rebuilt",
+        reloaded.size(), pipelines.size());
+}
+
+void ShaderLibrary::destroy()
+{
+    // Stop producing reloads before releasing the shaders
+    m_Watcher.reset();
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (auto &pending : m_PendingReloads)
+        pending.shader.wait();
+
+    m_PendingReloads.clear();
+    m_Shaders.clear();
+
+    // Modules were created from the mapping, nothing references it anymore
+    m_Archive.reset();
+}
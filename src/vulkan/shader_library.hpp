@@ -0,0 +1,66 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#ifndef VULKAN_SHADER_LIBRARY_HPP
+#define VULKAN_SHADER_LIBRARY_HPP
+
+#include "shader.hpp"
+
+#include <future>
+#include <memory>
+#include <mutex>
+
+class FileWatcher;
+class GraphicsPipeline;
+class ShaderArchive;
+
+// Owns shaders by source path and stage, tracks which pipelines use them
+// and hot reloads them when their source changes on disk.
+class ShaderLibrary
+{
+public:
+    ShaderLibrary() = default;
+    ~ShaderLibrary();
+
+    Ref<Shader> load(const std::filesystem::path &filepath, VkShaderStageFlagBits stage, const std::vector<ShaderMacro> &macros = {});
+    std::vector<Ref<Shader>> load_batch(const std::vector<ShaderDesc> &descs);
+
+    // The pipeline is rebuilt whenever one of its shaders is reloaded
+    void add_dependent(const Ref<GraphicsPipeline> &pipeline);
+
+    // Shaders found in a mounted archive are created from it instead of being compiled.
+    // Hot reload still recompiles edited sources when the runtime compiler is available.
+    bool mount_archive(const std::filesystem::path &path);
+    const ShaderArchive *get_archive() const { return m_Archive.get(); }
+
+    void enable_hot_reload(const std::filesystem::path &directory);
+
+    // Applies finished recompiles: swaps the shaders and rebuilds the pipelines that use them.
+    // Call on the thread that records command buffers, outside of recording.
+    void update();
+
+    void destroy();
+
+private:
+    struct Entry
+    {
+        Ref<Shader> shader;
+        std::vector<std::weak_ptr<GraphicsPipeline>> dependents;
+    };
+
+    struct PendingReload
+    {
+        std::string key;
+        std::future<Ref<Shader>> shader;
+    };
+
+    static std::string get_key(const std::filesystem::path &filepath, VkShaderStageFlagBits stage, const std::vector<ShaderMacro> &macros);
+    void on_file_changed(const std::filesystem::path &path);
+
+    std::mutex m_Mutex;
+    std::unordered_map<std::string, Entry> m_Shaders;
+    std::vector<PendingReload> m_PendingReloads;
+    Scope<FileWatcher> m_Watcher;
+    Scope<ShaderArchive> m_Archive;
+};
+
+#endif //VULKAN_SHADER_LIBRARY_HPP
@@ -0,0 +1,137 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "shader_permutation.hpp"
+
+#include "core/assert.hpp"
+#include "core/logger.hpp"
+#include "core/thread_pool.hpp"
+
+#include <format>
+#include <unordered_set>
+
+ShaderPermutationSet::ShaderPermutationSet(const std::filesystem::path &filepath, VkShaderStageFlagBits stage, const std::vector<std::string> &keywords,
+    const ShaderArchive *archive)
+    : m_Filepath(filepath), m_Stage(stage), m_Keywords(keywords), m_Archive(archive)
+{
+    ASSERT(m_Keywords.size() <= MAX_KEYWORDS, "[Shader] Too many permutation keywords");
+}
+
+u64 ShaderPermutationSet::get_mask(std::initializer_list<std::string_view> keywords) const
+{
+    u64 mask = 0;
+    for (std::string_view keyword : keywords)
+    {
+        auto it = std::find(m_Keywords.begin(), m_Keywords.end(), keyword);
+        ASSERT(it != m_Keywords.end(), std::format("[Shader] Unknown permutation keyword {}", keyword));
+        if (it != m_Keywords.end())
+            mask |= 1ull << static_cast<u64>(it - m_Keywords.begin());
+    }
+    return mask;
+}
+
+u64 ShaderPermutationSet::get_valid_mask() const
+{
+    return m_Keywords.size() == MAX_KEYWORDS ? ~0ull : (1ull << m_Keywords.size()) - 1;
+}
+
+std::vector<ShaderMacro> ShaderPermutationSet::get_macros(u64 mask) const
+{
+    std::vector<ShaderMacro> macros;
+    for (size_t i = 0; i < m_Keywords.size(); ++i)
+    {
+        if (mask & (1ull << i))
+            macros.push_back({ m_Keywords[i], "1" });
+    }
+    return macros;
+}
+
+Ref<Shader> ShaderPermutationSet::insert_variant(u64 mask, const Ref<Shader> &shader)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto variant = m_Variants.find(mask);
+    if (variant != m_Variants.end())
+        return variant->second;
+
+    // Keywords a stage never tests produce identical SPIR-V, those masks share one module
+    Ref<Shader> result = shader;
+    if (shader->is_valid())
+    {
+        auto [unique, inserted] = m_UniqueShaders.try_emplace(shader->get_spirv_hash(), shader);
+        result = unique->second;
+    }
+
+    m_Variants[mask] = result;
+    return result;
+}
+
+Ref<Shader> ShaderPermutationSet::get_variant(u64 mask)
+{
+    ASSERT((mask & ~get_valid_mask()) == 0, "[Shader] Permutation mask has bits without a keyword");
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Variants.find(mask);
+        if (it != m_Variants.end())
+            return it->second;
+    }
+
+    const std::vector<Ref<Shader>> shaders = Shader::create_batch({ { m_Filepath, m_Stage, get_macros(mask) } }, nullptr, m_Archive);
+    return insert_variant(mask, shaders.front());
+}
+
+void ShaderPermutationSet::compile(const std::vector<u64> &masks, ThreadPool *thread_pool)
+{
+    std::vector<u64> missing;
+    std::unordered_set<u64> queued;
+    std::vector<ShaderDesc> descs;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (u64 mask : masks)
+        {
+            ASSERT((mask & ~get_valid_mask()) == 0, "[Shader] Permutation mask has bits without a keyword");
+            if (m_Variants.contains(mask) || !queued.insert(mask).second)
+                continue;
+
+            missing.push_back(mask);
+            descs.push_back({ m_Filepath, m_Stage, get_macros(mask) });
+        }
+    }
+
+    if (descs.empty())
+        return;
+
+    const std::vector<Ref<Shader>> shaders = Shader::create_batch(descs, thread_pool, m_Archive);
+    for (size_t i = 0; i < shaders.size(); ++i)
+        insert_variant(missing[i], shaders[i]);
+
+    Logger::get_instance().push_message(LoggingLevel::Info, "[Shader] {}: {} variant(s) compiled, {} unique module(s)",
+        m_Filepath.generic_string(), descs.size(), get_unique_variant_count());
+}
+
+void ShaderPermutationSet::compile_all(ThreadPool *thread_pool)
+{
+    ASSERT(m_Keywords.size() <= 16, "[Shader] Too many keywords to compile every permutation");
+
+    std::vector<u64> masks(1ull << m_Keywords.size());
+    for (u64 mask = 0; mask < masks.size(); ++mask)
+        masks[mask] = mask;
+    compile(masks, thread_pool);
+}
+
+size_t ShaderPermutationSet::get_variant_count() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Variants.size();
+}
+
+size_t ShaderPermutationSet::get_unique_variant_count() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_UniqueShaders.size();
+}
+
+Ref<ShaderPermutationSet> ShaderPermutationSet::create(const std::filesystem::path &filepath, VkShaderStageFlagBits stage, const std::vector<std::string> &keywords,
+    const ShaderArchive *archive)
+{
+    return CreateRef<ShaderPermutationSet>(filepath, stage, keywords, archive);
+}
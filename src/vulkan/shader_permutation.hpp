@@ -0,0 +1,63 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#ifndef VULKAN_SHADER_PERMUTATION_HPP
+#define VULKAN_SHADER_PERMUTATION_HPP
+
+#include "shader.hpp"
+
+#include <mutex>
+#include <string_view>
+#include <initializer_list>
+
+class ThreadPool;
+class ShaderArchive;
+
+// One GLSL source compiled into variants selected by keyword bitmask.
+// Bit i of a mask defines keywords[i] as 1, cleared bits leave the keyword undefined,
+// so shaders test them with #ifdef and dead paths are compiled out of each variant.
+class ShaderPermutationSet
+{
+public:
+    static constexpr u32 MAX_KEYWORDS = 64;
+
+    // Variants present in the archive are taken from it, the rest are compiled
+    ShaderPermutationSet(const std::filesystem::path &filepath, VkShaderStageFlagBits stage, const std::vector<std::string> &keywords,
+        const ShaderArchive *archive = nullptr);
+
+    // Mask with the bits of the given keywords set, unknown keywords assert
+    u64 get_mask(std::initializer_list<std::string_view> keywords) const;
+
+    // Compiles the variant on first use and blocks until it exists
+    Ref<Shader> get_variant(u64 mask);
+
+    // Compiles every missing variant of masks concurrently
+    void compile(const std::vector<u64> &masks, ThreadPool *thread_pool = nullptr);
+
+    // Compiles all 2^n keyword combinations, only sensible for a handful of keywords
+    void compile_all(ThreadPool *thread_pool = nullptr);
+
+    std::vector<ShaderMacro> get_macros(u64 mask) const;
+    const std::vector<std::string> &get_keywords() const { return m_Keywords; }
+
+    // Masks requested so far, and how many distinct modules back them
+    size_t get_variant_count() const;
+    size_t get_unique_variant_count() const;
+
+    static Ref<ShaderPermutationSet> create(const std::filesystem::path &filepath, VkShaderStageFlagBits stage, const std::vector<std::string> &keywords,
+        const ShaderArchive *archive = nullptr);
+
+private:
+    u64 get_valid_mask() const;
+    Ref<Shader> insert_variant(u64 mask, const Ref<Shader> &shader);
+
+    std::filesystem::path m_Filepath;
+    VkShaderStageFlagBits m_Stage;
+    std::vector<std::string> m_Keywords;
+    const ShaderArchive *m_Archive = nullptr;
+
+    mutable std::mutex m_Mutex;
+    std::unordered_map<u64, Ref<Shader>> m_Variants; // by keyword mask
+    std::unordered_map<u64, Ref<Shader>> m_UniqueShaders; // by SPIR-V hash
+};
+
+#endif //VULKAN_SHADER_PERMUTATION_HPP
@@ -0,0 +1,235 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "shader_reflection.hpp"
+
+#include "vulkan_format.hpp"
+
+#include "core/binary_io.hpp"
+#include "core/logger.hpp"
+
+#include <charconv>
+#include <sstream>
+
+static bool parse_u32(const std::string &token, u32 &value)
+{
+    const auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+    return ec == std::errc() && ptr == token.data() + token.size();
+}
+
+static VertexInputOverride &get_override(std::vector<VertexInputOverride> &overrides, u32 location)
+{
+    for (VertexInputOverride &o : overrides)
+    {
+        if (o.location == location)
+            return o;
+    }
+    VertexInputOverride &o = overrides.emplace_back();
+    o.location = location;
+    return o;
+}
+
+std::vector<VertexInputOverride> parse_vertex_input_annotations(const std::string &source)
+{
+    std::vector<VertexInputOverride> overrides;
+    std::istringstream stream(source);
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        std::istringstream tokens(line);
+        std::string directive, pragma, location_token;
+        tokens >> directive >> pragma >> location_token;
+        if (directive != "#pragma" || (pragma != "vertex_format" && pragma != "vertex_binding"))
+            continue;
+
+        u32 location = 0;
+        if (!parse_u32(location_token, location))
+        {
+            Logger::get_instance().push_message(LoggingLevel::Warning, "[Shader] Invalid location in '{}'", line);
+            continue;
+        }
+
+        if (pragma == "vertex_format")
+        {
+            std::string name;
+            tokens >> name;
+            const VertexFormatInfo *info = find_vertex_format_info(name);
+            if (!info)
+            {
+                Logger::get_instance().push_message(LoggingLevel::Warning, "[Shader] Unknown vertex format in '{}'", line);
+                continue;
+            }
+            get_override(overrides, location).format = info->format;
+        }
+        else
+        {
+            std::string binding_token, rate;
+            tokens >> binding_token >> rate;
+            u32 binding = 0;
+            if (!parse_u32(binding_token, binding) || (!rate.empty() && rate != "instance" && rate != "vertex"))
+            {
+                Logger::get_instance().push_message(LoggingLevel::Warning, "[Shader] Invalid vertex binding in '{}'", line);
+                continue;
+            }
+            VertexInputOverride &o = get_override(overrides, location);
+            o.binding = static_cast<i32>(binding);
+            o.input_rate = rate == "instance" ? VK_VERTEX_INPUT_RATE_INSTANCE : VK_VERTEX_INPUT_RATE_VERTEX;
+        }
+    }
+    return overrides;
+}
+
+bool ShaderReflection::apply_vertex_input_overrides(const std::vector<VertexInputOverride> &overrides)
+{
+    bool all_applied = true;
+
+    // Rates of bindings no override mentions carry over
+    std::unordered_map<u32, VkVertexInputRate> input_rates;
+    for (const VkVertexInputBindingDescription &binding : vertex_bindings)
+        input_rates[binding.binding] = binding.inputRate;
+
+    for (const VertexInputOverride &o : overrides)
+    {
+        auto it = std::find_if(vertex_attributes.begin(), vertex_attributes.end(),
+            [&](const VkVertexInputAttributeDescription &attr) { return attr.location == o.location; });
+        if (it == vertex_attributes.end())
+        {
+            Logger::get_instance().push_message(LoggingLevel::Warning, "[Shader] Vertex override for unused location {}", o.location);
+            all_applied = false;
+            continue;
+        }
+
+        if (o.format != VK_FORMAT_UNDEFINED)
+        {
+            // The storage format may be narrower than the input, but has to convert to the same numeric type
+            const VertexFormatInfo *current = find_vertex_format_info(it->format);
+            const VertexFormatInfo *requested = find_vertex_format_info(o.format);
+            if (current && requested && current->type == requested->type)
+                it->format = o.format;
+            else
+            {
+                Logger::get_instance().push_message(LoggingLevel::Warning, "[Shader] Vertex format {} does not match the input at location {}",
+                    requested ? requested->name : std::string_view("?"), o.location);
+                all_applied = false;
+            }
+        }
+
+        if (o.binding >= 0)
+        {
+            it->binding = static_cast<u32>(o.binding);
+            input_rates[it->binding] = o.input_rate;
+        }
+    }
+
+    // Attributes keep location order within their binding, each binding is packed from offset 0
+    std::sort(vertex_attributes.begin(), vertex_attributes.end(), [](const VkVertexInputAttributeDescription &a, const VkVertexInputAttributeDescription &b)
+    {
+        return a.binding != b.binding ? a.binding < b.binding : a.location < b.location;
+    });
+
+    vertex_bindings.clear();
+    for (VkVertexInputAttributeDescription &attr : vertex_attributes)
+    {
+        if (vertex_bindings.empty() || vertex_bindings.back().binding != attr.binding)
+        {
+            auto rate = input_rates.find(attr.binding);
+            vertex_bindings.push_back({ attr.binding, 0, rate != input_rates.end() ? rate->second : VK_VERTEX_INPUT_RATE_VERTEX });
+        }
+
+        // Keep components naturally aligned, packed formats are one 32-bit word
+        VkVertexInputBindingDescription &binding = vertex_bindings.back();
+        const u32 size = vk_format_size(attr.format);
+        const u32 alignment = std::clamp(size, 1u, 4u);
+        attr.offset = (binding.stride + alignment - 1) / alignment * alignment;
+        binding.stride = attr.offset + size;
+    }
+
+    vertex_stride = 0;
+    for (VkVertexInputBindingDescription &binding : vertex_bindings)
+    {
+        binding.stride = (binding.stride + 3) & ~3u;
+        if (binding.binding == 0)
+            vertex_stride = binding.stride;
+    }
+    return all_applied;
+}
+
+void ShaderReflection::serialize(BinaryWriter &writer) const
+{
+    // Sets are written in ascending order so equal reflections produce equal files
+    std::vector<u32> sets;
+    sets.reserve(set_bindings.size());
+    for (const auto &[set, bindings] : set_bindings)
+        sets.push_back(set);
+    std::sort(sets.begin(), sets.end());
+
+    writer.write(static_cast<u32>(sets.size()));
+    for (const u32 set : sets)
+    {
+        const auto &bindings = set_bindings.at(set);
+        writer.write(set);
+        writer.write(static_cast<u32>(bindings.size()));
+        for (const auto &b : bindings)
+        {
+            writer.write(b.binding);
+            writer.write(b.descriptorType);
+            writer.write(b.descriptorCount);
+            writer.write(b.stageFlags);
+        }
+    }
+
+    writer.write_vector(push_constant_ranges);
+    writer.write_vector(vertex_attributes);
+    writer.write_vector(vertex_bindings);
+    writer.write(vertex_stride);
+
+    writer.write(static_cast<u32>(specialization_constants.size()));
+    for (const auto &constant : specialization_constants)
+    {
+        writer.write(constant.constant_id);
+        writer.write(constant.size);
+        writer.write_string(constant.name);
+    }
+
+    writer.write(local_size);
+}
+
+bool ShaderReflection::deserialize(BinaryReader &reader)
+{
+    set_bindings.clear();
+    const u32 set_count = reader.read<u32>();
+    for (u32 i = 0; i < set_count && reader.is_valid(); ++i)
+    {
+        const u32 set = reader.read<u32>();
+        const u32 binding_count = reader.read<u32>();
+        auto &bindings = set_bindings[set];
+        for (u32 j = 0; j < binding_count && reader.is_valid(); ++j)
+        {
+            VkDescriptorSetLayoutBinding b {};
+            b.binding = reader.read<u32>();
+            b.descriptorType = reader.read<VkDescriptorType>();
+            b.descriptorCount = reader.read<u32>();
+            b.stageFlags = reader.read<VkShaderStageFlags>();
+            b.pImmutableSamplers = nullptr;
+            bindings.push_back(b);
+        }
+    }
+
+    push_constant_ranges = reader.read_vector<VkPushConstantRange>();
+    vertex_attributes = reader.read_vector<VkVertexInputAttributeDescription>();
+    vertex_bindings = reader.read_vector<VkVertexInputBindingDescription>();
+    vertex_stride = reader.read<u32>();
+
+    specialization_constants.clear();
+    const u32 constant_count = reader.read<u32>();
+    for (u32 i = 0; i < constant_count && reader.is_valid(); ++i)
+    {
+        ShaderSpecializationConstant constant {};
+        constant.constant_id = reader.read<u32>();
+        constant.size = reader.read<u32>();
+        constant.name = reader.read_string();
+        specialization_constants.push_back(std::move(constant));
+    }
+
+    local_size = reader.read<std::array<u32, 3>>();
+    return reader.is_valid();
+}
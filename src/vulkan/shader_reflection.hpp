@@ -0,0 +1,90 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#ifndef VULKAN_SHADER_REFLECTION_HPP
+#define VULKAN_SHADER_REFLECTION_HPP
+
+#include "core/types.hpp"
+#include "core/hash.hpp"
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+class BinaryWriter;
+class BinaryReader;
+
+struct ShaderSpecializationConstant
+{
+    u32 constant_id = 0;
+    u32 size = 0; // bytes, booleans are VkBool32
+    std::string name;
+};
+
+// Storage of one vertex input when it differs from the 32-bit default the shader declares.
+// Shaders annotate their inputs with
+//   #pragma vertex_format <location> <FORMAT>              e.g. R16G16B16A16_SFLOAT, A2B10G10R10_SNORM
+//   #pragma vertex_binding <location> <binding> [instance]
+// and pipelines can apply further overrides on top of the reflected layout.
+struct VertexInputOverride
+{
+    u32 location = 0;
+    VkFormat format = VK_FORMAT_UNDEFINED; // undefined keeps the current format
+    i32 binding = -1; // negative keeps the current binding
+    VkVertexInputRate input_rate = VK_VERTEX_INPUT_RATE_VERTEX; // applies to the whole binding
+};
+
+// Everything the pipelines need from SPIRV-Cross, cached next to the SPIR-V
+// and stored in shader archives so loading never has to reflect again
+struct ShaderReflection
+{
+    std::unordered_map<u32, std::vector<VkDescriptorSetLayoutBinding>> set_bindings;
+    std::vector<VkPushConstantRange> push_constant_ranges;
+    std::vector<VkVertexInputAttributeDescription> vertex_attributes;
+    std::vector<VkVertexInputBindingDescription> vertex_bindings; // sorted by binding
+    u32 vertex_stride = 0; // stride of binding 0
+    std::vector<ShaderSpecializationConstant> specialization_constants;
+    std::array<u32, 3> local_size = { 1, 1, 1 };
+
+    // Changes formats and bindings of the given locations, then recomputes offsets and strides.
+    // Overrides the shader cannot read (e.g. a float format for an ivec input) are ignored, returns false if any was.
+    bool apply_vertex_input_overrides(const std::vector<VertexInputOverride> &overrides);
+
+    void serialize(BinaryWriter &writer) const;
+    bool deserialize(BinaryReader &reader);
+};
+
+// Preprocessor definition passed to the compiler, an empty value defines the name without a value
+struct ShaderMacro
+{
+    std::string name;
+    std::string value;
+};
+
+// Collects the #pragma vertex_format and vertex_binding annotations of a preprocessed source
+std::vector<VertexInputOverride> parse_vertex_input_annotations(const std::string &source);
+
+// Independent of declaration order, so equal macro sets share cache entries
+static u64 hash_shader_macros(const std::vector<ShaderMacro> &macros)
+{
+    std::vector<const ShaderMacro *> sorted;
+    sorted.reserve(macros.size());
+    for (const ShaderMacro &macro : macros)
+        sorted.push_back(&macro);
+    std::sort(sorted.begin(), sorted.end(), [](const ShaderMacro *a, const ShaderMacro *b) { return a->name < b->name; });
+
+    u64 hash = HASH_FNV_OFFSET_BASIS;
+    for (const ShaderMacro *macro : sorted)
+    {
+        hash = hash_string(macro->name, hash);
+        hash_combine(hash, '=');
+        hash = hash_string(macro->value, hash);
+        hash_combine(hash, ';');
+    }
+    return hash;
+}
+
+#endif //VULKAN_SHADER_REFLECTION_HPP
@@ -9,6 +9,7 @@
 #include "core/assert.hpp"
 #include "core/logger.hpp"
 #include "vulkan_wrapper.hpp"
+#include "pipeline_library.hpp"
 
 #include "core/window.hpp"
 
@@ -47,6 +48,11 @@ VulkanContext::VulkanContext(Window *window)
     m_Queue = VulkanQueue(m_QueueFamily, 0);
     create_descriptor_pool();
 
+    if (m_GraphicsPipelineLibrarySupported)
+    {
+        m_PipelineLibrary = new PipelineLibrary();
+    }
+
     create_framebuffers();
 }
 
@@ -54,11 +60,22 @@ void VulkanContext::destroy()
 {
     Logger::get_instance().push_message("=== Destroying Vulkan ===");
     m_Queue.wait_idle();
+    flush_deferred_destroys();
+
+    if (m_PipelineLibrary)
+    {
+        m_PipelineLibrary->destroy();
+        delete m_PipelineLibrary;
+        m_PipelineLibrary = nullptr;
+    }
+
     destroy_framebuffers();
     reset_command_pool();
     vkDestroyRenderPass(m_Device, m_RenderPass, VK_NULL_HANDLE);
     vkDestroyDescriptorPool(m_Device, m_DescriptorPool, VK_NULL_HANDLE);
     vkDestroyCommandPool(m_Device, m_CommandPool, VK_NULL_HANDLE);
+    vkDestroyCommandPool(m_Device, m_ImmediateCommandPool, VK_NULL_HANDLE);
+    vkDestroyFence(m_Device, m_ImmediateFence, VK_NULL_HANDLE);
 
     m_Queue.destroy();
     m_SwapChain.destroy();
@@ -138,9 +155,37 @@ VkResult VulkanContext::reset_command_buffer(VkCommandBuffer command_buffer)
 
 void VulkanContext::submit(const std::vector<VkCommandBuffer> &command_buffers)
 {
+    std::lock_guard<std::mutex> lock(m_QueueMutex);
     m_Queue.submit_async(command_buffers);
 }
 
+void VulkanContext::immediate_submit(const std::function<void(VkCommandBuffer command_buffer)> &record)
+{
+    std::lock_guard<std::mutex> lock(m_ImmediateMutex);
+
+    VK_ERROR_CHECK(vkResetCommandBuffer(m_ImmediateCommandBuffer, 0), "[Vulkan] Failed to reset immediate command buffer");
+
+    VkCommandBufferBeginInfo begin_info = {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_ERROR_CHECK(vkBeginCommandBuffer(m_ImmediateCommandBuffer, &begin_info), "[Vulkan] Failed to begin immediate command buffer");
+    record(m_ImmediateCommandBuffer);
+    VK_ERROR_CHECK(vkEndCommandBuffer(m_ImmediateCommandBuffer), "[Vulkan] Failed to end immediate command buffer");
+
+    VkSubmitInfo submit_info = {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &m_ImmediateCommandBuffer;
+
+    {
+        std::lock_guard<std::mutex> queue_lock(m_QueueMutex);
+        VK_ERROR_CHECK(vkQueueSubmit(m_Queue.get_handle(), 1, &submit_info, m_ImmediateFence), "[Vulkan] Failed to submit immediate commands");
+    }
+
+    VK_ERROR_CHECK(vkWaitForFences(m_Device, 1, &m_ImmediateFence, VK_TRUE, UINT64_MAX), "[Vulkan] Failed to wait for immediate commands");
+    VK_ERROR_CHECK(vkResetFences(m_Device, 1, &m_ImmediateFence), "[Vulkan] Failed to reset immediate fence");
+}
+
 uint32_t VulkanContext::get_current_image_index()
 {
     return m_ImageIndex;
@@ -196,6 +241,29 @@ VulkanSwapchain* VulkanContext::get_swap_chain()
     return &m_SwapChain;
 }
 
+PipelineLibrary *VulkanContext::get_pipeline_library() const
+{
+    return m_PipelineLibrary;
+}
+
+void VulkanContext::defer_destroy(std::function<void()> &&func)
+{
+    std::lock_guard<std::mutex> lock(m_DeferredDestroyMutex);
+    m_DeferredDestroys.push_back(std::move(func));
+}
+
+void VulkanContext::flush_deferred_destroys()
+{
+    std::vector<std::function<void()>> destroys;
+    {
+        std::lock_guard<std::mutex> lock(m_DeferredDestroyMutex);
+        destroys.swap(m_DeferredDestroys);
+    }
+
+    for (auto &destroy_func : destroys)
+        destroy_func();
+}
+
 VulkanContext *VulkanContext::get()
 {
     return s_Instance;
@@ -219,7 +287,16 @@ void VulkanContext::create_instance()
     app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     app_info.pEngineName        = "Vulkan Engine";
     app_info.engineVersion      = VK_MAKE_VERSION(1, 0, 0);
-    app_info.apiVersion         = VK_MAKE_VERSION(1, 0, 0);
+
+    // Ask for the newest version the loader provides, up to the one the engine is written against.
+    // A 1.0 loader has no vkEnumerateInstanceVersion.
+    m_InstanceApiVersion = VK_API_VERSION_1_0;
+    const auto enumerate_instance_version = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(
+        vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion"));
+    if (enumerate_instance_version)
+        enumerate_instance_version(&m_InstanceApiVersion);
+    app_info.apiVersion         = std::min<uint32_t>(m_InstanceApiVersion, VK_API_VERSION_1_3);
+    m_InstanceApiVersion = app_info.apiVersion;
 
     uint32_t property_count = 0;
     vkEnumerateInstanceExtensionProperties(nullptr, &property_count, nullptr);
@@ -325,7 +402,44 @@ void VulkanContext::create_device()
         .pQueuePriorities = queue_priorities,
     };
 
-    const char *device_extensions[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_KHR_SHADER_DRAW_PARAMETERS_EXTENSION_NAME };
+    std::vector<const char *> device_extensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_KHR_SHADER_DRAW_PARAMETERS_EXTENSION_NAME };
+
+    // Features past 1.0 are only queried and enabled when the device and instance both reach the
+    // version or extension that defines them, everything else stays off
+    const uint32_t api_version = std::min(m_InstanceApiVersion, m_PhysicalDevice.get_selected_device().properties.apiVersion);
+    const bool has_vk11 = api_version >= VK_API_VERSION_1_1;
+    const bool has_vk12 = api_version >= VK_API_VERSION_1_2;
+    const bool has_gpl_extensions = has_vk11
+        && m_PhysicalDevice.is_extension_supported(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME)
+        && m_PhysicalDevice.is_extension_supported(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+
+    // Optional features
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT supported_gpl_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+    };
+    VkPhysicalDeviceVulkan12Features supported_vk12_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = has_gpl_extensions ? &supported_gpl_features : VK_NULL_HANDLE,
+    };
+    VkPhysicalDeviceFeatures2 supported_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .features = m_PhysicalDevice.get_selected_device().features,
+    };
+    if (has_vk11)
+    {
+        supported_features.pNext = has_vk12 ? static_cast<void *>(&supported_vk12_features)
+            : has_gpl_extensions ? static_cast<void *>(&supported_gpl_features) : VK_NULL_HANDLE;
+        vkGetPhysicalDeviceFeatures2(m_PhysicalDevice.get_selected_device().device, &supported_features);
+    }
+
+    m_GraphicsPipelineLibrarySupported = has_gpl_extensions && supported_gpl_features.graphicsPipelineLibrary;
+
+    if (m_GraphicsPipelineLibrarySupported)
+    {
+        device_extensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+        device_extensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+        Logger::get_instance().push_message("[Vulkan] Graphics pipeline library enabled");
+    }
 
     if (m_PhysicalDevice.get_selected_device().features.geometryShader == VK_FALSE)
         Logger::get_instance().push_message("[Vulkan] Geometry shader is not supported", LoggingLevel::Error);
@@ -333,21 +447,71 @@ void VulkanContext::create_device()
     if (m_PhysicalDevice.get_selected_device().features.tessellationShader == VK_FALSE)
         Logger::get_instance().push_message("[Vulkan] Tessellation shader is not supported", LoggingLevel::Error);
 
+    m_DeviceLimits = m_PhysicalDevice.get_selected_device().properties.limits;
+
+    // Indirect draws fall back to one call per draw without these
+    m_MultiDrawIndirectSupported = supported_features.features.multiDrawIndirect && supported_features.features.drawIndirectFirstInstance;
+    m_DrawIndirectCountSupported = has_vk12 && supported_vk12_features.drawIndirectCount;
+
+    if (!m_MultiDrawIndirectSupported)
+        Logger::get_instance().push_message("[Vulkan] Multi draw indirect is not supported", LoggingLevel::Warning);
+
+    if (!m_DrawIndirectCountSupported)
+        Logger::get_instance().push_message("[Vulkan] Draw indirect count is not supported", LoggingLevel::Warning);
+
+    // Compute shaders that aggregate atomics per subgroup need ballots in the compute stage
+    VkPhysicalDeviceSubgroupProperties subgroup_properties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES,
+    };
+    VkPhysicalDeviceProperties2 device_properties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &subgroup_properties,
+    };
+    if (has_vk11)
+        vkGetPhysicalDeviceProperties2(m_PhysicalDevice.get_selected_device().device, &device_properties);
+    constexpr VkSubgroupFeatureFlags ballot_operations = VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_BALLOT_BIT;
+    m_ComputeSubgroupBallotSupported = (subgroup_properties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT)
+        && (subgroup_properties.supportedOperations & ballot_operations) == ballot_operations;
+
+    if (!m_ComputeSubgroupBallotSupported)
+        Logger::get_instance().push_message("[Vulkan] Subgroup ballot in compute shaders is not supported", LoggingLevel::Warning);
+
     VkPhysicalDeviceFeatures device_features = { 0 };
     device_features.geometryShader = VK_TRUE;
     device_features.tessellationShader = VK_TRUE;
+    device_features.multiDrawIndirect = m_MultiDrawIndirectSupported;
+    device_features.drawIndirectFirstInstance = m_MultiDrawIndirectSupported;
+
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT gpl_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+        .pNext = VK_NULL_HANDLE,
+        .graphicsPipelineLibrary = VK_TRUE,
+    };
+
+    VkPhysicalDeviceVulkan12Features vk12_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = m_GraphicsPipelineLibrarySupported ? &gpl_features : VK_NULL_HANDLE,
+        .drawIndirectCount = m_DrawIndirectCountSupported,
+    };
+
+    // The 1.2 structure is only valid in the chain of a 1.2 device
+    VkPhysicalDeviceFeatures2 enabled_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = has_vk12 ? static_cast<void *>(&vk12_features) : vk12_features.pNext,
+        .features = device_features,
+    };
 
     VkDeviceCreateInfo create_info = {};
     create_info.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     create_info.flags                   = 0;
     create_info.queueCreateInfoCount    = 1;
     create_info.pQueueCreateInfos       = &queue_create_info;
-    create_info.pNext                   = VK_NULL_HANDLE;
+    create_info.pNext                   = has_vk11 ? &enabled_features : VK_NULL_HANDLE;
     create_info.enabledLayerCount       = 0;
     create_info.ppEnabledLayerNames     = VK_NULL_HANDLE;
-    create_info.enabledExtensionCount   = std::size(device_extensions);
-    create_info.ppEnabledExtensionNames = device_extensions;
-    create_info.pEnabledFeatures        = &device_features;
+    create_info.enabledExtensionCount   = static_cast<u32>(device_extensions.size());
+    create_info.ppEnabledExtensionNames = device_extensions.data();
+    create_info.pEnabledFeatures        = has_vk11 ? VK_NULL_HANDLE : &device_features;
 
     const VkResult result = vkCreateDevice(m_PhysicalDevice.get_selected_device().device, &create_info, VK_NULL_HANDLE, &m_Device);
     VK_ERROR_CHECK(result, "[Vulkan] Failed to create logical device");
@@ -395,6 +559,23 @@ void VulkanContext::create_command_pool()
     VK_ERROR_CHECK(vkCreateCommandPool(m_Device, &pool_create_info, VK_NULL_HANDLE, &m_CommandPool),
         "[Vulkan] Failed to create command pool");
 
+    // Separate pool for immediate_submit, which may run on another thread than the frame
+    VK_ERROR_CHECK(vkCreateCommandPool(m_Device, &pool_create_info, VK_NULL_HANDLE, &m_ImmediateCommandPool),
+        "[Vulkan] Failed to create immediate command pool");
+
+    VkCommandBufferAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    alloc_info.commandPool = m_ImmediateCommandPool;
+    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    alloc_info.commandBufferCount = 1;
+    VK_ERROR_CHECK(vkAllocateCommandBuffers(m_Device, &alloc_info, &m_ImmediateCommandBuffer),
+        "[Vulkan] Failed to allocate immediate command buffer");
+
+    VkFenceCreateInfo fence_info = {};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    VK_ERROR_CHECK(vkCreateFence(m_Device, &fence_info, VK_NULL_HANDLE, &m_ImmediateFence),
+        "[Vulkan] Failed to create immediate fence");
+
     Logger::get_instance().push_message("[Vulkan] Command buffer created");
 }
 
@@ -475,7 +656,12 @@ std::optional<uint32_t> VulkanContext::begin_frame()
         return std::nullopt;
     }
 
-    m_Queue.wait_idle();
+    {
+        std::lock_guard<std::mutex> lock(m_QueueMutex);
+        m_Queue.wait_idle();
+    }
+    flush_deferred_destroys();
+
     VkResult result = m_SwapChain.acquire_next_image(&m_ImageIndex, m_Queue.get_semaphore());
     if (result == VK_ERROR_OUT_OF_DATE_KHR)
     {
@@ -494,7 +680,11 @@ std::optional<uint32_t> VulkanContext::begin_frame()
 
 void VulkanContext::present()
 {
-    VkResult result = m_Queue.present(m_ImageIndex, m_SwapChain.get_handle());
+    VkResult result;
+    {
+        std::lock_guard<std::mutex> lock(m_QueueMutex);
+        result = m_Queue.present(m_ImageIndex, m_SwapChain.get_handle());
+    }
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
     {
         recreate_swap_chain();
@@ -6,6 +6,8 @@
 #include <unordered_map>
 #include <optional>
 #include <vector>
+#include <functional>
+#include <mutex>
 
 #include <vulkan/vulkan.h>
 
@@ -16,6 +18,7 @@
 #include <glm/glm.hpp>
 
 class Window;
+class PipelineLibrary;
 class VulkanContext {
 public:
     explicit VulkanContext(Window *window);
@@ -35,8 +38,18 @@ public:
 
     VulkanQueue *get_queue();
     VulkanSwapchain *get_swap_chain();
+    PipelineLibrary *get_pipeline_library() const;
     static VulkanContext *get();
 
+    bool is_graphics_pipeline_library_supported() const { return m_GraphicsPipelineLibrarySupported; }
+    bool is_multi_draw_indirect_supported() const { return m_MultiDrawIndirectSupported; }
+    bool is_draw_indirect_count_supported() const { return m_DrawIndirectCountSupported; }
+    bool is_compute_subgroup_ballot_supported() const { return m_ComputeSubgroupBallotSupported; }
+    const VkPhysicalDeviceLimits &get_device_limits() const { return m_DeviceLimits; }
+
+    // Destroys the resource once the GPU can no longer be using it (at the next begin_frame)
+    void defer_destroy(std::function<void()> &&func);
+
     void should_recreate_swapchain();
     
     std::optional<uint32_t> begin_frame();
@@ -57,9 +70,13 @@ public:
 
     VkResult reset_command_buffer(VkCommandBuffer command_buffer);
     void submit(const std::vector<VkCommandBuffer> &command_buffers);
+    // Records with record, submits and blocks until the GPU finished. For uploads outside
+    // the frame, callable from any thread.
+    void immediate_submit(const std::function<void(VkCommandBuffer command_buffer)> &record);
     uint32_t get_current_image_index();
 private:
     void recreate_swap_chain();
+    void flush_deferred_destroys();
 
     Window* m_Window                   = nullptr;
     VkInstance m_Instance              = VK_NULL_HANDLE;
@@ -67,6 +84,9 @@ private:
 
     VkSurfaceKHR m_Surface             = VK_NULL_HANDLE;
     VkCommandPool m_CommandPool        = VK_NULL_HANDLE;
+    VkCommandPool m_ImmediateCommandPool = VK_NULL_HANDLE;
+    VkCommandBuffer m_ImmediateCommandBuffer = VK_NULL_HANDLE;
+    VkFence m_ImmediateFence           = VK_NULL_HANDLE;
     VkDescriptorPool m_DescriptorPool  = VK_NULL_HANDLE;
     VkRenderPass m_RenderPass          = VK_NULL_HANDLE;
 
@@ -79,6 +99,19 @@ private:
     VkDebugUtilsMessengerEXT m_DebugMessenger = VK_NULL_HANDLE;
     std::vector<VkFramebuffer> m_Framebuffers;
 
+    PipelineLibrary *m_PipelineLibrary = nullptr;
+    uint32_t m_InstanceApiVersion = VK_API_VERSION_1_0; // the version the instance was created with
+    bool m_GraphicsPipelineLibrarySupported = false;
+    bool m_MultiDrawIndirectSupported = false;
+    bool m_DrawIndirectCountSupported = false;
+    bool m_ComputeSubgroupBallotSupported = false;
+    VkPhysicalDeviceLimits m_DeviceLimits = {};
+
+    std::mutex m_DeferredDestroyMutex;
+    std::mutex m_QueueMutex; // queue access is externally synchronized
+    std::mutex m_ImmediateMutex;
+    std::vector<std::function<void()>> m_DeferredDestroys;
+
     bool m_ShouldRecreatingSwapChain = false;
 };
 
@@ -0,0 +1,94 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#ifndef VULKAN_FORMAT_HPP
+#define VULKAN_FORMAT_HPP
+
+#include "core/types.hpp"
+
+#include <string_view>
+
+#include <vulkan/vulkan.h>
+
+// How the shader sees a format: normalized and float formats read as float
+enum class FormatNumericType
+{
+    Undefined,
+    Float,
+    SInt,
+    UInt
+};
+
+struct VertexFormatInfo
+{
+    std::string_view name;
+    VkFormat format;
+    u32 size; // bytes per element
+    u32 components;
+    FormatNumericType type;
+};
+
+// Formats usable as vertex attributes, including the packed ones meshes are stored in
+static constexpr VertexFormatInfo VERTEX_FORMATS[] =
+{
+    { "R32_SFLOAT",               VK_FORMAT_R32_SFLOAT,               4,  1, FormatNumericType::Float },
+    { "R32G32_SFLOAT",            VK_FORMAT_R32G32_SFLOAT,            8,  2, FormatNumericType::Float },
+    { "R32G32B32_SFLOAT",         VK_FORMAT_R32G32B32_SFLOAT,         12, 3, FormatNumericType::Float },
+    { "R32G32B32A32_SFLOAT",      VK_FORMAT_R32G32B32A32_SFLOAT,      16, 4, FormatNumericType::Float },
+    { "R32_SINT",                 VK_FORMAT_R32_SINT,                 4,  1, FormatNumericType::SInt },
+    { "R32G32_SINT",              VK_FORMAT_R32G32_SINT,              8,  2, FormatNumericType::SInt },
+    { "R32G32B32_SINT",           VK_FORMAT_R32G32B32_SINT,           12, 3, FormatNumericType::SInt },
+    { "R32G32B32A32_SINT",        VK_FORMAT_R32G32B32A32_SINT,        16, 4, FormatNumericType::SInt },
+    { "R32_UINT",                 VK_FORMAT_R32_UINT,                 4,  1, FormatNumericType::UInt },
+    { "R32G32_UINT",              VK_FORMAT_R32G32_UINT,              8,  2, FormatNumericType::UInt },
+    { "R32G32B32_UINT",           VK_FORMAT_R32G32B32_UINT,           12, 3, FormatNumericType::UInt },
+    { "R32G32B32A32_UINT",        VK_FORMAT_R32G32B32A32_UINT,        16, 4, FormatNumericType::UInt },
+    { "R16G16_SFLOAT",            VK_FORMAT_R16G16_SFLOAT,            4,  2, FormatNumericType::Float },
+    { "R16G16B16A16_SFLOAT",      VK_FORMAT_R16G16B16A16_SFLOAT,      8,  4, FormatNumericType::Float },
+    { "R16G16_UNORM",             VK_FORMAT_R16G16_UNORM,             4,  2, FormatNumericType::Float },
+    { "R16G16_SNORM",             VK_FORMAT_R16G16_SNORM,             4,  2, FormatNumericType::Float },
+    { "R16G16B16A16_UNORM",       VK_FORMAT_R16G16B16A16_UNORM,       8,  4, FormatNumericType::Float },
+    { "R16G16B16A16_SNORM",       VK_FORMAT_R16G16B16A16_SNORM,       8,  4, FormatNumericType::Float },
+    { "R16G16_UINT",              VK_FORMAT_R16G16_UINT,              4,  2, FormatNumericType::UInt },
+    { "R16G16B16A16_UINT",        VK_FORMAT_R16G16B16A16_UINT,        8,  4, FormatNumericType::UInt },
+    { "R8G8_UNORM",               VK_FORMAT_R8G8_UNORM,               2,  2, FormatNumericType::Float },
+    { "R8G8_SNORM",               VK_FORMAT_R8G8_SNORM,               2,  2, FormatNumericType::Float },
+    { "R8G8B8A8_UNORM",           VK_FORMAT_R8G8B8A8_UNORM,           4,  4, FormatNumericType::Float },
+    { "R8G8B8A8_SNORM",           VK_FORMAT_R8G8B8A8_SNORM,           4,  4, FormatNumericType::Float },
+    { "R8G8B8A8_UINT",            VK_FORMAT_R8G8B8A8_UINT,            4,  4, FormatNumericType::UInt },
+    { "R8G8B8A8_SINT",            VK_FORMAT_R8G8B8A8_SINT,            4,  4, FormatNumericType::SInt },
+    { "A2B10G10R10_UNORM_PACK32", VK_FORMAT_A2B10G10R10_UNORM_PACK32, 4,  4, FormatNumericType::Float },
+    { "A2B10G10R10_SNORM_PACK32", VK_FORMAT_A2B10G10R10_SNORM_PACK32, 4,  4, FormatNumericType::Float },
+};
+
+static const VertexFormatInfo *find_vertex_format_info(VkFormat format)
+{
+    for (const VertexFormatInfo &info : VERTEX_FORMATS)
+    {
+        if (info.format == format)
+            return &info;
+    }
+    return nullptr;
+}
+
+// Accepts the enum name with or without the VK_FORMAT_ prefix, packed formats also without _PACK32
+static const VertexFormatInfo *find_vertex_format_info(std::string_view name)
+{
+    if (name.starts_with("VK_FORMAT_"))
+        name.remove_prefix(10);
+
+    for (const VertexFormatInfo &info : VERTEX_FORMATS)
+    {
+        if (info.name == name || (info.name.ends_with("_PACK32") && info.name.substr(0, info.name.size() - 7) == name))
+            return &info;
+    }
+    return nullptr;
+}
+
+// Size in bytes of one element, 0 for formats that cannot be used as vertex attributes
+static u32 vk_format_size(VkFormat format)
+{
+    const VertexFormatInfo *info = find_vertex_format_info(format);
+    return info ? info->size : 0;
+}
+
+#endif //VULKAN_FORMAT_HPP
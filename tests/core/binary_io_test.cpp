@@ -0,0 +1,96 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "core/binary_io.hpp"
+
+#include "test.hpp"
+
+static void test_round_trip()
+{
+    BinaryWriter writer;
+    writer.write<u32>(0xCAFEF00D);
+    writer.write_string("shader");
+    writer.write_vector(std::vector<u16>{ 1, 2, 3 });
+    writer.align(16);
+    writer.write<u64>(7);
+    CHECK(writer.get_size() == 40);
+
+    BinaryReader reader(writer.get_buffer().data(), writer.get_size());
+    CHECK(reader.read<u32>() == 0xCAFEF00D);
+    CHECK(reader.read_string() == "shader");
+    CHECK((reader.read_vector<u16>() == std::vector<u16>{ 1, 2, 3 }));
+    reader.align(16);
+    CHECK(reader.read<u64>() == 7);
+    CHECK(reader.is_valid() && reader.is_at_end());
+}
+
+static void test_read_past_end()
+{
+    const u8 bytes[6] = { 1, 2, 3, 4, 5, 6 };
+    BinaryReader reader(bytes, sizeof(bytes));
+    CHECK(reader.read<u32>() == 0x04030201);
+    CHECK(reader.read<u32>() == 0); // only two bytes left
+    CHECK(!reader.is_valid());
+
+    // Once failed every read fails, even one that would fit
+    CHECK(reader.read<u8>() == 0);
+    CHECK(reader.skip(0) == nullptr);
+    CHECK(reader.get_offset() == 4);
+}
+
+static void test_lengths_beyond_the_data()
+{
+    // Lengths are checked against what is left before anything is allocated or copied
+    BinaryWriter string_writer;
+    string_writer.write<u32>(100);
+    string_writer.write_bytes("abc", 3);
+    BinaryReader string_reader(string_writer.get_buffer().data(), string_writer.get_size());
+    CHECK(string_reader.read_string().empty());
+    CHECK(!string_reader.is_valid());
+
+    BinaryWriter vector_writer;
+    vector_writer.write<u32>(0xFFFFFFFF);
+    vector_writer.write<u32>(0);
+    BinaryReader vector_reader(vector_writer.get_buffer().data(), vector_writer.get_size());
+    CHECK(vector_reader.read_vector<u64>().empty());
+    CHECK(!vector_reader.is_valid());
+
+    // A count that fits in bytes but not in whole elements
+    BinaryWriter partial_writer;
+    partial_writer.write<u32>(2);
+    partial_writer.write<u32>(0);
+    partial_writer.write<u16>(0);
+    BinaryReader partial_reader(partial_writer.get_buffer().data(), partial_writer.get_size());
+    CHECK(partial_reader.read_vector<u32>().empty());
+    CHECK(!partial_reader.is_valid());
+}
+
+static void test_skip_and_seek()
+{
+    const u8 bytes[8] = {};
+    BinaryReader reader(bytes, sizeof(bytes));
+    CHECK(reader.skip(8) == bytes);
+    CHECK(reader.is_at_end() && reader.is_valid());
+    CHECK(reader.skip(1) == nullptr);
+    CHECK(!reader.is_valid());
+
+    BinaryReader seek_reader(bytes, sizeof(bytes));
+    seek_reader.seek(8);
+    CHECK(seek_reader.is_valid() && seek_reader.is_at_end());
+    seek_reader.seek(9);
+    CHECK(!seek_reader.is_valid());
+
+    // Aligning past the end fails like any other read
+    BinaryReader align_reader(bytes, 6);
+    align_reader.skip(5);
+    align_reader.align(8);
+    CHECK(!align_reader.is_valid());
+}
+
+int main()
+{
+    test_round_trip();
+    test_read_past_end();
+    test_lengths_beyond_the_data();
+    test_skip_and_seek();
+    return test_result();
+}
@@ -0,0 +1,88 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "core/range_allocator.hpp"
+
+#include "test.hpp"
+
+static void test_first_fit()
+{
+    RangeAllocator allocator(100);
+    CHECK(allocator.allocate(10) == 0);
+    CHECK(allocator.allocate(20) == 10);
+    CHECK(allocator.allocate(30) == 30);
+    CHECK(allocator.get_used() == 60);
+
+    // The first hole that fits wins, even when a later one fits tighter
+    allocator.free(0);
+    allocator.free(30);
+    CHECK(allocator.allocate(5) == 0);
+    CHECK(allocator.allocate(8) == 30);
+    CHECK(allocator.allocate(5) == 5);
+}
+
+static void test_coalescing()
+{
+    RangeAllocator allocator(90);
+    const u64 a = allocator.allocate(30);
+    const u64 b = allocator.allocate(30);
+    const u64 c = allocator.allocate(30);
+    CHECK(allocator.get_largest_free_range() == 0);
+
+    // Freeing the middle last merges with both neighbours
+    allocator.free(a);
+    allocator.free(c);
+    CHECK(allocator.get_largest_free_range() == 30);
+    allocator.free(b);
+    CHECK(allocator.get_largest_free_range() == 90);
+    CHECK(allocator.get_used() == 0);
+    CHECK(allocator.allocate(90) == 0);
+}
+
+static void test_alignment()
+{
+    RangeAllocator allocator(64);
+    CHECK(allocator.allocate(3) == 0);
+    const u64 aligned = allocator.allocate(8, 16);
+    CHECK(aligned == 16);
+    CHECK(allocator.get_used() == 24); // the padding belongs to the allocation
+
+    // Freeing returns the padding as well
+    allocator.free(aligned);
+    CHECK(allocator.get_used() == 3);
+    CHECK(allocator.get_largest_free_range() == 61);
+    CHECK(allocator.allocate(61) == 3);
+}
+
+static void test_exhaustion()
+{
+    RangeAllocator allocator(32);
+    CHECK(allocator.allocate(0) == RangeAllocator::INVALID_OFFSET);
+    CHECK(allocator.allocate(33) == RangeAllocator::INVALID_OFFSET);
+    CHECK(allocator.allocate(32) == 0);
+    CHECK(allocator.allocate(1) == RangeAllocator::INVALID_OFFSET);
+
+    // Enough free units in total, but no single range holds them
+    allocator.reset();
+    const u64 a = allocator.allocate(8);
+    allocator.allocate(8);
+    const u64 c = allocator.allocate(8);
+    allocator.allocate(8);
+    allocator.free(a);
+    allocator.free(c);
+    CHECK(allocator.get_capacity() - allocator.get_used() == 16);
+    CHECK(allocator.allocate(16) == RangeAllocator::INVALID_OFFSET);
+    CHECK(allocator.allocate(8) == 0);
+    CHECK(allocator.allocate(8) == 16);
+    CHECK(allocator.allocate(1) == RangeAllocator::INVALID_OFFSET);
+
+    CHECK(RangeAllocator().allocate(1) == RangeAllocator::INVALID_OFFSET);
+}
+
+int main()
+{
+    test_first_fit();
+    test_coalescing();
+    test_alignment();
+    test_exhaustion();
+    return test_result();
+}
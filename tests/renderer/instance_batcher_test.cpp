@@ -0,0 +1,117 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#include "renderer/instance_batcher.hpp"
+
+#include "core/hash.hpp"
+
+#include "test.hpp"
+
+#include <cstring>
+
+// Distinct constants with the same 64-bit FNV-1a hash
+static constexpr u64 COLLIDING_CONSTANTS[2] = { 0xc9d50fcf987edbc1ull, 0x6849f0eac0807b28ull };
+
+static DrawPacket make_draw(u32 first_index)
+{
+    DrawPacket draw;
+    draw.pipeline = 1;
+    draw.material = 2;
+    draw.geometry = 3;
+    draw.index_count = 6;
+    draw.first_index = first_index;
+    return draw;
+}
+
+static std::vector<u32> get_packed_ids(const InstanceBatcher &batcher)
+{
+    std::vector<u32> ids(batcher.get_instance_count());
+    std::memcpy(ids.data(), batcher.get_packed_instances().data(), ids.size() * sizeof(u32));
+    return ids;
+}
+
+static u64 get_constants(const DrawList &draw_list, const DrawPacket &packet)
+{
+    u64 constants = 0;
+    if (packet.constants_size == sizeof(u64))
+        std::memcpy(&constants, draw_list.get_constants().data() + packet.constants_offset, sizeof(u64));
+    return constants;
+}
+
+static void test_grouping_and_packing()
+{
+    InstanceBatcher batcher(sizeof(u32));
+    const DrawPacket a = make_draw(0);
+    const DrawPacket b = make_draw(6);
+    const u64 constants = 7;
+
+    // Interleaved submissions of three batches: a, b, and a with constants
+    batcher.add(a, 0u);
+    batcher.add(b, 1u);
+    batcher.add(a, 2u);
+    batcher.add(a, 3u, constants);
+    batcher.add(b, 4u);
+    batcher.add(a, 5u, constants);
+    CHECK(batcher.get_instance_count() == 6);
+    CHECK(batcher.get_batch_count() == 3);
+
+    DrawList draw_list;
+    batcher.pack(draw_list, 10);
+
+    // Grouped by batch in order of their first submission, each batch keeps its submission order
+    const std::vector<u32> expected_ids = { 0, 2, 1, 4, 3, 5 };
+    CHECK(get_packed_ids(batcher) == expected_ids);
+
+    const std::vector<DrawPacket> &packets = draw_list.get_packets();
+    CHECK(packets.size() == 3);
+    if (packets.size() == 3)
+    {
+        CHECK(packets[0].first_index == 0 && packets[0].instance_count == 2 && packets[0].first_instance == 10);
+        CHECK(packets[1].first_index == 6 && packets[1].instance_count == 2 && packets[1].first_instance == 12);
+        CHECK(packets[2].first_index == 0 && packets[2].instance_count == 2 && packets[2].first_instance == 14);
+        CHECK(packets[0].constants_size == 0 && packets[1].constants_size == 0);
+        CHECK(get_constants(draw_list, packets[2]) == constants);
+    }
+
+    // Reset starts an empty frame
+    batcher.reset();
+    CHECK(batcher.get_instance_count() == 0);
+    CHECK(batcher.get_batch_count() == 0);
+    draw_list.clear();
+    batcher.pack(draw_list);
+    CHECK(draw_list.get_packets().empty());
+}
+
+static void test_hash_collision()
+{
+    CHECK(COLLIDING_CONSTANTS[0] != COLLIDING_CONSTANTS[1]);
+    CHECK(hash_bytes(&COLLIDING_CONSTANTS[0], sizeof(u64)) == hash_bytes(&COLLIDING_CONSTANTS[1], sizeof(u64)));
+
+    // Equal keys whose constants differ are never merged, the collision gets its own batch
+    InstanceBatcher batcher(sizeof(u32));
+    const DrawPacket draw = make_draw(0);
+    batcher.add(draw, 0u, COLLIDING_CONSTANTS[0]);
+    batcher.add(draw, 1u, COLLIDING_CONSTANTS[1]);
+    batcher.add(draw, 2u, COLLIDING_CONSTANTS[0]);
+
+    DrawList draw_list;
+    batcher.pack(draw_list);
+    const std::vector<u32> expected_ids = { 0, 2, 1 };
+    CHECK(get_packed_ids(batcher) == expected_ids);
+
+    const std::vector<DrawPacket> &packets = draw_list.get_packets();
+    CHECK(packets.size() == 2);
+    if (packets.size() == 2)
+    {
+        CHECK(packets[0].instance_count == 2 && packets[0].first_instance == 0);
+        CHECK(get_constants(draw_list, packets[0]) == COLLIDING_CONSTANTS[0]);
+        CHECK(packets[1].instance_count == 1 && packets[1].first_instance == 2);
+        CHECK(get_constants(draw_list, packets[1]) == COLLIDING_CONSTANTS[1]);
+    }
+}
+
+int main()
+{
+    test_grouping_and_packing();
+    test_hash_collision();
+    return test_result();
+}
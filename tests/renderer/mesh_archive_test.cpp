@@ -0,0 +1,118 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "renderer/mesh_archive.hpp"
+
+#include "test.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+static MeshData make_quad()
+{
+    MeshData mesh;
+    mesh.name = "quad";
+    mesh.positions = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } };
+    mesh.colors.assign(4, glm::vec3(1.0f, 0.5f, 0.0f));
+    mesh.indices = { 0, 1, 2, 0, 2, 3 };
+    build_meshlets(mesh);
+    return mesh;
+}
+
+static std::vector<char> read_file(const std::filesystem::path &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void write_file(const std::filesystem::path &path, const std::vector<char> &bytes)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+template<typename T>
+static void patch(std::vector<char> &bytes, size_t offset, const T &value)
+{
+    std::memcpy(bytes.data() + offset, &value, sizeof(T));
+}
+
+static bool opens(const std::filesystem::path &path, const std::vector<char> &bytes)
+{
+    write_file(path, bytes);
+    MeshArchive archive;
+    return archive.open(path);
+}
+
+int main()
+{
+    const std::filesystem::path path = "mesh_archive_test.mesh";
+    const std::filesystem::path broken_path = "mesh_archive_test_broken.mesh";
+
+    MeshArchiveWriter writer;
+    writer.add(make_quad());
+    CHECK(writer.write(path));
+
+    {
+        MeshArchive archive;
+        CHECK(archive.open(path));
+        CHECK(archive.get_mesh_count() == 1);
+        if (archive.get_mesh_count() == 1)
+        {
+            const MeshArchiveEntry &entry = archive.get_entry(0);
+            CHECK(std::string(entry.name) == "quad");
+            CHECK(entry.vertex_count == 4 && entry.index_count == 6 && entry.lod_count == 1);
+            CHECK(archive.get_lods(entry)[0].index_count == 6);
+            CHECK(static_cast<const u16 *>(archive.get_indices(entry))[5] == 3);
+        }
+    }
+
+    const std::vector<char> bytes = read_file(path);
+    CHECK(opens(broken_path, bytes));
+
+    // Every rejected archive has to fail before anything points past the mapping
+    std::vector<char> truncated(bytes.begin(), bytes.end() - 1);
+    CHECK(!opens(broken_path, truncated));
+    CHECK(!opens(broken_path, std::vector<char>(bytes.begin(), bytes.begin() + sizeof(MeshArchiveHeader) - 1)));
+
+    std::vector<char> bad_magic = bytes;
+    patch<u32>(bad_magic, offsetof(MeshArchiveHeader, magic), 0);
+    CHECK(!opens(broken_path, bad_magic));
+
+    std::vector<char> bad_version = bytes;
+    patch<u32>(bad_version, offsetof(MeshArchiveHeader, version), MESH_ARCHIVE_VERSION + 1);
+    CHECK(!opens(broken_path, bad_version));
+
+    std::vector<char> bad_stride = bytes;
+    patch<u32>(bad_stride, offsetof(MeshArchiveHeader, stream_strides), MESH_STREAM_STRIDES[0] + 4);
+    CHECK(!opens(broken_path, bad_stride));
+
+    std::vector<char> too_many_meshes = bytes;
+    patch<u32>(too_many_meshes, offsetof(MeshArchiveHeader, mesh_count), 0x10000000);
+    CHECK(!opens(broken_path, too_many_meshes));
+
+    const size_t entry_offset = sizeof(MeshArchiveHeader);
+    std::vector<char> unterminated_name = bytes;
+    std::memset(unterminated_name.data() + entry_offset, 'x', MESH_ARCHIVE_NAME_SIZE);
+    CHECK(!opens(broken_path, unterminated_name));
+
+    std::vector<char> misaligned_stream = bytes;
+    patch<u64>(misaligned_stream, entry_offset + offsetof(MeshArchiveEntry, stream_offsets), 1);
+    CHECK(!opens(broken_path, misaligned_stream));
+
+    std::vector<char> indices_past_end = bytes;
+    patch<u32>(indices_past_end, entry_offset + offsetof(MeshArchiveEntry, index_count), 0x40000000);
+    CHECK(!opens(broken_path, indices_past_end));
+
+    std::vector<char> lod_past_indices = bytes;
+    u64 lod_offset = 0;
+    std::memcpy(&lod_offset, bytes.data() + entry_offset + offsetof(MeshArchiveEntry, lod_offset), sizeof(u64));
+    patch<u32>(lod_past_indices, lod_offset + offsetof(MeshLod, index_count), 7);
+    CHECK(!opens(broken_path, lod_past_indices));
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    std::filesystem::remove(broken_path, ec);
+    return test_result();
+}
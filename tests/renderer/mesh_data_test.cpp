@@ -0,0 +1,88 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "renderer/mesh_data.hpp"
+
+#include "test.hpp"
+
+#include <set>
+
+// A size x size grid of quads, two triangles each
+static MeshData make_grid(u32 size)
+{
+    MeshData mesh;
+    for (u32 y = 0; y <= size; ++y)
+    {
+        for (u32 x = 0; x <= size; ++x)
+            mesh.positions.emplace_back(static_cast<float>(x), static_cast<float>(y), 0.0f);
+    }
+    mesh.colors.assign(mesh.positions.size(), glm::vec3(1.0f));
+
+    for (u32 y = 0; y < size; ++y)
+    {
+        for (u32 x = 0; x < size; ++x)
+        {
+            const u32 corner = y * (size + 1) + x;
+            mesh.indices.insert(mesh.indices.end(), { corner, corner + 1, corner + size + 2, corner, corner + size + 2, corner + size + 1 });
+        }
+    }
+    return mesh;
+}
+
+// Meshlets of the LOD cover its whole triangles once, in order and within the limits
+static bool covers_lod(const MeshData &mesh, const MeshLod &lod)
+{
+    u32 next_index = lod.first_index;
+    for (u32 i = lod.first_meshlet; i < lod.first_meshlet + lod.meshlet_count; ++i)
+    {
+        const Meshlet &meshlet = mesh.meshlets[i];
+        if (meshlet.first_index != next_index || meshlet.index_count == 0 || meshlet.index_count % 3 != 0
+            || meshlet.index_count / 3 > MESHLET_MAX_TRIANGLES)
+            return false;
+
+        const std::set<u32> vertices(mesh.indices.begin() + meshlet.first_index,
+            mesh.indices.begin() + meshlet.first_index + meshlet.index_count);
+        if (vertices.size() > MESHLET_MAX_VERTICES)
+            return false;
+        next_index += meshlet.index_count;
+    }
+    return next_index == lod.first_index + lod.index_count - lod.index_count % 3;
+}
+
+int main()
+{
+    // Enough triangles for several meshlets
+    {
+        MeshData mesh = make_grid(16);
+        build_meshlets(mesh);
+        CHECK(mesh.lods.size() == 1);
+        CHECK(mesh.lods[0].meshlet_count > 1);
+        CHECK(covers_lod(mesh, mesh.lods[0]));
+    }
+
+    // LODs whose index count is not a multiple of 3 leave the trailing indices out instead of
+    // never finishing
+    {
+        MeshData mesh = make_grid(4);
+        MeshLod lod0;
+        lod0.index_count = 7;
+        MeshLod lod1;
+        lod1.first_index = 12;
+        lod1.index_count = 2;
+        mesh.lods = { lod0, lod1 };
+        build_meshlets(mesh);
+        CHECK(mesh.lods[0].meshlet_count == 1);
+        CHECK(covers_lod(mesh, mesh.lods[0]));
+        CHECK(mesh.lods[1].meshlet_count == 0);
+        CHECK(mesh.lods[1].first_meshlet == mesh.lods[0].meshlet_count);
+    }
+
+    // No indices, no meshlets
+    {
+        MeshData mesh;
+        build_meshlets(mesh);
+        CHECK(mesh.lods.size() == 1);
+        CHECK(mesh.meshlets.empty());
+    }
+
+    return test_result();
+}
@@ -0,0 +1,218 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "renderer/mesh_data.hpp"
+#include "renderer/mesh_importer.hpp"
+
+#include "test.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+static void write_file(const std::filesystem::path &path, const void *data, size_t size)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+}
+
+static bool near(const glm::vec3 &a, const glm::vec3 &b)
+{
+    return std::abs(a.x - b.x) < 1e-6f && std::abs(a.y - b.y) < 1e-6f && std::abs(a.z - b.z) < 1e-6f;
+}
+
+// Has room for a few mapped ranges between flushes, like staging memory that fills up
+class LimitedImportSink : public MeshDataImportSink
+{
+public:
+    explicit LimitedImportSink(u32 room) : m_Room(room) {}
+
+    void *map_vertices(u32 mesh, u32 stream, u32 first, u32 count) override
+    {
+        return take_room() ? MeshDataImportSink::map_vertices(mesh, stream, first, count) : nullptr;
+    }
+
+    void *map_indices(u32 mesh, u32 first, u32 count) override
+    {
+        return take_room() ? MeshDataImportSink::map_indices(mesh, first, count) : nullptr;
+    }
+
+    void flush() override
+    {
+        m_Mapped = 0;
+        ++m_FlushCount;
+    }
+
+    u32 get_refusal_count() const { return m_RefusalCount; }
+    u32 get_flush_count() const { return m_FlushCount; }
+
+private:
+    bool take_room()
+    {
+        if (m_Mapped == m_Room)
+        {
+            ++m_RefusalCount;
+            return false;
+        }
+        ++m_Mapped;
+        return true;
+    }
+
+    u32 m_Room;
+    u32 m_Mapped = 0;
+    u32 m_RefusalCount = 0;
+    u32 m_FlushCount = 0;
+};
+
+// Four vertices in one chunk, faces in the next that reach back with relative references
+static void write_obj(const std::filesystem::path &path)
+{
+    std::string text = "# vertex colors\n"
+        "v 0 0 0 1 0 0\n"
+        "v 1 0 0 0 1 0\n"
+        "v 1 1 0 0 0 1\n"
+        "v 0 1 0 0.5\n";
+
+    // Pushes the faces past the first parse chunk
+    const std::string padding = "# " + std::string(97, 'x') + "\n";
+    while (text.size() < 1100 * 1024)
+        text += padding;
+
+    text += "f -4 -3 -2 -1\n" // quad, fan triangulated
+        "f 1/1/1 2/2/2 3/3/3\n"
+        "f 1 2 99\n" // out of range
+        "f 0 1 2\n"; // OBJ references start at 1
+    write_file(path, text.data(), text.size());
+}
+
+// Strided float positions, normalized u8 colors and 7 u16 indices, plus primitives whose
+// accessors exceed their view or whose view exceeds the buffer
+static void write_gltf(const std::filesystem::path &path, const std::filesystem::path &buffer_name)
+{
+    u8 buffer[96] = {};
+    const float positions[4][3] = { { 0.0f, 0.0f, 0.0f }, { 2.0f, 0.0f, 0.0f }, { 2.0f, 3.0f, 0.0f }, { 0.0f, 3.0f, 1.0f } };
+    for (u32 i = 0; i < 4; ++i)
+        std::memcpy(buffer + i * 16, positions[i], sizeof(positions[i])); // 4 bytes of padding each
+
+    const u8 colors[4][4] = { { 255, 0, 0, 255 }, { 0, 255, 0, 255 }, { 0, 0, 255, 255 }, { 51, 102, 153, 255 } };
+    std::memcpy(buffer + 64, colors, sizeof(colors));
+
+    const u16 indices[7] = { 0, 1, 2, 0, 2, 3, 1 };
+    std::memcpy(buffer + 80, indices, sizeof(indices));
+    write_file(path.parent_path() / buffer_name, buffer, sizeof(buffer));
+
+    const std::string json = R"({
+        "asset": { "version": "2.0" },
+        "buffers": [ { "uri": ")" + buffer_name.string() + R"(", "byteLength": 96 } ],
+        "bufferViews": [
+            { "buffer": 0, "byteOffset": 0, "byteLength": 64, "byteStride": 16 },
+            { "buffer": 0, "byteOffset": 64, "byteLength": 16 },
+            { "buffer": 0, "byteOffset": 80, "byteLength": 14 },
+            { "buffer": 0, "byteOffset": 0, "byteLength": 8 },
+            { "buffer": 0, "byteOffset": 90, "byteLength": 100 }
+        ],
+        "accessors": [
+            { "bufferView": 0, "componentType": 5126, "type": "VEC3", "count": 4, "min": [0, 0, 0], "max": [2, 3, 1] },
+            { "bufferView": 1, "componentType": 5121, "type": "VEC4", "count": 4, "normalized": true },
+            { "bufferView": 2, "componentType": 5123, "type": "SCALAR", "count": 7 },
+            { "bufferView": 3, "componentType": 5126, "type": "VEC3", "count": 4 },
+            { "bufferView": 4, "componentType": 5126, "type": "VEC3", "count": 1 }
+        ],
+        "meshes": [ { "name": "quad", "primitives": [
+            { "attributes": { "POSITION": 0, "COLOR_0": 1 }, "indices": 2 },
+            { "attributes": { "POSITION": 3 } },
+            { "attributes": { "POSITION": 4 } }
+        ] } ]
+    })";
+    write_file(path, json.data(), json.size());
+}
+
+static void check_obj(std::vector<MeshData> &meshes)
+{
+    CHECK(meshes.size() == 1);
+    if (meshes.size() != 1)
+        return;
+
+    const MeshData &mesh = meshes[0];
+    CHECK(mesh.positions.size() == 4);
+    CHECK(mesh.colors.size() == 4);
+    if (mesh.positions.size() == 4 && mesh.colors.size() == 4)
+    {
+        CHECK(near(mesh.positions[2], glm::vec3(1.0f, 1.0f, 0.0f)));
+        CHECK(near(mesh.colors[0], glm::vec3(1.0f, 0.0f, 0.0f)));
+        CHECK(near(mesh.colors[2], glm::vec3(0.0f, 0.0f, 1.0f)));
+        CHECK(near(mesh.colors[3], glm::vec3(1.0f))); // incomplete colors are white
+    }
+
+    const std::vector<u32> expected = { 0, 1, 2, 0, 2, 3, 0, 1, 2, 0, 1, 0, 0, 0, 1 };
+    CHECK(mesh.indices == expected);
+}
+
+static void check_gltf(std::vector<MeshData> &meshes)
+{
+    // Only the first primitive has valid accessors
+    CHECK(meshes.size() == 1);
+    if (meshes.size() != 1)
+        return;
+
+    const MeshData &mesh = meshes[0];
+    CHECK(mesh.name == "quad[0]");
+    CHECK(mesh.positions.size() == 4);
+    CHECK(mesh.colors.size() == 4);
+    if (mesh.positions.size() == 4 && mesh.colors.size() == 4)
+    {
+        CHECK(near(mesh.positions[1], glm::vec3(2.0f, 0.0f, 0.0f)));
+        CHECK(near(mesh.positions[3], glm::vec3(0.0f, 3.0f, 1.0f)));
+        CHECK(near(mesh.colors[1], glm::vec3(0.0f, 1.0f, 0.0f)));
+        CHECK(near(mesh.colors[3], glm::vec3(0.2f, 0.4f, 0.6f)));
+    }
+
+    // The trailing index that does not form a triangle is dropped
+    const std::vector<u32> expected = { 0, 1, 2, 0, 2, 3 };
+    CHECK(mesh.indices == expected);
+}
+
+int main()
+{
+    const std::filesystem::path obj_path = "mesh_importer_test.obj";
+    const std::filesystem::path gltf_path = "mesh_importer_test.gltf";
+    write_obj(obj_path);
+    write_gltf(gltf_path, "mesh_importer_test.bin");
+
+    MeshImporter importer;
+    {
+        MeshDataImportSink sink;
+        CHECK(importer.import(obj_path, sink));
+        check_obj(sink.get_meshes());
+    }
+
+    {
+        MeshDataImportSink sink;
+        CHECK(importer.import(gltf_path, sink));
+        check_gltf(sink.get_meshes());
+    }
+
+    // A sink that runs out of room gets the jobs it refused mapped again after a flush
+    {
+        LimitedImportSink sink(2);
+        CHECK(importer.import(obj_path, sink));
+        CHECK(sink.get_refusal_count() > 0);
+        check_obj(sink.get_meshes());
+    }
+
+    {
+        LimitedImportSink sink(1);
+        CHECK(importer.import(gltf_path, sink));
+        CHECK(sink.get_refusal_count() > 0);
+        CHECK(sink.get_flush_count() >= 3);
+        check_gltf(sink.get_meshes());
+    }
+
+    // Without room for a single job the import fails instead of flushing forever
+    {
+        LimitedImportSink sink(0);
+        CHECK(!importer.import(gltf_path, sink));
+    }
+
+    return test_result();
+}
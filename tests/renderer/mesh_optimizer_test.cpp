@@ -0,0 +1,90 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "renderer/mesh_optimizer.hpp"
+
+#include "test.hpp"
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+static constexpr u32 GRID_SIZE = 100; // quads per side
+
+// Quads in scanline order, the worst case a FIFO cache shorter than a row sees in practice
+static std::vector<u32> make_grid_indices()
+{
+    std::vector<u32> indices;
+    indices.reserve(GRID_SIZE * GRID_SIZE * 6);
+    for (u32 y = 0; y < GRID_SIZE; ++y)
+    {
+        for (u32 x = 0; x < GRID_SIZE; ++x)
+        {
+            const u32 v = y * (GRID_SIZE + 1) + x;
+            indices.insert(indices.end(), { v, v + 1, v + GRID_SIZE + 2, v, v + GRID_SIZE + 2, v + GRID_SIZE + 1 });
+        }
+    }
+    return indices;
+}
+
+// Triangles rotated so their smallest index comes first, sorted, so orders can be compared
+static std::vector<std::array<u32, 3>> get_sorted_triangles(const std::vector<u32> &indices)
+{
+    std::vector<std::array<u32, 3>> triangles;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        std::array<u32, 3> triangle = { indices[i], indices[i + 1], indices[i + 2] };
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+static void check_optimized(std::vector<u32> indices, float max_acmr)
+{
+    const u32 vertex_count = (GRID_SIZE + 1) * (GRID_SIZE + 1);
+    const u32 index_count = static_cast<u32>(indices.size());
+    const MeshOptimizerStats before = analyze_mesh(indices.data(), index_count, vertex_count);
+
+    const std::vector<std::array<u32, 3>> triangles = get_sorted_triangles(indices);
+    std::vector<u32> cluster_starts;
+    optimize_vertex_cache(indices.data(), index_count, vertex_count, &cluster_starts);
+    const MeshOptimizerStats after = analyze_mesh(indices.data(), index_count, vertex_count);
+
+    // Same triangles with the same winding, only their order changes
+    CHECK(get_sorted_triangles(indices) == triangles);
+    CHECK(!cluster_starts.empty() && cluster_starts[0] == 0);
+    CHECK(std::is_sorted(cluster_starts.begin(), cluster_starts.end()));
+
+    CHECK(after.acmr < before.acmr);
+    CHECK(after.acmr <= max_acmr);
+    CHECK(after.atvr <= before.atvr);
+}
+
+int main()
+{
+    // Every vertex is shared by 6 triangles, so 0.5 is the bound of an infinite cache. A 16 entry
+    // FIFO gets within ~25% of it, scanline order stays near 1.
+    std::vector<u32> indices = make_grid_indices();
+    const MeshOptimizerStats scanline = analyze_mesh(indices.data(), static_cast<u32>(indices.size()), (GRID_SIZE + 1) * (GRID_SIZE + 1));
+    CHECK(scanline.acmr > 0.95f);
+    check_optimized(indices, 0.65f);
+
+    // Shuffled triangles start with almost every vertex transformed again
+    std::mt19937 random(1234);
+    const u32 triangle_count = static_cast<u32>(indices.size() / 3);
+    for (u32 t = triangle_count - 1; t > 0; --t)
+    {
+        const u32 other = static_cast<u32>(random() % (t + 1));
+        std::swap_ranges(indices.begin() + t * 3, indices.begin() + t * 3 + 3, indices.begin() + other * 3);
+    }
+    check_optimized(indices, 0.65f);
+
+    // Nothing to do, but nothing to break either
+    std::vector<u32> cluster_starts = { 5 };
+    optimize_vertex_cache(nullptr, 0, 0, &cluster_starts);
+    CHECK(cluster_starts.empty());
+    CHECK(analyze_mesh(nullptr, 0, 0).acmr == 0.0f);
+
+    return test_result();
+}
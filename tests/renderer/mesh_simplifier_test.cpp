@@ -0,0 +1,199 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "renderer/mesh_simplifier.hpp"
+
+#include "test.hpp"
+
+#include <cmath>
+#include <unordered_map>
+
+static constexpr u32 GRID_SIZE = 64; // quads per side
+
+// Gently curved height field over [0, GRID_SIZE]^2. With split_colors the right half gets another
+// color and its own copies of the middle column, an attribute seam.
+static MeshData make_grid(bool split_colors)
+{
+    MeshData mesh;
+    mesh.name = "grid";
+    auto add_vertex = [&mesh](u32 x, u32 y, const glm::vec3 &color)
+    {
+        const float height = 0.5f * std::sin(x * 0.2f) * std::cos(y * 0.15f);
+        mesh.positions.push_back(glm::vec3(static_cast<float>(x), static_cast<float>(y), height));
+        mesh.colors.push_back(color);
+        return static_cast<u32>(mesh.positions.size() - 1);
+    };
+
+    const u32 seam = GRID_SIZE / 2;
+    std::vector<u32> left(GRID_SIZE + 1);
+    std::vector<u32> right(GRID_SIZE + 1);
+    std::vector<u32> vertices((GRID_SIZE + 1) * (GRID_SIZE + 1));
+    for (u32 y = 0; y <= GRID_SIZE; ++y)
+    {
+        for (u32 x = 0; x <= GRID_SIZE; ++x)
+            vertices[y * (GRID_SIZE + 1) + x] = add_vertex(x, y, glm::vec3(0.8f, 0.2f, 0.2f));
+        left[y] = vertices[y * (GRID_SIZE + 1) + seam];
+        right[y] = split_colors ? add_vertex(seam, y, glm::vec3(0.2f, 0.2f, 0.8f)) : left[y];
+    }
+
+    auto get_vertex = [&](u32 x, u32 y, bool right_half)
+    {
+        return x == seam && right_half ? right[y] : vertices[y * (GRID_SIZE + 1) + x];
+    };
+
+    for (u32 y = 0; y < GRID_SIZE; ++y)
+    {
+        for (u32 x = 0; x < GRID_SIZE; ++x)
+        {
+            const bool right_half = x >= seam;
+            const u32 a = get_vertex(x, y, right_half);
+            const u32 b = get_vertex(x + 1, y, right_half);
+            const u32 c = get_vertex(x + 1, y + 1, right_half);
+            const u32 d = get_vertex(x, y + 1, right_half);
+            mesh.indices.insert(mesh.indices.end(), { a, b, c, a, c, d });
+        }
+    }
+    return mesh;
+}
+
+static bool is_on_outline(const glm::vec3 &position)
+{
+    const float size = static_cast<float>(GRID_SIZE);
+    return position.x == 0.0f || position.y == 0.0f || position.x == size || position.y == size;
+}
+
+static bool is_on_same_side(const glm::vec3 &a, const glm::vec3 &b)
+{
+    const float size = static_cast<float>(GRID_SIZE);
+    return (a.x == 0.0f && b.x == 0.0f) || (a.y == 0.0f && b.y == 0.0f) || (a.x == size && b.x == size) || (a.y == size && b.y == size);
+}
+
+static void check_lods(const MeshData &mesh, u32 original_index_count)
+{
+    CHECK(mesh.lods.size() > 2 && mesh.lods.size() <= MESH_MAX_LOD_COUNT);
+    if (mesh.lods.empty())
+        return;
+
+    // LOD 0 is the untouched input
+    CHECK(mesh.lods[0].first_index == 0 && mesh.lods[0].index_count == original_index_count);
+    CHECK(mesh.lods[0].error == 0.0f);
+
+    for (size_t i = 1; i < mesh.lods.size(); ++i)
+    {
+        const MeshLod &previous = mesh.lods[i - 1];
+        const MeshLod &lod = mesh.lods[i];
+        CHECK(lod.first_index == previous.first_index + previous.index_count);
+        CHECK(lod.index_count % 3 == 0 && lod.index_count > 0);
+        CHECK(lod.error >= previous.error);
+
+        // Every level but the last reaches the reduction, the last saves at least a tenth
+        const float reduction = i + 1 < mesh.lods.size() ? MESH_LOD_REDUCTION : 0.9f;
+        CHECK(lod.index_count / 3 <= static_cast<u32>(previous.index_count / 3 * reduction));
+    }
+    CHECK(mesh.lods.back().first_index + mesh.lods.back().index_count == mesh.indices.size());
+}
+
+// The grid's outline and its projected area survive every level: open edges stay on the
+// outline, the corners stay and no triangle folds over
+static void check_borders(const MeshData &mesh)
+{
+    const float size = static_cast<float>(GRID_SIZE);
+    for (const MeshLod &lod : mesh.lods)
+    {
+        const u32 *indices = mesh.indices.data() + lod.first_index;
+        std::unordered_map<u64, u32> edge_uses;
+        std::vector<bool> referenced(mesh.get_vertex_count(), false);
+        double area = 0.0;
+        bool folded = false;
+        for (u32 i = 0; i < lod.index_count; i += 3)
+        {
+            const glm::vec3 &a = mesh.positions[indices[i]];
+            const glm::vec3 &b = mesh.positions[indices[i + 1]];
+            const glm::vec3 &c = mesh.positions[indices[i + 2]];
+            const double signed_area = 0.5 * ((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y));
+            folded = folded || signed_area < -1e-6;
+            area += signed_area;
+
+            for (u32 k = 0; k < 3; ++k)
+            {
+                referenced[indices[i + k]] = true;
+                const glm::vec3 &p = mesh.positions[indices[i + k]];
+                const glm::vec3 &q = mesh.positions[indices[i + (k + 1) % 3]];
+                // Keyed by grid coordinates, the seam's copies are one edge
+                const u32 p_key = static_cast<u32>(p.y) * (GRID_SIZE + 1) + static_cast<u32>(p.x);
+                const u32 q_key = static_cast<u32>(q.y) * (GRID_SIZE + 1) + static_cast<u32>(q.x);
+                ++edge_uses[(static_cast<u64>(std::min(p_key, q_key)) << 32) | std::max(p_key, q_key)];
+            }
+        }
+
+        CHECK(!folded);
+        CHECK(std::abs(area - size * size) < 1e-3);
+
+        bool outline_kept = true;
+        for (const auto &[key, uses] : edge_uses)
+        {
+            if (uses != 1)
+                continue;
+            const glm::vec3 a(static_cast<float>((key >> 32) % (GRID_SIZE + 1)), static_cast<float>((key >> 32) / (GRID_SIZE + 1)), 0.0f);
+            const glm::vec3 b(static_cast<float>((key & 0xFFFFFFFF) % (GRID_SIZE + 1)), static_cast<float>((key & 0xFFFFFFFF) / (GRID_SIZE + 1)), 0.0f);
+            outline_kept = outline_kept && is_on_outline(a) && is_on_same_side(a, b);
+        }
+        CHECK(outline_kept);
+
+        u32 corner_count = 0;
+        for (u32 v = 0; v < mesh.get_vertex_count(); ++v)
+        {
+            const glm::vec3 &p = mesh.positions[v];
+            corner_count += referenced[v] && (p.x == 0.0f || p.x == size) && (p.y == 0.0f || p.y == size);
+        }
+        CHECK(corner_count == 4);
+    }
+}
+
+// Both copies of every seam vertex stay in every level, the seam never opens
+static void check_seam(const MeshData &mesh)
+{
+    const float seam = static_cast<float>(GRID_SIZE / 2);
+    for (const MeshLod &lod : mesh.lods)
+    {
+        std::vector<bool> referenced(mesh.get_vertex_count(), false);
+        for (u32 i = 0; i < lod.index_count; ++i)
+            referenced[mesh.indices[lod.first_index + i]] = true;
+
+        u32 seam_vertex_count = 0;
+        for (u32 v = 0; v < mesh.get_vertex_count(); ++v)
+        {
+            if (mesh.positions[v].x != seam)
+                continue;
+            ++seam_vertex_count;
+            CHECK(referenced[v]);
+        }
+        CHECK(seam_vertex_count == 2 * (GRID_SIZE + 1));
+    }
+}
+
+int main()
+{
+    MeshData grid = make_grid(false);
+    const u32 index_count = static_cast<u32>(grid.indices.size());
+    const std::vector<u32> original = grid.indices;
+    build_lods(grid);
+    CHECK(std::equal(original.begin(), original.end(), grid.indices.begin()));
+    check_lods(grid, index_count);
+    check_borders(grid);
+
+    MeshData seamed = make_grid(true);
+    build_lods(seamed);
+    check_lods(seamed, index_count);
+    check_borders(seamed);
+    check_seam(seamed);
+
+    // Too small to simplify, LOD 0 only
+    MeshData quad;
+    quad.positions = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } };
+    quad.colors.assign(4, glm::vec3(1.0f));
+    quad.indices = { 0, 1, 2, 0, 2, 3 };
+    build_lods(quad);
+    CHECK(quad.lods.size() == 1 && quad.indices.size() == 6);
+
+    return test_result();
+}
@@ -0,0 +1,69 @@
+// Copyright 2025, Evangelion Manuhutu
+
+#include "renderer/render_queue.hpp"
+
+#include "test.hpp"
+
+#include <algorithm>
+#include <random>
+
+static void test_radix_sort_matches_stable_sort()
+{
+    // Few distinct values per byte, so equal keys and skipped passes both occur
+    std::mt19937_64 random(7);
+    std::vector<DrawSortItem> items(5000);
+    for (u32 i = 0; i < items.size(); ++i)
+    {
+        const u64 key = (random() & 0x0F0F00000000FF03ull) | ((random() % 3) << 40);
+        items[i] = { key, i };
+    }
+
+    std::vector<DrawSortItem> expected = items;
+    std::stable_sort(expected.begin(), expected.end(), [](const DrawSortItem &a, const DrawSortItem &b) { return a.key < b.key; });
+
+    std::vector<DrawSortItem> scratch;
+    radix_sort(items, scratch);
+    CHECK(items.size() == expected.size());
+    for (size_t i = 0; i < items.size(); ++i)
+        CHECK(items[i].key == expected[i].key && items[i].index == expected[i].index);
+}
+
+static void test_radix_sort_edge_cases()
+{
+    std::vector<DrawSortItem> scratch;
+    std::vector<DrawSortItem> empty;
+    radix_sort(empty, scratch);
+    CHECK(empty.empty());
+
+    // Every pass is skipped, the order must stay as submitted
+    std::vector<DrawSortItem> equal = { { 42, 0 }, { 42, 1 }, { 42, 2 } };
+    radix_sort(equal, scratch);
+    CHECK(equal[0].index == 0 && equal[1].index == 1 && equal[2].index == 2);
+
+    std::vector<DrawSortItem> extremes = { { ~0ull, 0 }, { 0, 1 }, { 1ull << 63, 2 } };
+    radix_sort(extremes, scratch);
+    CHECK(extremes[0].index == 1 && extremes[1].index == 2 && extremes[2].index == 0);
+}
+
+static void test_sort_key_order()
+{
+    // Opaque: state first, then front to back
+    CHECK(make_opaque_sort_key(0, 1, 0, 0, 100.0f) < make_opaque_sort_key(0, 2, 0, 0, 1.0f));
+    CHECK(make_opaque_sort_key(0, 1, 2, 3, 1.0f) < make_opaque_sort_key(0, 1, 2, 3, 2.0f));
+    CHECK(make_opaque_sort_key(0, 1, 2, 3, 0.5f) < make_opaque_sort_key(0, 1, 2, 3, 50.0f));
+    CHECK(make_opaque_sort_key(0, 1, 2, 3, -1.0f) == make_opaque_sort_key(0, 1, 2, 3, 0.0f));
+
+    // Translucent: back to front before state
+    CHECK(make_translucent_sort_key(1, 5, 0, 0, 10.0f) < make_translucent_sort_key(1, 1, 0, 0, 2.0f));
+
+    // Passes order before anything else
+    CHECK(make_opaque_sort_key(0, 0xFFF, 0xFFFF, 0xFFF, 1000.0f) < make_translucent_sort_key(1, 0, 0, 0, 1000.0f));
+}
+
+int main()
+{
+    test_radix_sort_matches_stable_sort();
+    test_radix_sort_edge_cases();
+    test_sort_key_order();
+    return test_result();
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#include "renderer/vertex.hpp"
+
+#include "test.hpp"
+
+#include <random>
+
+// Rounding to the nearest step is off by at most half a step, plus float rounding of the decode
+static float get_position_tolerance(const VertexQuantization &quantization, u32 axis)
+{
+    const float magnitude = std::abs(quantization.offset[axis]) + std::abs(quantization.scale[axis]);
+    return 0.5f * quantization.scale[axis] / 65535.0f + magnitude * 1e-6f;
+}
+
+static void test_position_round_trip(const glm::vec3 &min, const glm::vec3 &max)
+{
+    const VertexQuantization quantization = make_vertex_quantization(min, max);
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<glm::vec3> positions = { min, max, (min + max) * 0.5f };
+    for (u32 i = 0; i < 10000; ++i)
+        positions.push_back(min + (max - min) * glm::vec3(unit(random), unit(random), unit(random)));
+
+    for (const glm::vec3 &position : positions)
+    {
+        const PackedPosition packed = encode_position(position, quantization);
+        const glm::vec3 decoded = decode_position(packed, quantization);
+        for (u32 axis = 0; axis < 3; ++axis)
+            CHECK(std::abs(decoded[axis] - position[axis]) <= get_position_tolerance(quantization, axis));
+
+        // Decoding lands on a step, encoding it again has to give the same step
+        const PackedPosition repacked = encode_position(decoded, quantization);
+        CHECK(repacked.x == packed.x && repacked.y == packed.y && repacked.z == packed.z);
+    }
+
+    // The bounds use the full range
+    const PackedPosition lower = encode_position(min, quantization);
+    const PackedPosition upper = encode_position(max, quantization);
+    CHECK(lower.x == 0 && lower.y == 0 && lower.z == 0);
+    CHECK(max.x == min.x || upper.x == 65535);
+    CHECK(max.y == min.y || upper.y == 65535);
+    CHECK(max.z == min.z || upper.z == 65535);
+}
+
+static void test_color_round_trip()
+{
+    // Every unorm8 step survives exactly
+    for (u32 value = 0; value < 256; ++value)
+    {
+        const PackedColor packed = encode_color(glm::vec3(static_cast<float>(value) / 255.0f));
+        CHECK(packed.r == value && packed.g == value && packed.b == value && packed.a == 255);
+    }
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (u32 i = 0; i < 10000; ++i)
+    {
+        const glm::vec3 color(unit(random), unit(random), unit(random));
+        const glm::vec3 decoded = decode_color(encode_color(color));
+        for (u32 channel = 0; channel < 3; ++channel)
+            CHECK(std::abs(decoded[channel] - color[channel]) <= 0.5f / 255.0f + 1e-6f);
+    }
+
+    // HDR and negative colors clamp instead of wrapping
+    const PackedColor clamped = encode_color(glm::vec3(4.0f, -1.0f, 1.0f));
+    CHECK(clamped.r == 255 && clamped.g == 0 && clamped.b == 255);
+}
+
+int main()
+{
+    test_position_round_trip(glm::vec3(-1.0f), glm::vec3(1.0f));
+    test_position_round_trip(glm::vec3(-250.0f, 3.0f, 1000.0f), glm::vec3(750.0f, 3.5f, 1000.25f));
+
+    // A flat mesh keeps a usable scale on its degenerate axis
+    test_position_round_trip(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(10.0f, 2.0f, 10.0f));
+    CHECK(make_vertex_quantization(glm::vec3(0.0f), glm::vec3(0.0f)).scale.y > 0.0f);
+
+    test_color_round_trip();
+    return test_result();
+}
@@ -0,0 +1,31 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+#ifndef TEST_HPP
+#define TEST_HPP
+
+#include <cstdio>
+
+// Minimal checks for the unit tests. Every test is its own executable, a failed CHECK reports
+// and the test keeps going, main returns test_result() so ctest sees the failures.
+inline int &test_failure_count()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)\
+    do {\
+        if (!(condition)) {\
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);\
+            ++test_failure_count();\
+        }\
+    } while(0)
+
+inline int test_result()
+{
+    if (test_failure_count() > 0)
+        std::fprintf(stderr, "%d check(s) failed\n", test_failure_count());
+    return test_failure_count() > 0 ? 1 : 0;
+}
+
+#endif
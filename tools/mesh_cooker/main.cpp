@@ -0,0 +1,226 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+// Cooks mesh sources (glTF, OBJ) into mesh archives, one per source file. Run from the
+// directory that contains res/. Sources whose archive is newer are skipped unless --force is
+// given. Returns non-zero when any source fails, so it can run as a build step.
+
+#include "core/logger.hpp"
+#include "core/thread_pool.hpp"
+
+#include "renderer/mesh_archive.hpp"
+#include "renderer/mesh_data.hpp"
+#include "renderer/mesh_importer.hpp"
+#include "renderer/mesh_optimizer.hpp"
+#include "renderer/mesh_simplifier.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <unordered_map>
+
+struct CookOptions
+{
+    std::filesystem::path input = "res/models";
+    std::filesystem::path output_directory = "res/meshes";
+    u32 jobs = 0;
+    bool force = false;
+};
+
+static void print_usage()
+{
+    std::printf(
+        "Usage: MeshCooker [options]\n"
+        "  --input <path>      mesh source file or directory (default res/models)\n"
+        "  --output <dir>      directory the .mesh archives are written to, mirroring the input tree (default res/meshes)\n"
+        "  --jobs <n>          worker threads (default hardware threads - 1)\n"
+        "  --force             cook sources even when their archive is up to date\n"
+        "  --help              show this message\n");
+}
+
+static bool parse_options(i32 argc, char **argv, CookOptions &options)
+{
+    for (i32 i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--input") == 0 && has_value)
+            options.input = argv[++i];
+        else if (std::strcmp(arg, "--output") == 0 && has_value)
+            options.output_directory = argv[++i];
+        else if (std::strcmp(arg, "--force") == 0)
+            options.force = true;
+        else if (std::strcmp(arg, "--jobs") == 0 && has_value)
+        {
+            const char *value = argv[++i];
+            const auto [ptr, ec] = std::from_chars(value, value + std::strlen(value), options.jobs);
+            if (ec != std::errc() || *ptr != '\0')
+            {
+                std::fprintf(stderr, "Invalid job count '%s'\n", value);
+                return false;
+            }
+        }
+        else
+        {
+            if (std::strcmp(arg, "--help") != 0)
+                std::fprintf(stderr, "Unknown or incomplete option '%s'\n", arg);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool is_mesh_source(const std::filesystem::path &path)
+{
+    const std::string extension = path.extension().string();
+    return extension == ".glb" || extension == ".gltf" || extension == ".obj";
+}
+
+static bool is_archive_current(const std::filesystem::path &source, const std::filesystem::path &archive)
+{
+    std::error_code ec;
+    if (!std::filesystem::exists(archive, ec))
+        return false;
+    return std::filesystem::last_write_time(archive, ec) >= std::filesystem::last_write_time(source, ec) && !ec;
+}
+
+static bool cook_file(const std::filesystem::path &source, const std::filesystem::path &archive_path, ThreadPool &pool)
+{
+    MeshDataImportSink sink;
+    if (!MeshImporter(&pool).import(source, sink))
+        return false;
+
+    // Meshes are independent from here on. LODs are simplified from the imported triangles,
+    // meshlets are built after optimization so they follow the cache friendly triangle order.
+    std::vector<MeshData> &meshes = sink.get_meshes();
+    std::vector<MeshOptimizerStats> before(meshes.size());
+    std::vector<MeshOptimizerStats> after(meshes.size());
+    pool.parallel_for(static_cast<u32>(meshes.size()), [&meshes, &before, &after](u32 begin, u32 end)
+    {
+        for (u32 i = begin; i < end; ++i)
+        {
+            MeshData &mesh = meshes[i];
+            if (mesh.positions.empty())
+                continue;
+            before[i] = analyze_mesh(mesh.indices.data(), static_cast<u32>(mesh.indices.size()), mesh.get_vertex_count());
+            build_lods(mesh);
+            optimize_mesh(mesh);
+            after[i] = analyze_mesh(mesh.indices.data(), mesh.lods[0].index_count, mesh.get_vertex_count());
+            build_meshlets(mesh);
+        }
+    });
+
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        if (meshes[i].positions.empty())
+            continue;
+        Logger::get_instance().push_message(LoggingLevel::Info, "[MeshCooker] {}: {} LODs, ACMR {} -> {}, ATVR {} -> {}, overfetch {} -> {}",
+            meshes[i].name, meshes[i].lods.size(), std::format("{:.3f}", before[i].acmr), std::format("{:.3f}", after[i].acmr),
+            std::format("{:.3f}", before[i].atvr), std::format("{:.3f}", after[i].atvr),
+            std::format("{:.3f}", before[i].overfetch), std::format("{:.3f}", after[i].overfetch));
+    }
+
+    MeshArchiveWriter writer;
+    u64 vertex_count = 0;
+    u64 meshlet_count = 0;
+    for (MeshData &mesh : meshes)
+    {
+        // Meshes the importer skipped leave empty slots
+        if (mesh.positions.empty())
+            continue;
+        vertex_count += mesh.get_vertex_count();
+        meshlet_count += mesh.meshlets.size();
+        writer.add(std::move(mesh));
+    }
+
+    if (!writer.write(archive_path))
+        return false;
+
+    Logger::get_instance().push_message(LoggingLevel::Info, "[MeshCooker] {} -> {} ({} meshes, {} vertices, {} meshlets)",
+        source.string(), archive_path.string(), writer.get_mesh_count(), vertex_count, meshlet_count);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    CookOptions options;
+    if (!parse_options(argc, argv, options))
+    {
+        print_usage();
+        return 2;
+    }
+
+    std::vector<std::filesystem::path> sources;
+    std::error_code ec;
+    if (std::filesystem::is_directory(options.input, ec))
+    {
+        for (const auto &entry : std::filesystem::recursive_directory_iterator(options.input, ec))
+        {
+            if (entry.is_regular_file() && is_mesh_source(entry.path()))
+                sources.push_back(entry.path().lexically_normal());
+        }
+    }
+    else if (is_mesh_source(options.input))
+    {
+        sources.push_back(options.input.lexically_normal());
+    }
+
+    if (ec || sources.empty())
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[MeshCooker] No mesh sources found in {}", options.input.string());
+        return 1;
+    }
+
+    // Deterministic order so identical inputs produce identical logs
+    std::sort(sources.begin(), sources.end());
+
+    // Archives mirror the sources' paths below the input directory. Sources that still map to
+    // the same archive, like tree.obj next to tree.glb, fail instead of overwriting each other.
+    const std::filesystem::path input_root = std::filesystem::is_directory(options.input)
+        ? options.input.lexically_normal() : options.input.lexically_normal().parent_path();
+    std::unordered_map<std::string, std::filesystem::path> archive_sources;
+
+    // Files are cooked one after another, each import already spreads over every worker
+    ThreadPool pool(options.jobs);
+    u32 failed = 0;
+    u32 cooked = 0;
+    for (const std::filesystem::path &source : sources)
+    {
+        std::filesystem::path archive_path = (options.output_directory / source.lexically_relative(input_root)).lexically_normal();
+        archive_path.replace_extension(".mesh");
+
+        const auto [it, inserted] = archive_sources.try_emplace(archive_path.generic_string(), source);
+        if (!inserted)
+        {
+            Logger::get_instance().push_message(LoggingLevel::Error, "[MeshCooker] {} and {} both cook to {}",
+                it->second.string(), source.string(), archive_path.string());
+            ++failed;
+            continue;
+        }
+
+        if (!options.force && is_archive_current(source, archive_path))
+            continue;
+
+        std::filesystem::create_directories(archive_path.parent_path(), ec);
+
+        if (!cook_file(source, archive_path, pool))
+        {
+            Logger::get_instance().push_message(LoggingLevel::Error, "[MeshCooker] Failed {}", source.string());
+            ++failed;
+            continue;
+        }
+        ++cooked;
+    }
+
+    if (failed > 0)
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[MeshCooker] {} of {} sources failed", failed, sources.size());
+        return 1;
+    }
+
+    Logger::get_instance().push_message(LoggingLevel::Info, "[MeshCooker] Cooked {} of {} sources on {} threads",
+        cooked, sources.size(), pool.get_thread_count());
+    return 0;
+}
@@ -0,0 +1,253 @@
+// Copyright (c) 2025, Evangelion Manuhutu
+
+// Cooks every shader below a directory into a shader archive and the runtime shader cache.
+// Run from the directory that contains res/, archive and cache are keyed by the same
+// relative paths the engine loads shaders with. Returns non-zero when any shader fails,
+// so it can run as a build step.
+
+#include "core/logger.hpp"
+#include "core/thread_pool.hpp"
+
+#include "vulkan/shader_archive.hpp"
+#include "vulkan/shader_compiler.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+// Sources list their permutation keywords on a `#pragma shader_keywords A B C` line.
+// Every combination is cooked, so ShaderPermutationSet never has to compile at runtime.
+static constexpr u32 COOKER_MAX_KEYWORDS = 8;
+
+struct CookOptions
+{
+    std::filesystem::path input_directory = "res/shaders";
+    std::filesystem::path output_path = "res/shaders.pak";
+    std::filesystem::path cache_directory;
+    std::filesystem::path depfile_path;
+    u32 jobs = 0;
+    bool strip = true;
+    bool write_archive = true;
+};
+
+struct CookJob
+{
+    std::filesystem::path filepath;
+    VkShaderStageFlagBits stage;
+    std::vector<ShaderMacro> macros;
+};
+
+static void print_usage()
+{
+    std::printf(
+        "Usage: ShaderCooker [options]\n"
+        "  --input <dir>       shader source directory (default res/shaders)\n"
+        "  --output <file>     archive to write (default res/shaders.pak)\n"
+        "  --cache-dir <dir>   shader cache to fill (default res/cache/shaders)\n"
+        "  --cache-only        only fill the shader cache, do not write an archive\n"
+        "  --depfile <file>    write a Makefile style dependency file for the archive\n"
+        "  --jobs <n>          worker threads (default hardware threads - 1)\n"
+        "  --no-strip          keep names and source info in the SPIR-V\n"
+        "  --help              show this message\n");
+}
+
+static bool parse_options(i32 argc, char **argv, CookOptions &options)
+{
+    for (i32 i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--input") == 0 && has_value)
+            options.input_directory = argv[++i];
+        else if (std::strcmp(arg, "--output") == 0 && has_value)
+            options.output_path = argv[++i];
+        else if (std::strcmp(arg, "--cache-dir") == 0 && has_value)
+            options.cache_directory = argv[++i];
+        else if (std::strcmp(arg, "--depfile") == 0 && has_value)
+            options.depfile_path = argv[++i];
+        else if (std::strcmp(arg, "--cache-only") == 0)
+            options.write_archive = false;
+        else if (std::strcmp(arg, "--no-strip") == 0)
+            options.strip = false;
+        else if (std::strcmp(arg, "--jobs") == 0 && has_value)
+        {
+            const char *value = argv[++i];
+            const auto [ptr, ec] = std::from_chars(value, value + std::strlen(value), options.jobs);
+            if (ec != std::errc() || *ptr != '\0')
+            {
+                std::fprintf(stderr, "Invalid job count '%s'\n", value);
+                return false;
+            }
+        }
+        else
+        {
+            if (std::strcmp(arg, "--help") != 0)
+                std::fprintf(stderr, "Unknown or incomplete option '%s'\n", arg);
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::vector<std::string> parse_keywords(const std::filesystem::path &filepath)
+{
+    std::vector<std::string> keywords;
+    std::istringstream source(ShaderCompiler::read_file(filepath));
+    std::string line;
+    while (std::getline(source, line))
+    {
+        std::istringstream tokens(line);
+        std::string directive, pragma;
+        tokens >> directive >> pragma;
+        if (directive != "#pragma" || pragma != "shader_keywords")
+            continue;
+
+        std::string keyword;
+        while (tokens >> keyword)
+            keywords.push_back(keyword);
+    }
+    return keywords;
+}
+
+static void add_jobs(const std::filesystem::path &filepath, VkShaderStageFlagBits stage, std::vector<CookJob> &jobs)
+{
+    const std::vector<std::string> keywords = parse_keywords(filepath);
+    if (keywords.size() > COOKER_MAX_KEYWORDS)
+    {
+        Logger::get_instance().push_message(LoggingLevel::Warning, "[ShaderCooker] {} declares {} keywords, only the first {} are cooked",
+            filepath.string(), keywords.size(), COOKER_MAX_KEYWORDS);
+    }
+
+    // Same macro values ShaderPermutationSet uses, so the archive keys match
+    const u32 keyword_count = std::min<u32>(static_cast<u32>(keywords.size()), COOKER_MAX_KEYWORDS);
+    for (u32 mask = 0; mask < (1u << keyword_count); ++mask)
+    {
+        CookJob job = { filepath, stage, {} };
+        for (u32 i = 0; i < keyword_count; ++i)
+        {
+            if (mask & (1u << i))
+                job.macros.push_back({ keywords[i], "1" });
+        }
+        jobs.push_back(std::move(job));
+    }
+}
+
+static bool write_depfile(const std::filesystem::path &path, const std::filesystem::path &target, const std::vector<CookJob> &jobs,
+    const std::vector<ShaderCompileResult> &results)
+{
+    std::vector<std::string> inputs;
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        inputs.push_back(jobs[i].filepath.generic_string());
+        for (const auto &dependency : results[i].dependencies)
+            inputs.push_back(dependency.generic_string());
+    }
+    std::sort(inputs.begin(), inputs.end());
+    inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    file << target.generic_string() << ":";
+    for (const std::string &input : inputs)
+        file << " \\\n  " << input;
+    file << "\n";
+    return file.good();
+}
+
+int main(int argc, char **argv)
+{
+    CookOptions options;
+    if (!parse_options(argc, argv, options))
+    {
+        print_usage();
+        return 2;
+    }
+
+    if (!options.cache_directory.empty())
+        ShaderCompiler::set_cache_directory(options.cache_directory);
+
+    std::vector<CookJob> jobs;
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(options.input_directory, ec))
+    {
+        VkShaderStageFlagBits stage;
+        if (entry.is_regular_file() && ShaderCompiler::get_stage_from_extension(entry.path(), stage))
+            add_jobs(entry.path().lexically_normal(), stage, jobs);
+    }
+
+    if (ec || jobs.empty())
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[ShaderCooker] No shaders found in {}", options.input_directory.string());
+        return 1;
+    }
+
+    // Deterministic order so identical inputs produce identical logs
+    std::stable_sort(jobs.begin(), jobs.end(), [](const CookJob &a, const CookJob &b) { return a.filepath < b.filepath; });
+
+    // Compiling, reflecting and stripping are independent per shader
+    ThreadPool pool(options.jobs);
+    std::vector<ShaderCompileResult> results(jobs.size());
+    pool.parallel_for(static_cast<u32>(jobs.size()), [&](u32 begin, u32 end)
+    {
+        for (u32 i = begin; i < end; ++i)
+        {
+            ShaderCompileResult &result = results[i];
+            result = ShaderCompiler::compile(jobs[i].filepath, jobs[i].stage, jobs[i].macros);
+            if (result.code.empty() || !options.strip)
+                continue;
+
+            const size_t original_size = result.code.size();
+            result.code = ShaderCompiler::strip_debug_info(result.code);
+            if (result.code.size() != original_size)
+                ShaderCompiler::store_cache_entry(result);
+        }
+    });
+
+    ShaderArchiveWriter writer;
+    u32 failed = 0;
+    size_t total_size = 0;
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        const ShaderCompileResult &result = results[i];
+        if (result.code.empty())
+        {
+            Logger::get_instance().push_message(LoggingLevel::Error, "[ShaderCooker] Failed {}", jobs[i].filepath.string());
+            ++failed;
+            continue;
+        }
+
+        total_size += result.code.size() * sizeof(u32);
+
+        ShaderArchiveMetadata metadata;
+        metadata.filepath = jobs[i].filepath;
+        metadata.macros = jobs[i].macros;
+        metadata.dependencies = result.dependencies;
+        metadata.reflection = result.reflection;
+        writer.add(metadata, jobs[i].stage, result.code);
+    }
+
+    if (failed > 0)
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[ShaderCooker] {} of {} shaders failed", failed, jobs.size());
+        return 1;
+    }
+
+    if (options.write_archive && !writer.write(options.output_path))
+        return 1;
+
+    if (!options.depfile_path.empty() && !write_depfile(options.depfile_path, options.output_path, jobs, results))
+    {
+        Logger::get_instance().push_message(LoggingLevel::Error, "[ShaderCooker] Could not write {}", options.depfile_path.string());
+        return 1;
+    }
+
+    Logger::get_instance().push_message(LoggingLevel::Info, "[ShaderCooker] Cooked {} shaders ({} bytes of SPIR-V) on {} threads{}",
+        jobs.size(), total_size, pool.get_thread_count(), options.write_archive ? " into " + options.output_path.string() : std::string());
+    return 0;
+}